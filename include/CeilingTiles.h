@@ -25,7 +25,7 @@ public:
 
     CeilingTiles(float roomLength, float roomWidth, float roomHeight, int rows, int cols);
 
-    void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(Shader &shader, glm::mat4 model);
     void Delete();
 
 private:
@@ -0,0 +1,61 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "constants.h"
+
+class TubeLight;
+
+// Camera and lighting shared by every shader program, in one std140 uniform
+// buffer bound at a fixed binding point. Shaders declare the FrameData block
+// (the layout of Block below) and Shader connects any program that uses it to
+// `binding` at link time, so the render loop writes the frame's values once
+// instead of setting view, projection and the lights in each program. GL
+// thread only.
+class FrameUniforms
+{
+public:
+    static const GLuint binding = 0;
+    static constexpr const char *blockName = "FrameData";
+
+    // Mirrors FrameData under std140: vec3 members and array elements start
+    // on 16 bytes, and a float may fill the vec3 before it
+    struct Block
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 lightPos[ceilingTiles::numLights];
+        glm::vec3 tubeCenter;
+        float tubeLength;
+        glm::vec3 tubeAxis;
+        float tubeRadius;
+        glm::vec3 lightColor;
+        float padding0;
+        glm::vec3 viewPos;
+        float padding1;
+    };
+
+    FrameUniforms();
+
+    FrameUniforms(const FrameUniforms &) = delete;
+    FrameUniforms &operator=(const FrameUniforms &) = delete;
+
+    void SetCamera(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos);
+    void SetLights(const glm::vec3 *positions, const TubeLight &tubeLight, const glm::vec3 &color);
+
+    // Writes the block if it changed since the last upload; call before the
+    // frame's first draw
+    void Upload();
+
+    void Delete();
+
+private:
+    GLuint buffer;
+    Block block;
+    Block uploaded;
+    bool valid;
+};
+
+#endif
@@ -28,7 +28,7 @@ public:
     static Furniture createPodium(float width, float height, float depth);
     static Furniture createBoard(float width, float height, float thickness);
 
-    void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(Shader &shader, glm::mat4 model);
     void Delete();
 
 private:
@@ -0,0 +1,75 @@
+#ifndef KTXFILE_H
+#define KTXFILE_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Baked texture in the KTX 1.1 container: a GL format description followed
+// by every mip level, ready to hand to glTexImage2D/glCompressedTexImage2D.
+// tools/texture_bake writes "<image>.ktx" next to each source image with the
+// levels already filtered (and optionally block compressed), so loading one
+// needs neither an image decode nor glGenerateMipmap.
+//
+// Layout (native endianness, the only kind written or accepted):
+//   header      12-byte identifier, endianness, glType, glTypeSize, glFormat,
+//               glInternalFormat, glBaseInternalFormat, width, height, depth
+//               (0), array elements (0), faces (1), mip levels, key/value bytes
+//   key/value   size-prefixed "key\0value" pairs, each padded to 4 bytes;
+//               the bake stores the source image's content hash under
+//               sourceHashKey
+//   level       image size, then the level's data padded to 4 bytes;
+//               uncompressed rows are padded to 4 bytes as well
+class KtxFile
+{
+public:
+    static const char *const sourceHashKey;
+
+    struct Level
+    {
+        const char *data;
+        uint32_t size;
+        int width, height;
+    };
+
+    GLenum type;           // 0 for compressed formats
+    GLenum format;         // 0 for compressed formats
+    GLenum internalFormat;
+    GLenum baseFormat;     // GL_RED, GL_RGB or GL_RGBA
+    int width, height;
+    std::vector<Level> levels;
+
+    bool Compressed() const { return type == 0; }
+    // Channels of the base format
+    int Channels() const;
+    size_t TotalBytes() const;
+
+    // "<image>.ktx" for an image path; .ktx paths unchanged
+    static std::string BakedPath(const char *imagePath);
+
+    // Maps and validates a baked file. When sourcePath differs from path and
+    // still exists, the stored hash must match its contents. Returns null if
+    // the file is missing, malformed or stale.
+    static KtxFile *Open(const char *path, const char *sourcePath);
+
+    // Writes a 2D texture; levels[0] is the full size, each next one halved
+    struct LevelData
+    {
+        std::vector<unsigned char> bytes;
+        int width, height;
+    };
+    static bool Write(const char *path, GLenum type, GLenum format, GLenum internalFormat, GLenum baseFormat,
+                      const std::vector<LevelData> &levels, uint64_t sourceHash);
+
+    void Delete();
+
+private:
+    MappedFile *file;
+
+    KtxFile() : type(0), format(0), internalFormat(0), baseFormat(0), width(0), height(0), file(nullptr) {}
+};
+
+#endif
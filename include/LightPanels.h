@@ -33,7 +33,7 @@ public:
 
     LightPanels(float roomLength, float roomWidth, float roomHeight, int rows, int cols, LightPanelPositions lightsPos[], int numLights);
 
-    void Draw(glm::mat4 model, glm::mat4 view, glm::mat4 projection); 
+    void Draw(glm::mat4 model); 
     void Delete();
 
 private:
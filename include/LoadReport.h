@@ -0,0 +1,120 @@
+#ifndef LOADREPORT_H
+#define LOADREPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Time spent in each load phase and the size of what was loaded, per asset
+// (OBJ, MTL or image file), collected from the loader and worker threads and
+// written out as JSON. GL phases are CPU-side submission time; the driver may
+// finish the work later.
+//
+// Quiet mode turns off the loaders' per-asset console lines; errors are still
+// printed. Detailed mode additionally splits the serial OBJ parse into
+// tokenize, triangulate and dedup, which costs a few clock reads per face.
+class LoadReport
+{
+public:
+    enum Phase
+    {
+        FILE_READ,   // open and map the file
+        PARSE,       // whole OBJ parse, including the three phases below
+        TOKENIZE,    // reading lines into numbers and face corners
+        TRIANGULATE, // fanning quads and n-gons into triangles
+        DEDUP,       // merging identical corners into shared vertices
+        MTL_PARSE,
+        CACHE_READ,  // mesh cache validation and read
+        NORMALS,     // generated normals for meshes without vn
+        TANGENTS,
+        OPTIMIZE,    // vertex cache / overdraw / fetch reordering
+        LOD,
+        IMAGE_DECODE,
+        MIPMAP,
+        GL_UPLOAD,
+        PHASE_COUNT
+    };
+
+    struct Asset
+    {
+        std::string path;
+        std::string kind;
+        size_t loads;
+        double ms[PHASE_COUNT];
+        bool timed[PHASE_COUNT];
+        size_t vertices;
+        size_t indices;
+        size_t fileBytes;
+        size_t gpuBytes;
+    };
+
+    // Adds the time from construction to Stop() (or destruction) to a phase,
+    // leaving out stretches between Pause() and Resume()
+    class Timer
+    {
+    public:
+        Timer(const std::string &path, const char *kind, Phase phase);
+        ~Timer() { Stop(); }
+
+        void Pause();
+        void Resume();
+        void Stop();
+
+    private:
+        std::string path;
+        const char *kind;
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration elapsed;
+        bool running;
+        bool stopped;
+    };
+
+    LoadReport() : quiet(false), detailed(false) {}
+
+    LoadReport(const LoadReport &) = delete;
+    LoadReport &operator=(const LoadReport &) = delete;
+
+    static const char *PhaseName(Phase phase);
+
+    bool Quiet() const { return quiet; }
+    void SetQuiet(bool value) { quiet = value; }
+    bool Detailed() const { return detailed; }
+    void SetDetailed(bool value) { detailed = value; }
+
+    void AddTime(const std::string &path, const char *kind, Phase phase, double ms);
+    // Counts add up over the asset's loads, so re-loads show in the totals
+    void AddCounts(const std::string &path, const char *kind, size_t vertices, size_t indices, size_t fileBytes,
+                   size_t gpuBytes);
+    // Starts a new load of the asset
+    void CountLoad(const std::string &path, const char *kind);
+
+    std::vector<Asset> Assets();
+    std::string ToJSON();
+    bool WriteJSON(const char *path);
+    void Reset();
+
+    // Process-wide report
+    static LoadReport &Shared();
+
+    static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    bool quiet;
+    bool detailed;
+
+    std::mutex mutex;
+    // Assets in first-seen order
+    std::vector<Asset> assets;
+    std::map<std::string, size_t> assetIndex;
+
+    Asset &asset(const std::string &path, const char *kind);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object goes out of scope, so callers can tokenize the contents in place.
+class MappedFile
+{
+public:
+    const char *data;
+    size_t size;
+
+    MappedFile(const char *path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool IsOpen() const { return data != nullptr || isEmpty; }
+
+    // 64-bit hash of the contents; not cryptographic, only meant to notice
+    // edited source files cheaply
+    uint64_t ContentHash() const;
+    // The same hash over any bytes
+    static uint64_t Hash(const void *data, size_t size);
+
+    // Drops the resident pages before `upTo` once a sequential reader is done with them
+    void Release(const char *upTo);
+
+    void Close();
+
+private:
+    bool isEmpty;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef OVERDRAWMETER_H
+#define OVERDRAWMETER_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+#include "shaderClass.h"
+
+// Counts fragment shader invocations per pixel. Geometry drawn with `shader`
+// between Begin() and End() goes into an offscreen target with additive
+// blending and the normal depth test, so each pixel ends up holding how many
+// fragments survived early-Z there (saturating at 255). Works the same under
+// a software GL implementation, which is how the counts are meant to be
+// compared between runs.
+class OverdrawMeter
+{
+public:
+    struct Stats
+    {
+        size_t fragments;
+        size_t pixels;
+
+        // Shaded fragments per covered pixel; 1.0 means no overdraw
+        double Ratio() const { return pixels ? double(fragments) / double(pixels) : 0.0; }
+    };
+
+    Shader shader;
+
+    OverdrawMeter(int width, int height);
+
+    void Begin();
+    Stats End();
+
+    // Copies the last count image to the default framebuffer; each extra
+    // fragment on a pixel makes it one step redder
+    void Show(int windowWidth, int windowHeight);
+
+    void Delete();
+
+private:
+    int width, height;
+    GLuint fbo, countTexture, depthBuffer;
+    GLint previousViewport[4];
+    GLint previousBlendSrc, previousBlendDst;
+    GLboolean blendWasEnabled;
+};
+
+#endif
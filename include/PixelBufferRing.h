@@ -0,0 +1,41 @@
+#ifndef PIXELBUFFERRING_H
+#define PIXELBUFFERRING_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Pixel unpack buffers that texture uploads are staged through. With pixels
+// in a buffer object, glTexImage2D only queues a copy the driver performs
+// asynchronously instead of reading client memory before it returns. Slots
+// are used round-robin and orphaned on every use, so staging never waits for
+// an earlier upload that is still reading its slot. GL thread only.
+class PixelBufferRing
+{
+public:
+    static const size_t slotCount = 4;
+
+    PixelBufferRing();
+
+    PixelBufferRing(const PixelBufferRing &) = delete;
+    PixelBufferRing &operator=(const PixelBufferRing &) = delete;
+
+    // Copies `bytes` of pixels into the next slot and leaves it bound to
+    // GL_PIXEL_UNPACK_BUFFER, so glTex*Image calls take nullptr (offset 0) as
+    // their data. Returns false, with nothing bound, if the copy failed; the
+    // caller then uploads from client memory.
+    bool Stage(const void *pixels, size_t bytes);
+
+    // Unbinds the staged slot once the upload calls are issued
+    void Unstage();
+
+    void Delete();
+
+    static PixelBufferRing &Shared();
+
+private:
+    GLuint buffers[slotCount];
+    size_t next;
+    bool created;
+};
+
+#endif
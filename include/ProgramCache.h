@@ -0,0 +1,61 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Linked shader programs saved with glGetProgramBinary, so later launches
+// skip compiling and linking GLSL. Each program is stored in
+// shaderCache::directory as "<key hash>.progbin". The key names the exact
+// sources handed to the compiler (so any #defines prepended to them count)
+// and the driver's vendor, renderer and version strings; a driver update or
+// an edited shader simply misses. Drivers may still reject a binary, in which
+// case the caller compiles as usual and saves over it. GL thread only.
+//
+// Layout (native endianness):
+//   header      magic "CLPB", format version, binary format, key length,
+//               binary length
+//   key         the full key, compared on load against hash collisions
+//   binary      what glGetProgramBinary returned
+class ProgramCache
+{
+public:
+    static const uint32_t version = 1;
+
+    struct Stats
+    {
+        size_t programs;
+        size_t loaded;   // from a cached binary
+        size_t rejected; // binaries the driver refused
+        double milliseconds;
+    };
+
+    // Whether the context has program binaries (GL 4.1 or
+    // ARB_get_program_binary) and the driver offers any format
+    static bool Supported();
+
+    static std::string Key(const std::string &vertexSource, const std::string &fragmentSource);
+
+    // Gives `program` the cached binary for key; false if there is none or
+    // the driver rejected it (counted in Stats), leaving the program to be
+    // linked from source
+    static bool Load(GLuint program, const std::string &key);
+    // Stores a linked program created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    static bool Save(GLuint program, const std::string &key);
+
+    // Removes every cached binary
+    static void Clear();
+
+    // Shader counts every program it creates and the time they took
+    static void Record(bool loaded, double milliseconds);
+    static Stats GetStats();
+    static void ResetStats();
+
+private:
+    static std::string path(const std::string &key);
+    static Stats &stats();
+};
+
+#endif
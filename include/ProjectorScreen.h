@@ -15,7 +15,7 @@ class ProjectorScreen
 {
 public:
     ProjectorScreen(float roomLength, float roomWidth, float roomHeight);
-    void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(Shader &shader, glm::mat4 model);
     void Update(float deltaTime); 
     void ToggleScreen();          
     void Delete();
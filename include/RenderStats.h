@@ -0,0 +1,29 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <cstddef>
+
+// GL calls issued by the Model draw path, counted at the call sites so the
+// cost of a frame can be compared between draw strategies without a GL
+// debugger. The render loop resets the frame counters.
+struct RenderStats
+{
+    size_t drawCalls;    // glDraw*/glMultiDraw*
+    size_t bindCalls;    // program, VAO and texture binds
+    size_t uniformCalls; // glUniform* and glGetUniformLocation
+    size_t otherCalls;   // remaining state changes and queries
+
+    RenderStats() : drawCalls(0), bindCalls(0), uniformCalls(0), otherCalls(0) {}
+
+    size_t Total() const { return drawCalls + bindCalls + uniformCalls + otherCalls; }
+    void Reset() { *this = RenderStats(); }
+
+    // Counters for the current frame
+    static RenderStats &Frame()
+    {
+        static RenderStats stats;
+        return stats;
+    }
+};
+
+#endif
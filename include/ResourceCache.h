@@ -0,0 +1,72 @@
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "Texture.h"
+#include "shaderClass.h"
+
+class Model;
+struct ModelLoadOptions;
+
+// Reference-counted GPU resources keyed by canonical file path (and, for
+// models, the load options), so every user of the same model, texture or
+// shader program shares one copy.
+// Acquire* returns the resident object (loading it on first use) and adds a
+// reference; Release drops one and frees the object with the last. Acquiring
+// and releasing are meant for the GL thread; the lookups are locked so
+// loader workers may ask what is already resident.
+class ResourceCache
+{
+public:
+    ResourceCache() {}
+
+    ResourceCache(const ResourceCache &) = delete;
+    ResourceCache &operator=(const ResourceCache &) = delete;
+
+    // Resolves "." and ".." and symlinks; the path unchanged if it does not exist
+    static std::string CanonicalPath(const char *path);
+
+    Texture *AcquireTexture(const char *path);
+    // Uploads an already decoded image, or shares the resident copy of
+    // image.path and leaves the image unused
+    Texture *AcquireTexture(const TextureImage &image);
+    bool HasTexture(const char *path);
+    void Release(Texture *texture);
+
+    Shader *AcquireShader(const char *vertexFile, const char *fragmentFile);
+    void Release(Shader *shader);
+
+    // Loads the model synchronously on first use
+    Model *AcquireModel(const char *objFile, const ModelLoadOptions &options);
+    // Shared model for objFile loaded with options of the same Key(); created
+    // empty (and `created` set) when new, for the caller to fill in, e.g. via
+    // ModelLoader
+    Model *ReserveModel(const char *objFile, const ModelLoadOptions &options, bool &created);
+    void Release(Model *model);
+
+    // Resident GPU bytes per kind and what separate copies for every
+    // reference would have needed on top
+    void Report();
+
+    // Process-wide cache
+    static ResourceCache &Shared();
+
+private:
+    template <typename T>
+    struct Entry
+    {
+        T *resource;
+        size_t references;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Entry<Texture>> textures;
+    std::map<std::string, Entry<Shader>> shaders;
+    std::map<std::string, Entry<Model>> models;
+};
+
+#endif
@@ -16,7 +16,7 @@ class RightWallWindows
 public:
     RightWallWindows(float roomLength, float roomWidth, float roomHeight);
 
-    void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(Shader &shader, glm::mat4 model);
 
     void Delete();
 
@@ -0,0 +1,49 @@
+#ifndef SCENECONFIG_H
+#define SCENECONFIG_H
+
+#include <cstddef>
+#include <string>
+
+// Command line settings of the classroom program. The scene size defaults to
+// include/constants.h; benchmarks can scale it past the shipped layout:
+//   --desks RxC         desk grid rows x columns
+//   --fans RxC          ceiling fan grid rows x columns
+//   --desk-model FILE   OBJ drawn for every desk (e.g. from tools/scene_gen)
+//   --fan-model FILE    OBJ drawn for every fan
+//   --load-report FILE  write the LoadReport JSON once every model is resident
+//   --texture-budget MB stream model textures within MB of video memory
+//                       (TextureStreamer.h); all levels resident without
+//   --quiet             no per-asset loader logging
+// The room is enlarged to fit the desk grid; never shrunk below room::*.
+struct SceneConfig
+{
+    int deskRows;
+    int deskCols;
+    int fanRows;
+    int fanCols;
+    std::string deskModel;
+    std::string fanModel;
+    std::string loadReportPath;
+    // 0 when textures do not stream
+    size_t textureBudgetMB;
+    bool quiet;
+
+    float roomLength;
+    float roomWidth;
+    float roomHeight;
+
+    SceneConfig();
+
+    int Fans() const { return fanRows * fanCols; }
+
+    // Returns false (after printing usage) on an unknown or malformed option
+    bool ParseArgs(int argc, char **argv);
+
+    // Distance the far plane needs to see the whole room from inside it
+    float ViewDistance() const;
+
+private:
+    void fitRoom();
+};
+
+#endif
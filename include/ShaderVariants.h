@@ -0,0 +1,56 @@
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shaderClass.h"
+
+// Specialized builds of one vertex/fragment pair. Each set of features is a
+// separate program compiled with the matching #defines, so the shaders pick
+// the surface's color and lighting terms at compile time instead of testing
+// uniforms or the fragment's position per fragment. Variants compile on
+// first use; Prepare() builds the known ones ahead of time (with the program
+// binary cache, a warm start loads them instead). GL thread only.
+class ShaderVariants
+{
+public:
+    // shaders/texture.frag: the diffuse source. No feature draws the
+    // material's color.
+    static const unsigned int TEXTURED = 1 << 0;      // 2D diffuse map
+    static const unsigned int TEXTURE_ARRAY = 1 << 1; // layer of a texture array
+    static const unsigned int WHITE_PLASTIC = 1 << 2; // plain white, ignoring the material
+    // shaders/default.frag: the room surface, exactly one of them
+    static const unsigned int FLOOR = 1 << 3;
+    static const unsigned int CEILING = 1 << 4;
+    static const unsigned int WALL = 1 << 5;
+    static const unsigned int BOARD = 1 << 6;
+    // shaders/texture.vert: model and normal matrix from per-instance
+    // attributes (Model::DrawInstanced) instead of uniforms
+    static const unsigned int INSTANCED = 1 << 7;
+    // With INSTANCED: each copy spins about its y axis by the time uniform
+    static const unsigned int SPINNING = 1 << 8;
+
+    ShaderVariants(const char *vertexFile, const char *fragmentFile);
+
+    ShaderVariants(const ShaderVariants &) = delete;
+    ShaderVariants &operator=(const ShaderVariants &) = delete;
+
+    // The variant built with exactly these features, compiled if needed
+    Shader &Get(unsigned int features);
+    void Prepare(const std::vector<unsigned int> &featureSets);
+
+    size_t Count() const { return variants.size(); }
+
+    void Delete();
+
+    // Names defined for a feature set, in bit order
+    static std::vector<std::string> Defines(unsigned int features);
+
+private:
+    std::string vertexFile, fragmentFile;
+    std::map<unsigned int, Shader *> variants;
+};
+
+#endif
@@ -3,6 +3,27 @@
 
 #include <GL/glew.h>
 #include <iostream>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+class KtxFile;
+
+// Decoded pixels of an image file, produced without touching GL so decoding
+// can run on a worker thread and the upload later on the GL thread
+struct TextureImage
+{
+    std::string path;
+    unsigned char *pixels;
+    int width, height, nrChannels;
+    // Set instead of pixels when a baked "<path>.ktx" is current (see
+    // KtxFile.h); its mip levels are uploaded straight from the mapping
+    KtxFile *baked;
+
+    TextureImage() : pixels(nullptr), width(0), height(0), nrChannels(0), baked(nullptr) {}
+
+    void Free();
+};
 
 class Texture
 {
@@ -10,10 +31,19 @@ public:
     GLuint ID;
     GLenum type;
     int width, height, nrChannels;
+    // Video memory of all levels; only the resident ones while streamed
+    size_t gpuBytes;
 
     Texture(const char *imagePath, GLenum texType = GL_TEXTURE_2D, GLint wrap = GL_REPEAT, GLint filter = GL_LINEAR);
+    Texture(const TextureImage &image, GLenum texType = GL_TEXTURE_2D, GLint wrap = GL_REPEAT, GLint filter = GL_LINEAR);
+
+    Texture() : ID(0), type(GL_TEXTURE_2D), width(0), height(0), nrChannels(0), gpuBytes(0) {}
+
+    // Thread-safe; the caller owns the result and must Free() it
+    static TextureImage Decode(const char *imagePath);
 
-    Texture() : ID(0), type(GL_TEXTURE_2D), width(0), height(0), nrChannels(0) {}
+    // Decodes every path on the pool, one image per entry in order
+    static std::vector<TextureImage> DecodeAll(const std::vector<std::string> &paths, ThreadPool &pool);
 
     void texUnit(unsigned int shader, const char *uniform, GLuint unit);
 
@@ -24,7 +54,8 @@ public:
     void Delete();
 
 private:
-    void loadTexture(const char *imagePath, GLenum texType, GLint wrap, GLint filter);
+    void upload(const TextureImage &image, GLenum texType, GLint wrap, GLint filter);
+    void uploadBaked(const TextureImage &image, GLenum texType);
 };
 
-#endif
\ No newline at end of file
+#endif
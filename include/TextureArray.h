@@ -0,0 +1,43 @@
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+
+// Images of one size and format as the layers of a GL_TEXTURE_2D_ARRAY.
+// Meshes textured from any layer draw without a texture bind in between;
+// each picks its layer with the texLayer uniform (see shaders/texture.frag).
+// Decoded images are stored as RGB8/RGBA8 with generated mipmaps; baked ones
+// (KtxFile.h) keep their own format and levels.
+class TextureArray
+{
+public:
+    GLuint ID;
+    int width, height, layers;
+    // Video memory of all layers and levels
+    size_t gpuBytes;
+
+    // Images that can share an array have equal keys; "" for images that
+    // failed to decode
+    static std::string CompatibilityKey(const TextureImage &image);
+
+    // GL thread. Uploads `images`, which must share one key, as layers
+    // 0..n-1 in order
+    TextureArray(const std::vector<const TextureImage *> &images, GLint wrap = GL_REPEAT, GLint filter = GL_LINEAR);
+
+    void Bind();
+
+    void Unbind();
+
+    void Delete();
+
+private:
+    void uploadDecoded(const std::vector<const TextureImage *> &images);
+    void uploadBaked(const std::vector<const TextureImage *> &images);
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Texture;
+class ThreadPool;
+struct TextureImage;
+
+// Keeps only the mip levels of each model texture that the view needs,
+// within a GPU memory budget. Once enabled, every texture starts with just
+// its levels of at most streaming::startSize texels. While drawing, Model
+// requests for each mesh the level at which one texel covers about one
+// pixel; Update() then loads the missing finer levels on the thread pool
+// (from the image file or its bake) and uploads them. When an upload does
+// not fit the budget, levels finer than their texture's current request are
+// evicted, least recently used texture first; textures out of view fall
+// back to their starting levels at most. Sampling is limited to the
+// resident levels by GL_TEXTURE_BASE_LEVEL, and evicted levels are
+// respecified empty so the driver releases them. GL thread only; the loads
+// it starts run on the pool.
+class TextureStreamer
+{
+public:
+    struct Stats
+    {
+        size_t textures;
+        size_t budgetBytes;
+        size_t residentBytes;
+        size_t peakResidentBytes;
+        // Textures requested in the last frame, and those of them whose
+        // resident level is at least as fine as requested
+        size_t texturesVisible;
+        size_t texturesAtTarget;
+        size_t loadsInFlight;
+        size_t levelsUploaded;
+        size_t bytesUploaded;
+        size_t levelsEvicted;
+    };
+
+    TextureStreamer();
+
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+    // Streams every texture uploaded from now on, loading on `pool`
+    void Enable(size_t budgetBytes, ThreadPool &pool);
+    bool Enabled() const { return pool != nullptr; }
+
+    // Uploads the starting levels of image into texture, which is bound to
+    // GL_TEXTURE_2D, and sets its size and gpuBytes
+    void Register(Texture &texture, const TextureImage &image);
+    void Unregister(const Texture &texture);
+
+    // Draw time: texelsPerPixel is how many level 0 texels fall on one
+    // pixel; the finest request of the frame wins
+    void Request(const Texture &texture, float texelsPerPixel);
+
+    // Once per frame, after drawing: takes the frame's requests as targets,
+    // uploads finished loads and starts new ones
+    void Update();
+
+    // Finest resident level and requested level; -1 for textures not streamed
+    int ResidentLevel(const Texture &texture) const;
+    int TargetLevel(const Texture &texture) const;
+    Stats GetStats() const;
+
+    // Budget use and every texture's resident and target level
+    void Report() const;
+
+    // Waits for outstanding loads and stops streaming; textures keep the
+    // levels they have
+    void Delete();
+
+    static TextureStreamer &Shared();
+
+private:
+    struct Level
+    {
+        int width, height;
+        size_t bytes;
+    };
+
+    struct Entry
+    {
+        unsigned long id;
+        Texture *texture;
+        std::string path;
+        bool baked;
+        GLenum internalFormat, format, type;
+        int channels;
+        std::vector<Level> levels;
+        // Coarsest uploaded level; never evicted
+        int startLevel;
+        int residentLevel;
+        int targetLevel;
+        // Finest level requested this frame; levels.size() for none
+        int requestedLevel;
+        unsigned long lastUsed;
+        // Frame before which no new load is started, after one did not fit
+        unsigned long retryFrame;
+        bool loading;
+        bool failed;
+    };
+
+    // Levels first..last of one texture, produced on a worker
+    struct Load
+    {
+        unsigned long id;
+        int first, last;
+        std::vector<std::vector<unsigned char>> data;
+    };
+
+    ThreadPool *pool;
+    size_t budgetBytes;
+    std::map<const Texture *, Entry> entries;
+    unsigned long nextId;
+    unsigned long frame;
+    Stats stats;
+
+    // Guards the loads handed back by workers
+    std::mutex mutex;
+    std::condition_variable loadFinished;
+    std::vector<Load> finished;
+    size_t inFlight;
+
+    static Load loadLevels(const Entry &entry, int first, int last);
+    void startLoad(Entry &entry);
+    void finishLoad(Load &load, size_t &uploadBytes);
+    void uploadLevel(const Entry &entry, int level, const void *data);
+    void setBaseLevel(Entry &entry, int level);
+    // Evicts levels of other entries until `bytes` more fit the budget
+    bool makeRoom(size_t bytes, const Entry &forEntry);
+    int evictableLevel(const Entry &entry) const;
+};
+
+#endif
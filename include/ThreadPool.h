@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of tasks.
+class ThreadPool
+{
+public:
+    // threadCount == 0 uses one worker per hardware thread
+    ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void Enqueue(std::function<void()> task);
+
+    // Runs fn(i) for every i in [0, count) and returns when all calls finished.
+    // The calling thread takes part, so this is safe to use from a worker.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    unsigned int Size() const { return workers.size(); }
+
+    // Process-wide pool shared by the loaders
+    static ThreadPool &Shared();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    void workerLoop();
+};
+
+#endif
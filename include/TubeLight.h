@@ -26,7 +26,7 @@ public:
 
     TubeLight(float roomLength, float roomWidth, float roomHeight);
 
-    void Draw(glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(glm::mat4 model);
     void Delete();
 
     glm::vec3 GetTubeCenter() const { return tubeCenter; }
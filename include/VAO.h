@@ -13,8 +13,10 @@ public:
 
     VAO();
 
-    void LinkVBOAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset);
+    void LinkVBOAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLboolean normalized = GL_FALSE);
     void LinkAttribWithAlpha(VBO &VBO);
+    // Attribute read once per instance (divisor 1) instead of per vertex
+    void LinkInstanceAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset);
 
     void Bind();
 
@@ -0,0 +1,72 @@
+#ifndef VERTEXPACKING_H
+#define VERTEXPACKING_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "VAO.h"
+#include "VBO.h"
+
+struct Vertex;
+
+// Compact vertex layouts and the conversions to and from them.
+//
+// PackedVertex (16 bytes, Model meshes; the float Vertex is 32):
+//   position   3 x unorm16 relative to the mesh bounds (+1 pad), rebuilt in
+//              the vertex shader from positionOffset/positionScale uniforms
+//   normal     2 x snorm16 octahedral encoding, decoded in the shader
+//   texCoords  2 x half float
+//
+// PackedColorVertex (24 bytes, procedural room geometry; 36/40 as floats):
+//   position   3 x float, world space so no per-draw dequantization is needed
+//   color      4 x half float, alpha in w (colors above 1 are kept for the
+//              emissive panels)
+//   normal     GL_INT_2_10_10_10_REV, read by the shaders as a plain vec3
+struct PackedVertex
+{
+    GLushort position[4];
+    GLshort normal[2];
+    GLushort texCoords[2];
+};
+
+struct PackedColorVertex
+{
+    GLfloat position[3];
+    GLushort color[4];
+    GLuint normal;
+};
+
+namespace VertexPacking
+{
+    GLushort FloatToHalf(float value);
+    float HalfToFloat(GLushort value);
+
+    void OctEncode(const glm::vec3 &normal, GLshort encoded[2]);
+    glm::vec3 OctDecode(const GLshort encoded[2]);
+
+    GLuint PackSnorm10(const glm::vec3 &normal);
+    glm::vec3 UnpackSnorm10(GLuint packed);
+
+    GLushort QuantizeUnorm16(float value, float offset, float scale);
+
+    // Packs Model vertices; offset/scale receive the position bounds the
+    // shader needs to undo the quantization
+    std::vector<PackedVertex> PackVertices(const Vertex *vertices, size_t count, glm::vec3 &offset, glm::vec3 &scale);
+    // Same with given bounds, e.g. those of a whole model sharing one buffer
+    std::vector<PackedVertex> PackVerticesInBounds(const Vertex *vertices, size_t count, const glm::vec3 &offset,
+                                                   const glm::vec3 &scale);
+    Vertex UnpackVertex(const PackedVertex &packed, const glm::vec3 &offset, const glm::vec3 &scale);
+
+    // data holds vertexCount vertices of `stride` floats: position, color,
+    // normal and, for stride 10, alpha (1 otherwise)
+    std::vector<PackedColorVertex> PackColorVertices(const GLfloat *data, size_t vertexCount, size_t stride);
+
+    // Creates the vertex buffer for the bound VAO from interleaved
+    // position/color/normal[/alpha] floats and links attributes 0-2 (and 3
+    // for stride 10), packed or as floats per vertexFormat::packed
+    VBO *CreateColorVertexBuffer(VAO &vao, const GLfloat *data, size_t vertexCount, size_t stride);
+}
+
+#endif
@@ -16,7 +16,7 @@ class Windows
 public:
     Windows(float roomLength, float roomWidth, float roomHeight, int numWindows = 8);
 
-    void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(Shader &shader, glm::mat4 model);
 
     void Delete();
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace window
 {
     static const int width = 1200;
@@ -19,6 +21,13 @@ namespace furniture
     static const int rows = 5;
     static const int cols = 5;
     static const float deskScale = 0.5f;
+    // Desk grid layout; the room grows to fit larger grids (SceneConfig)
+    static const float deskColSpacing = 5.0f;
+    static const float deskRowSpacing = 3.5f;
+    static const float benchWidth = 1.8f;
+    static const float backMargin = 2.5f;
+    static const float frontSpace = 5.0f;
+    static const float sideMargin = 2.1f;
     static const int fans = 6;
     static const int fanRows = 2;
     static const int fanCols = 3;
@@ -31,3 +40,53 @@ namespace ceilingTiles
     static const int cols = 15;
     static const int numLights = 2;
 }
+
+namespace loading
+{
+    // Main-thread time per frame spent uploading background-loaded models
+    static const double uploadBudgetMs = 4.0;
+}
+
+namespace vertexFormat
+{
+    // Upload Model meshes and room geometry in the compact layouts of
+    // VertexPacking.h instead of plain floats
+    static const bool packed = true;
+}
+
+
+namespace normals
+{
+    // Generated normals are smoothed across faces within this many degrees
+    // of each other and split into a hard edge beyond it
+    static const float creaseAngle = 60.0f;
+}
+
+namespace lod
+{
+    // Levels per mesh including the full one; each aims for `reduction` of the
+    // previous level's triangles
+    static const unsigned int levels = 4;
+    static const float reduction = 0.5f;
+    // Largest simplification error, as a fraction of the mesh's size
+    static const float maxError = 0.02f;
+    // Model::Draw uses the coarsest level whose error projects to at most
+    // this many pixels
+    static const float pixelError = 1.0f;
+}
+namespace streaming
+{
+    // With --texture-budget, textures start with their levels of at most this
+    // many texels a side and stream finer ones as the view needs them
+    static const int startSize = 64;
+    static const size_t maxLoadsInFlight = 4;
+    // Streamed level uploads per frame, on top of the model upload budget
+    static const size_t uploadBytesPerFrame = 16u << 20;
+    // Frames before a texture whose levels did not fit the budget tries again
+    static const unsigned long retryFrames = 30;
+}
+namespace shaderCache
+{
+    // Linked program binaries (ProgramCache), created on first use
+    static const char *directory = "shaders/cache";
+}
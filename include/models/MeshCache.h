@@ -0,0 +1,67 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Model;
+
+// Binary cache of a parsed Model, stored next to the OBJ as
+// "<file>.<flags><options key>.meshcache", so models loaded from one OBJ
+// with different options each keep their own.
+//
+// Layout (native endianness):
+//   header      magic "CLMC", format version, sizeof(Vertex), load flags,
+//               hash of the OBJ, dependency/material/mesh counts, options key
+//   dependency  path + content hash of every MTL the OBJ referenced
+//   material    name, Ka, Kd, Ks, Ns, resolved map_Kd path
+//   mesh        material index (-1 for none), vertex count, index count,
+//               then the raw Vertex and unsigned int arrays, then the LOD
+//               count, per level offset/count/error, the LOD indices, then
+//               the tangent count (0 or the vertex count) and vec4 tangents
+//
+// Each raw array starts at a multiple of sectionAlignment from the start of
+// the file, zero-padded after the strings and counts before it, so the
+// page-aligned mapping can be read through typed pointers.
+//
+// A cache is only used when the version, vertex layout, flags, options key and
+// every source hash match, so editing the OBJ or one of its MTL files invalidates it.
+class MeshCache
+{
+public:
+    static const uint32_t version = 4;
+    static const size_t sectionAlignment = 16;
+
+    // Load flags stored in the header; a cache only matches identical flags
+    enum Flags
+    {
+        OPTIMIZED_VERTEX_ORDER = 1,
+        OPTIMIZED_OVERDRAW = 2,
+        GENERATED_LODS = 4,
+        GENERATED_TANGENTS = 8
+    };
+
+    static std::string CachePath(const char *objFile, uint32_t flags, uint32_t optionsKey);
+
+    // Removes the OBJ's caches for every set of options
+    static void Clear(const char *objFile);
+
+    // Hash of a file's contents; 0 if it cannot be read
+    static uint64_t HashFile(const char *path);
+
+    // Fills model.meshes/materials from a valid cache. With `upload` the mapped
+    // vertex and index data go straight to GL and no CPU copy is kept; without
+    // it they are copied into the meshes and no GL call is made. Material
+    // textures are left to the caller. optionsKey identifies the normal and LOD
+    // settings the meshes were built with. Returns false on any mismatch.
+    static bool Load(const char *objFile, uint32_t flags, uint32_t optionsKey, Model &model, bool upload);
+
+    // Written to a temporary of its own and renamed, so concurrent loads of
+    // one OBJ never write the same file
+    static bool Save(const char *objFile, uint32_t flags, uint32_t optionsKey, const Model &model,
+                     const std::vector<std::string> &dependencies);
+};
+
+#endif
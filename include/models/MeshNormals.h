@@ -0,0 +1,46 @@
+#ifndef MESHNORMALS_H
+#define MESHNORMALS_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+class ThreadPool;
+
+// Generated vertex normals and tangents for indexed triangle lists. Both
+// passes keep their per-triangle and per-corner data in structure-of-arrays
+// form and split the work across the thread pool by triangle (or by shared
+// position) blocks; only the final vertex split is serial.
+namespace MeshNormals
+{
+    enum Weighting
+    {
+        // Face normals weighted by triangle area: large faces dominate
+        AREA_WEIGHTED,
+        // Weighted by the corner angle: independent of how a face is tessellated
+        ANGLE_WEIGHTED
+    };
+
+    // Gives every vertex whose Normal is zero a smooth normal: the weighted
+    // face normals of all triangles sharing its position (not just the
+    // vertex, so UV seams stay smooth) that lie within creaseAngle degrees of
+    // the corner's own face. Where one vertex ends up with different normals
+    // on different corners (a crease) it is split, appending vertices and
+    // renumbering those corners. Vertices with a normal are left alone.
+    // Returns the number of vertices that got a normal.
+    size_t GenerateNormals(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, float creaseAngle,
+                           Weighting weighting, ThreadPool &pool);
+
+    // Per-vertex tangents in MikkTSpace's convention: xyz is the tangent,
+    // orthogonal to the normal, and w the sign with which
+    // bitangent = w * cross(normal, tangent). Triangle tangents from the UV
+    // gradients are projected into each corner's normal plane and summed with
+    // corner-angle weights per vertex and handedness; vertices used with both
+    // handednesses (mirrored UVs) are split like MikkTSpace does. Corners
+    // with degenerate UVs get an arbitrary tangent perpendicular to the normal.
+    void GenerateTangents(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                          std::vector<glm::vec4> &tangents, ThreadPool &pool);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+
+// Post-load reordering of indexed triangle lists for the GPU's post-transform
+// vertex cache and for linear vertex fetches. Neither pass changes what is
+// drawn, only the order of triangles and vertices. Simplify() is the exception:
+// it builds the coarser index lists of a mesh's LOD chain.
+namespace MeshOptimizer
+{
+    // Vertex shader invocations per triangle (ACMR, 0.5 at best, 3 at worst)
+    // and per referenced vertex (ATVR, 1 at best), simulated with a FIFO cache
+    struct CacheStats
+    {
+        size_t triangles;
+        size_t vertices;
+        size_t transformed;
+        float acmr;
+        float atvr;
+    };
+
+    // FIFO size the statistics are measured with; typical of desktop GPUs
+    static const unsigned int statsCacheSize = 16;
+
+    CacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                  unsigned int cacheSize = statsCacheSize);
+
+    // Reorders triangles for cache reuse (Forsyth's linear-speed greedy scoring)
+    void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+
+    // Splits the (cache-optimized) triangle order into clusters and sorts the
+    // clusters outward-facing first, so from most viewpoints near surfaces are
+    // drawn before the ones they hide and early-Z rejects more fragments.
+    // Clusters only break where the cache ACMR stays within `threshold` of the
+    // input's, so vertex cache locality is mostly kept.
+    void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                          float threshold = 1.05f);
+
+    // Renumbers vertices in first-use order of the index buffer so fetches walk
+    // the vertex buffer forward; unreferenced vertices are dropped
+    void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // Quadric error metric edge collapse (Garland-Heckbert) down to about
+    // targetIndexCount indices, never moving a surface further than
+    // targetError from the input. Errors are relative to the largest extent of
+    // the mesh bounds. Vertices are collapsed onto existing neighbours, so the
+    // result indexes the same vertex buffer; vertices on open or attribute
+    // seam edges stay put so UV and normal seams do not tear. resultError, if
+    // given, receives the largest error actually introduced.
+    std::vector<unsigned int> Simplify(const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                       size_t targetIndexCount, float targetError, float *resultError = nullptr);
+}
+
+#endif
@@ -11,11 +11,18 @@
 #include <sstream>
 #include <map>
 
+#include "constants.h"
 #include "VAO.h"
 #include "VBO.h"
 #include "EBO.h"
 #include "Texture.h"
 #include "shaderClass.h"
+#include "ShaderVariants.h"
+#include "models/VertexIndexMap.h"
+#include "models/MeshNormals.h"
+
+class MappedFile;
+class TextureArray;
 
 struct Vertex
 {
@@ -32,25 +39,156 @@ struct Material
     glm::vec3 specular;  // Ks
     float shininess;     // Ns
     Texture *diffuseMap; // map_Kd
+    std::string diffuseMapPath;
+    // Instead of diffuseMap when the model packs its maps (see Model::PackTextures)
+    TextureArray *diffuseArray;
+    int diffuseLayer;
+
+    Material()
+        : ambient(1.0f), diffuse(0.8f), specular(0.5f), shininess(32.0f), diffuseMap(nullptr), diffuseArray(nullptr),
+          diffuseLayer(0) {}
+};
 
-    Material() : ambient(1.0f), diffuse(0.8f), specular(0.5f), shininess(32.0f), diffuseMap(nullptr) {}
+// One simplified level of a mesh; level 0 is always the full index list
+struct MeshLod
+{
+    // Range of the mesh's index buffer drawn at this level
+    size_t indexOffset;
+    size_t indexCount;
+    // Largest deviation from the full mesh, in model units
+    float error;
+};
+
+// Arrays a mesh is uploaded from: its own vectors or a mapped mesh cache
+struct MeshData
+{
+    const Vertex *vertices;
+    size_t vertexCount;
+    const unsigned int *indices;
+    size_t indexCount;
+    const unsigned int *lodIndices;
+    size_t lodIndexCount;
 };
 
 struct Mesh
 {
+    // CPU copies; empty for meshes uploaded straight from a mesh cache
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     Material *material;
 
-    VAO meshVAO;
+    // Coarser levels (1..n) share the vertices; their index lists are stored
+    // back to back in lodIndices and follow `indices` in the index buffer
+    std::vector<unsigned int> lodIndices;
+    std::vector<MeshLod> lods;
+
+    // Per-vertex tangents with the bitangent sign in w (see MeshNormals.h);
+    // empty unless ModelLoadOptions::generateTangents. Not uploaded yet.
+    std::vector<glm::vec4> tangents;
+
+    // Bounding sphere in model space, set on upload for LOD selection
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    // UV units per model unit, sqrt(UV area / surface area), set on upload
+    // of textured meshes while textures stream (see TextureStreamer.h)
+    float uvDensity;
+
+    // Set once the mesh's data is on the GPU, either in its own buffers or in
+    // its Model's merged ones
+    bool resident;
+
+    // GL objects, created by setupMesh() so meshes can be built off the GL
+    // thread; null for meshes in their Model's merged buffers
+    VAO *meshVAO;
     VBO *meshVBO;
     EBO *meshEBO;
+    GLsizei indexCount;
 
-    Mesh() : material(nullptr), meshVBO(nullptr), meshEBO(nullptr) {}
+    // Where the mesh starts in the index buffer (its `indices` then its
+    // lodIndices) and the vertex its indices count from; 0 for own buffers
+    size_t firstIndex;
+    GLint baseVertex;
 
+    // Upload format; see VertexPacking.h. Packed meshes store positions
+    // relative to their bounds and use 16-bit indices below 65536 vertices.
+    bool packed;
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    GLenum indexType;
+    // Vertex plus index buffer size
+    size_t bufferBytes;
+
+    Mesh()
+        : material(nullptr), boundsCenter(0.0f), boundsRadius(0.0f), uvDensity(0.0f), resident(false), meshVAO(nullptr),
+          meshVBO(nullptr), meshEBO(nullptr), indexCount(0), firstIndex(0), baseVertex(0),
+          packed(vertexFormat::packed), positionOffset(0.0f), positionScale(1.0f), indexType(GL_UNSIGNED_INT),
+          bufferBytes(0) {}
+
+    MeshData Data() const;
+
+    // Own VAO/VBO/EBO, for models not using merged buffers
     void setupMesh();
-    void Draw(Shader &shader);
+    void setupMesh(const MeshData &data);
+
+    size_t LevelCount() const { return lods.size() + 1; }
+    size_t TriangleCount(size_t level) const;
+    // Index range drawn at `level`, relative to firstIndex
+    void LevelRange(size_t level, size_t &first, size_t &count) const;
+
+    // Binds the material's texture or color for `shader`. With boundArray,
+    // a texture array already bound there is not bound again.
+    void ApplyMaterial(Shader &shader);
+    void ApplyMaterial(Shader &shader, const TextureArray *&boundArray);
+    // Variant of shaders/texture.* the material draws with (ShaderVariants)
+    unsigned int ShaderFeatures() const;
+
+    void Draw(Shader &shader, size_t level = 0);
     void Delete();
+
+private:
+    friend class Model;
+    void computeBounds(const MeshData &data);
+};
+
+struct ModelLoadOptions
+{
+    // Read/write the OBJ's mesh cache (MeshCache.h) so later launches skip
+    // OBJ/MTL parsing
+    bool useCache;
+    // OBJ parse chunks, parsed in parallel on ThreadPool::Shared(): 1 =
+    // serial, 0 = one per core for files above Model::parallelParseThreshold
+    unsigned int parseThreads;
+    // Give corners without a "vn" smooth normals (see MeshNormals.h) instead
+    // of a constant up vector; creaseAngle is in degrees
+    bool generateNormals;
+    float creaseAngle;
+    MeshNormals::Weighting normalWeighting;
+    // Per-vertex tangents into Mesh::tangents, after optimization
+    bool generateTangents;
+    // Reorder triangles and vertices for the GPU vertex cache after parsing
+    bool optimizeMeshes;
+    // With optimizeMeshes: also sort triangle clusters to cut overdraw
+    bool optimizeOverdraw;
+    // Build a simplified LOD chain per mesh (see constants.h lod::)
+    bool generateLods;
+    unsigned int lodLevels;
+    float lodReduction;
+    float lodMaxError;
+    // Upload all meshes into one vertex and one index buffer (see Model::Draw)
+    bool mergeBuffers;
+    // Pack the diffuse maps into texture arrays (see Model::PackTextures);
+    // ignored while textures stream, which needs them separate
+    bool textureArrays;
+
+    ModelLoadOptions()
+        : useCache(true), parseThreads(0), generateNormals(true), creaseAngle(normals::creaseAngle),
+          normalWeighting(MeshNormals::ANGLE_WEIGHTED), generateTangents(false), optimizeMeshes(true), optimizeOverdraw(true), generateLods(true),
+          lodLevels(lod::levels), lodReduction(lod::reduction), lodMaxError(lod::maxError), mergeBuffers(true),
+          textureArrays(true) {}
+
+    // The options that change the loaded model, as text: models loaded with
+    // the same key are interchangeable (see ResourceCache)
+    std::string Key() const;
 };
 
 class Model
@@ -59,18 +197,187 @@ public:
     std::vector<Mesh> meshes;
     std::map<std::string, Material *> materials;
 
-    Model(const char *objFile);
+    // Screen-space error Draw() accepts when picking a mesh's level; 0 always
+    // draws full detail
+    float lodPixelError;
+    // Triangles submitted by Draw() since the caller last reset it
+    size_t trianglesDrawn;
+
+    // Drawn with ShaderVariants: features added to every mesh's variant
+    // (WHITE_PLASTIC replaces the materials' maps and colors), and the
+    // specular strength of meshes drawn in their material's color
+    unsigned int shaderFeatures;
+    float untexturedSpecular;
+
+    // Merged buffers: every mesh is a range of these, so Draw() binds one VAO
+    // per model and draws each run of meshes sharing a material with one
+    // glMultiDrawElementsBaseVertex. Null when the model uses per-mesh buffers.
+    bool mergeBuffers;
+    VAO *modelVAO;
+    VBO *modelVBO;
+    EBO *modelEBO;
+    bool packed;
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    GLenum indexType;
+    size_t bufferBytes;
+
+    // Texture arrays: the materials' diffuse maps, grouped by size and format
+    // into one array each, so the meshes textured from a group draw with no
+    // texture bind in between. Owned by the model; empty when not used.
+    bool useTextureArrays;
+    std::vector<TextureArray *> textureArrays;
+
+    // Empty model, filled in later (see ModelLoader)
+    Model();
+    Model(const char *objFile, const ModelLoadOptions &options = ModelLoadOptions());
     Model(const char *objFile, const char *texturePath);
 
+    static const size_t parallelParseThreshold = 4 << 20;
+    // Instance buffers kept per model; another set replaces the oldest
+    static const size_t maxInstanceSets = 4;
+
+    // CPU half of loading: parses the OBJ/MTL (or reads the mesh cache) into
+    // meshes and materials without any GL call, so it can run on a worker
+    void Parse(const char *objFile, const ModelLoadOptions &options);
+
+    // GL half: creates material textures and uploads meshes not uploaded yet
+    void Upload();
+
+    // Merged upload in steps: AllocateBuffers() sizes the shared buffers for
+    // `data` (one entry per mesh, in order), then UploadMesh() fills in one
+    // mesh's range. Meshes draw as soon as their range is uploaded.
+    void AllocateBuffers(const std::vector<MeshData> &data);
+    void UploadMesh(size_t index, const MeshData &data);
+
+    // GL thread. Packs decoded diffuse maps of equal size and format into
+    // textureArrays and points the materials using them at their layers.
+    // Packed images are freed and removed; lone maps stay in `images` for
+    // the caller to upload as plain textures.
+    void PackTextures(std::vector<TextureImage> &images);
+
+    // Draws every mesh with `shader`, or with the variant of `variants` its
+    // material selects; programs only switch between meshes that need
+    // different variants
     void Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+    void Draw(ShaderVariants &variants, glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+
+    // Draws a copy of the model at each of `instances` with one instanced
+    // draw per mesh, using the INSTANCED variants: the transforms and their
+    // normal matrices go into a per-instance vertex buffer, rewritten only
+    // when they change. Each vector passed keeps its own buffer (up to
+    // maxInstanceSets), so callers sharing the model do not rewrite each
+    // other's. Each mesh draws at the level its nearest copy needs.
+    // Without merged buffers, and with a plain Shader, the copies are drawn
+    // one Draw() at a time.
+    void DrawInstanced(ShaderVariants &variants, const std::vector<glm::mat4> &instances, glm::mat4 view,
+                       glm::mat4 projection);
+    void DrawInstanced(Shader &shader, const std::vector<glm::mat4> &instances, glm::mat4 view,
+                       glm::mat4 projection);
+    // As above with each copy also spinning about its model-space y axis, as
+    // the ceiling fans do: spins[i] holds its turns per second and its phase
+    // in turns. The SPINNING variants turn the copies by `time` (seconds) in
+    // the vertex shader, so animation costs no CPU work per copy and leaves
+    // the instance buffer as uploaded. LOD and streaming use the unspun
+    // transforms.
+    void DrawInstanced(ShaderVariants &variants, const std::vector<glm::mat4> &instances,
+                       const std::vector<glm::vec2> &spins, float time, glm::mat4 view, glm::mat4 projection);
+    void DrawInstanced(Shader &shader, const std::vector<glm::mat4> &instances, const std::vector<glm::vec2> &spins,
+                       float time, glm::mat4 view, glm::mat4 projection);
+    // Whole seconds after which every one of `spins` has made whole turns,
+    // so callers can wrap the spin time at it (in double) without a jump
+    // and keep it small enough for float; an hour if no period under one
+    // exists, which costs one small jump an hour
+    static double SpinPeriod(const std::vector<glm::vec2> &spins);
     void Delete();
 
+    // Triangles per LOD level summed over meshes; meshes with a shorter chain
+    // count their coarsest level
+    std::vector<size_t> LodTriangleCounts() const;
+
+    // GPU vertex and index buffer bytes of the uploaded meshes
+    size_t BufferBytes() const;
+
 private:
-    void loadOBJ(const char *objFile);
+    // OBJ the model was loaded from, for the load report
+    std::string sourcePath;
+
+    // MTL files referenced by the OBJ, recorded as mesh cache dependencies
+    std::vector<std::string> mtlFiles;
+
+    // Mesh indices in draw order, grouped by material; and per-draw scratch
+    // arrays for the multi-draw batches
+    std::vector<size_t> drawOrder;
+    std::vector<GLsizei> batchCounts;
+    std::vector<const void *> batchOffsets;
+    std::vector<GLint> batchBaseVertices;
+    // Program current during Draw() and the transform it was given
+    Shader *currentProgram;
+    glm::mat4 drawTransform;
+
+    // Per-instance attributes of DrawInstanced() (locations 3-10 of the
+    // merged VAO)
+    struct Instance
+    {
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+        glm::vec2 spin; // zero for copies that do not spin
+    };
+    // One caller's instances as last uploaded, identified by the address of
+    // its transform vector; the buffer holds `capacity`
+    struct InstanceSet
+    {
+        const void *owner;
+        std::vector<Instance> instances;
+        VBO *buffer;
+        size_t capacity;
+    };
+    std::vector<InstanceSet> instanceSets;
+    // Set the VAO's instance attributes read; past the end for none
+    size_t linkedInstanceSet;
+    // Per-draw scratch: each instance's model-view matrix and scale
+    std::vector<glm::mat4> instanceModelViews;
+    std::vector<float> instanceScales;
+    // The time uniform of SPINNING variants during DrawInstanced()
+    float spinTime;
+
+    // Position of the material's texture array in textureArrays; past the end without one
+    size_t arrayIndex(const Material *material) const;
+    // drawOrder for the current materials and texture arrays
+    void sortDrawOrder();
+    void draw(ShaderVariants *variants, Shader *shader, const glm::mat4 &model, const glm::mat4 &view,
+              const glm::mat4 &projection);
+    void drawMerged(ShaderVariants *variants, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit);
+    // `spins` is null for copies that do not spin
+    void drawInstances(ShaderVariants &variants, const std::vector<glm::mat4> &transforms,
+                       const std::vector<glm::vec2> *spins, const glm::mat4 &view, const glm::mat4 &projection);
+    // Brings the set for `transforms` up to date and points the VAO at it
+    void uploadInstances(const std::vector<glm::mat4> &transforms, const std::vector<glm::vec2> *spins);
+    // Unbinds what drawMerged()/drawInstances() left bound after the VAO
+    void unbindMaterials(bool textureBound, const TextureArray *boundArray);
+    unsigned int variantFeatures(const Mesh &mesh) const;
+    // Makes `shader` current with the uniforms every mesh shares
+    void useProgram(Shader &shader);
+    void flushBatch();
+
+    void load(const char *objFile, const ModelLoadOptions &options);
+    void parseOBJ(const char *objFile, const ModelLoadOptions &options);
+    void generateNormals(const char *objFile, const ModelLoadOptions &options);
+    void optimizeMeshes(const char *objFile, const ModelLoadOptions &options);
+    void generateLods(const char *objFile, const ModelLoadOptions &options);
+    size_t selectLevel(const Mesh &mesh, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit) const;
+    void requestTexture(const Mesh &mesh, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit) const;
+    void loadTextures();
+    void loadOBJ(const char *objFile, unsigned int parseThreads);
+    void loadOBJParallel(const char *objFile, const MappedFile &file, const std::string &basePath,
+                         unsigned int chunkCount);
+    void switchMaterial(const std::string &materialName, Mesh &currentMesh, Material *&currentMaterial,
+                        VertexIndexMap &vertexMap);
+    void finishMesh(Mesh &currentMesh, Material *currentMaterial);
     void loadMTL(const std::string &mtlFile, const std::string &basePath);
-    void processVertex(const std::string &vertexStr, const std::vector<glm::vec3> &temp_vertices,
+    void processVertex(const FaceIndex &corner, const std::vector<glm::vec3> &temp_vertices,
                        const std::vector<glm::vec2> &temp_uvs, const std::vector<glm::vec3> &temp_normals,
-                       std::map<std::string, unsigned int> &vertexMap, Mesh &currentMesh);
+                       VertexIndexMap &vertexMap, Mesh &currentMesh);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "models/Model.h"
+#include "ThreadPool.h"
+
+// Loads models in the background. OBJ/MTL parsing (or the mesh cache read) and
+// texture decoding run on the thread pool; the GL uploads are queued and done
+// by the render thread in ProcessUploads(), a slice per frame, so the first
+// frame does not wait for every model.
+class ModelLoader
+{
+public:
+    ModelLoader(ThreadPool &pool = ThreadPool::Shared());
+
+    // Waits for running parse jobs; anything not uploaded yet is dropped
+    ~ModelLoader();
+
+    ModelLoader(const ModelLoader &) = delete;
+    ModelLoader &operator=(const ModelLoader &) = delete;
+
+    // Starts loading objFile into target, which must stay alive until Done().
+    // target draws nothing until its meshes arrive.
+    void Request(Model &target, const char *objFile, const ModelLoadOptions &options = ModelLoadOptions());
+
+    // Shared model for objFile from ResourceCache::Shared(), loaded in the
+    // background if nobody holds it yet. Give it back with
+    // ResourceCache::Shared().Release().
+    Model *Request(const char *objFile, const ModelLoadOptions &options = ModelLoadOptions());
+
+    // Render thread only. Uploads queued textures and meshes until budgetMs
+    // has been spent; at least one upload is made per call so loading always
+    // progresses. Returns the number of uploads made.
+    size_t ProcessUploads(double budgetMs);
+
+    // True once every requested model is fully resident
+    bool Done();
+
+private:
+    struct PendingModel
+    {
+        Model *target;
+        std::string path;
+        Model staged;
+        std::map<std::string, TextureImage> images;
+        std::map<std::string, Material *>::iterator nextMaterial;
+        size_t nextMesh;
+        bool started;
+        bool packed;
+    };
+
+    ThreadPool &pool;
+    std::mutex mutex;
+    std::condition_variable jobFinished;
+    std::deque<std::unique_ptr<PendingModel>> ready;
+    size_t inFlight;
+
+    void parse(PendingModel &pending, const ModelLoadOptions &options);
+    bool uploadNext(PendingModel &pending);
+    void release(PendingModel &pending);
+};
+
+#endif
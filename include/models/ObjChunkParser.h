@@ -0,0 +1,57 @@
+#ifndef OBJCHUNKPARSER_H
+#define OBJCHUNKPARSER_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "models/VertexIndexMap.h"
+
+// Records of one line-aligned slice of an OBJ file, parsed independently of
+// the other slices so several can be parsed at once.
+struct ObjChunk
+{
+    // "mtllib"/"usemtl" lines, kept in order with the triangle corner count
+    // reached when they appeared so the merge can replay them in place
+    struct Event
+    {
+        enum Type
+        {
+            MTLLIB,
+            USEMTL
+        } type;
+        std::string name;
+        size_t cornerOffset;
+    };
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+
+    // Fan-triangulated face corners, three per triangle. Positive OBJ indices
+    // are already 0-based; negative ones are relative to this chunk's own
+    // attribute counts and listed in relativeCorners for the merge to rebase.
+    std::vector<FaceIndex> corners;
+    std::vector<size_t> relativeCorners;
+    std::vector<uint8_t> relativeMasks;
+
+    std::vector<Event> events;
+};
+
+namespace ObjChunkParser
+{
+    enum RelativeMask
+    {
+        RELATIVE_V = 1,
+        RELATIVE_VT = 2,
+        RELATIVE_VN = 4
+    };
+
+    // Splits [data, data + size) into at most `count` ranges ending on line breaks
+    std::vector<std::pair<size_t, size_t>> SplitLines(const char *data, size_t size, size_t count);
+
+    void Parse(const char *begin, const char *end, ObjChunk &chunk);
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef OBJTOKENIZER_H
+#define OBJTOKENIZER_H
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#include "models/VertexIndexMap.h"
+
+// In-place tokenizer for OBJ/MTL text. Every helper works on a [cursor, end)
+// range of a memory-mapped buffer and advances the cursor; nothing allocates.
+namespace objtok
+{
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Pointer to the '\n' that terminates the line starting at p (or end)
+    inline const char *lineEnd(const char *p, const char *end)
+    {
+        const void *nl = memchr(p, '\n', end - p);
+        return nl ? static_cast<const char *>(nl) : end;
+    }
+
+    inline void skipSpaces(const char *&p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+            p++;
+    }
+
+    // Next whitespace separated token on the current line, empty at end of line
+    inline std::string_view nextToken(const char *&p, const char *end)
+    {
+        skipSpaces(p, end);
+        const char *start = p;
+        while (p < end && !isSpace(*p))
+            p++;
+        return std::string_view(start, p - start);
+    }
+
+    // Remainder of the line with surrounding whitespace trimmed
+    inline std::string_view restOfLine(const char *&p, const char *end)
+    {
+        skipSpaces(p, end);
+        const char *last = end;
+        while (last > p && isSpace(last[-1]))
+            last--;
+        std::string_view rest(p, last - p);
+        p = end;
+        return rest;
+    }
+
+    // Parses one float like `iss >> f`: on failure the value becomes 0 and the
+    // cursor is moved to the end of the line so later reads fail too.
+    inline bool parseFloat(const char *&p, const char *end, float &out)
+    {
+        skipSpaces(p, end);
+        if (p < end && *p == '+')
+            p++;
+        auto result = std::from_chars(p, end, out, std::chars_format::general);
+        if (result.ec != std::errc())
+        {
+            out = 0.0f;
+            p = end;
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    inline bool parseInt(const char *&p, const char *end, int &out)
+    {
+        if (p < end && *p == '+')
+            p++;
+        auto result = std::from_chars(p, end, out);
+        if (result.ec != std::errc())
+        {
+            out = 0;
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    // Converts a 1-based (or negative, relative) OBJ index to 0-based; -1 if absent
+    inline int resolveIndex(int index, size_t count)
+    {
+        if (index > 0)
+            return index - 1;
+        if (index < 0)
+            return (int)count + index;
+        return -1;
+    }
+
+    // Parses a face corner in any of the "v", "v/vt", "v//vn" or "v/vt/vn" forms
+    inline FaceIndex parseFaceIndex(std::string_view token, size_t vCount, size_t vtCount, size_t vnCount)
+    {
+        FaceIndex corner = {-1, -1, -1};
+        const char *p = token.data();
+        const char *end = p + token.size();
+        int value;
+
+        if (parseInt(p, end, value))
+            corner.v = resolveIndex(value, vCount);
+        if (p < end && *p == '/')
+        {
+            p++;
+            if (parseInt(p, end, value))
+                corner.vt = resolveIndex(value, vtCount);
+            if (p < end && *p == '/')
+            {
+                p++;
+                if (parseInt(p, end, value))
+                    corner.vn = resolveIndex(value, vnCount);
+            }
+        }
+        return corner;
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef VERTEXINDEXMAP_H
+#define VERTEXINDEXMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One face corner of an OBJ "f" record, resolved to 0-based indices.
+// -1 marks an attribute the corner does not reference ("v", "v/vt", "v//vn").
+struct FaceIndex
+{
+    int v;
+    int vt;
+    int vn;
+};
+
+// Flat open-addressing map from (v, vt, vn) to the mesh vertex created for it.
+// Clearing bumps a generation counter instead of touching the slots, so the
+// table can be sized once for the whole file and reused for every submesh.
+class VertexIndexMap
+{
+public:
+    VertexIndexMap() : mask(0), count(0), generation(1) {}
+
+    // Sizes the table for `expected` distinct corners without further growth
+    void Reserve(size_t expected);
+
+    void Clear()
+    {
+        count = 0;
+        generation++;
+    }
+
+    // Returns the stored index for `key`, or inserts `newIndex` and returns it.
+    // `inserted` tells the caller whether a new vertex must be emitted.
+    unsigned int FindOrInsert(const FaceIndex &key, unsigned int newIndex, bool &inserted)
+    {
+        if ((count + 1) * 2 > slots.size())
+            grow();
+
+        size_t i = hash(key) & mask;
+        while (true)
+        {
+            Slot &slot = slots[i];
+            if (slot.generation != generation)
+            {
+                slot.key = key;
+                slot.index = newIndex;
+                slot.generation = generation;
+                count++;
+                inserted = true;
+                return newIndex;
+            }
+            if (slot.key.v == key.v && slot.key.vt == key.vt && slot.key.vn == key.vn)
+            {
+                inserted = false;
+                return slot.index;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+private:
+    struct Slot
+    {
+        FaceIndex key;
+        unsigned int index;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t count;
+    uint32_t generation;
+
+    static size_t hash(const FaceIndex &key)
+    {
+        uint64_t h = (uint64_t)(uint32_t)key.v * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)(uint32_t)key.vt * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+        h ^= (uint64_t)(uint32_t)key.vn * 0x165667B19E3779F9ull + (h >> 32);
+        return (size_t)(h ^ (h >> 31));
+    }
+
+    void grow();
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <iostream>
 #include <cerrno>
+#include <vector>
 
 std::string get_file_contents(const char* filename);
 
@@ -17,11 +18,61 @@ class Shader
     public:
     GLuint ID;
 
-    Shader(const char* vertexFile, const char* fragmentFile);
+    // Process-wide number for a uniform name, the same in every program, so
+    // draw code can look it up once (e.g. into a function-local static) and
+    // use it with whichever Shader it is handed. Array elements are named
+    // "name[i]". GL thread only.
+    typedef unsigned int UniformHandle;
+    static UniformHandle Uniform(const char* name);
+
+    // Compiles and links the two files, or loads the program binary an
+    // earlier run saved for the same sources and driver (ProgramCache).
+    // Each of `defines` is #defined in both stages, after the #version line
+    // (see ShaderVariants).
+    Shader(const char* vertexFile, const char* fragmentFile, const std::vector<std::string>& defines = {});
 
     void Activate();
 
+    // Setters for this program, which must be current. The active uniforms
+    // are enumerated once at link time; a call is skipped when the program
+    // has no such uniform or it already holds the value. Only the GL calls
+    // issued are counted in RenderStats.
+    void SetInt(UniformHandle uniform, GLint value);
+    void SetFloat(UniformHandle uniform, GLfloat value);
+    void SetVec3(UniformHandle uniform, const glm::vec3& value);
+    void SetMat3(UniformHandle uniform, const glm::mat3& value);
+    void SetMat4(UniformHandle uniform, const glm::mat4& value);
+    // The model matrix every draw path sets, and with it normalMatrix when
+    // the program has one; view and projection come from the FrameData
+    // block (FrameUniforms)
+    void SetModel(const glm::mat4& model);
+
+    // Transforms normals for `model`: its upper 3x3 when that is a rotation
+    // with one scale for all axes (the shaders normalize), otherwise the
+    // inverse transpose
+    static glm::mat3 NormalMatrix(const glm::mat4& model);
+
+    bool HasUniform(UniformHandle uniform) const;
+
     void Delete();
+
+    private:
+    struct UniformSlot
+    {
+        GLint location;
+        bool set;
+        // Last value set, as raw bits: up to a mat4
+        GLfloat value[16];
+    };
+    // Indexed by handle; location -1 for names the program does not use
+    std::vector<UniformSlot> uniforms;
+
+    // With retrievable, asks the driver to keep the binary for ProgramCache
+    bool compileAndLink(const char* vertexSource, const char* fragmentSource, bool retrievable);
+    void reflectUniforms();
+    void bindFrameBlock();
+    // The slot to write `bytes` of value to, or null when the call can be skipped
+    UniformSlot* changed(UniformHandle uniform, const void* value, size_t bytes);
 };
 
 #endif
\ No newline at end of file
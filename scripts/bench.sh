@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Builds and runs the Model load-time benchmark (tools/model_bench.cpp).
+# Extra arguments are passed through, e.g. ./scripts/bench.sh --faces 4000000
+
+cd "$(dirname "$0")/.."
+
+g++ -O2 -o model_bench tools/model_bench.cpp \
+    src/utils/shaderclass.cpp \
+    src/utils/VBO.cpp \
+    src/utils/VAO.cpp \
+    src/utils/EBO.cpp \
+    src/utils/Texture.cpp \
+    src/utils/PixelBufferRing.cpp \
+    src/utils/KtxFile.cpp \
+    src/utils/TextureArray.cpp \
+    src/utils/TextureStreamer.cpp \
+    src/utils/VertexPacking.cpp \
+    src/utils/OverdrawMeter.cpp \
+    src/utils/FrameUniforms.cpp \
+    src/utils/ProgramCache.cpp \
+    src/utils/ShaderVariants.cpp \
+    src/utils/MappedFile.cpp \
+    src/utils/ThreadPool.cpp \
+    src/utils/ResourceCache.cpp \
+    src/utils/LoadReport.cpp \
+    src/models/VertexIndexMap.cpp \
+    src/models/MeshCache.cpp \
+    src/models/ObjChunkParser.cpp \
+    src/models/MeshOptimizer.cpp \
+    src/models/MeshNormals.cpp \
+    src/models/Model.cpp \
+    src/models/ModelLoader.cpp \
+    -Iinclude \
+    -lglfw \
+    -lGL \
+    -lGLEW \
+    -ldl \
+    -std=c++17 \
+    -pthread || exit 1
+
+./model_bench "$@"
@@ -1,6 +1,8 @@
 #!/bin/bash
 
 # OpenGL Classroom Project Run Script - Week 2 Enhanced with 360° View
+# Extra arguments are passed to the program to scale the scene, e.g.
+# ./scripts/run.sh --desks 20x20 --fans 6x8 (see include/SceneConfig.h)
 
 # Colors for output
 RED='\033[0;31m'
@@ -23,6 +25,11 @@ g++ -o main src/main.cpp \
     src/utils/EBO.cpp \
     src/utils/Furniture.cpp \
     src/utils/Texture.cpp \
+    src/utils/PixelBufferRing.cpp \
+    src/utils/KtxFile.cpp \
+    src/utils/TextureArray.cpp \
+    src/utils/TextureStreamer.cpp \
+    src/utils/VertexPacking.cpp \
     src/utils/CeilingTiles.cpp \
     src/utils/LightPanels.cpp \
     src/utils/TubeLight.cpp \
@@ -31,13 +38,29 @@ g++ -o main src/main.cpp \
     src/utils/GreenBoard.cpp \
     src/utils/Door.cpp \
     src/utils/ProjectorScreen.cpp \
+    src/utils/OverdrawMeter.cpp \
+    src/utils/FrameUniforms.cpp \
+    src/utils/ProgramCache.cpp \
+    src/utils/ShaderVariants.cpp \
+    src/utils/MappedFile.cpp \
+    src/utils/ThreadPool.cpp \
+    src/utils/ResourceCache.cpp \
+    src/utils/LoadReport.cpp \
+    src/utils/SceneConfig.cpp \
+    src/models/VertexIndexMap.cpp \
+    src/models/MeshCache.cpp \
+    src/models/ObjChunkParser.cpp \
+    src/models/MeshOptimizer.cpp \
+    src/models/MeshNormals.cpp \
     src/models/Model.cpp \
+    src/models/ModelLoader.cpp \
     -Iinclude \
     -lglfw \
     -lGL \
     -lGLEW \
     -ldl \
-    -std=c++17
+    -std=c++17 \
+    -pthread
 
 # Check if compilation was successful
 if [ $? -eq 0 ]; then
@@ -59,7 +82,7 @@ if [ $? -eq 0 ]; then
     echo -e "  ${GREEN}Special:${NC}"
     echo -e "    ESC: Exit program"
     echo ""
-    ./main
+    ./main "$@"
 else
     echo -e "${RED}Compilation failed!${NC}"
     echo -e "${YELLOW}Make sure you have the required libraries installed:${NC}"
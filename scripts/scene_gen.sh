@@ -0,0 +1,11 @@
+#!/bin/bash
+
+# Builds and runs the synthetic mesh generator (tools/scene_gen.cpp).
+# Arguments are passed through, e.g.
+# ./scripts/scene_gen.sh --triangles 1000000 --materials 4 --arity 4 models/synthetic.obj
+
+cd "$(dirname "$0")/.."
+
+g++ -O2 -o scene_gen tools/scene_gen.cpp -std=c++17 || exit 1
+
+./scene_gen "$@"
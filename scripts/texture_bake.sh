@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Builds and runs the offline texture bake (tools/texture_bake.cpp), which
+# writes "<image>.ktx" next to each image. Arguments are passed through, e.g.
+# ./scripts/texture_bake.sh                      # every image in textures/
+# ./scripts/texture_bake.sh --format raw textures/desk.jpeg
+
+cd "$(dirname "$0")/.."
+
+g++ -O2 -o texture_bake tools/texture_bake.cpp src/utils/KtxFile.cpp src/utils/MappedFile.cpp -Iinclude -std=c++17 || exit 1
+
+./texture_bake "$@"
@@ -6,13 +6,23 @@ in float vertexAlpha;
 
 out vec4 FragColor;
 
+// Variants (ShaderVariants) by room surface: FLOOR, CEILING, WALL or BOARD
+
 #define MAX_LIGHTS 2
-uniform vec3 lightPos[MAX_LIGHTS];
-uniform vec3 tubeCenter;
-uniform vec3 tubeAxis;
-uniform float tubeLength;
-uniform float tubeRadius;
-uniform vec3 lightColor;
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
 
 float random(vec2 st) {
     return fract(sin(dot(st.xy, vec2(12.9898,78.233))) * 43758.5453123);
@@ -41,37 +51,29 @@ vec3 closestPointOnTube(vec3 fragPos, vec3 tubeCenter, vec3 tubeAxis, float tube
 
 void main()
 {
-   
-   float shininess;
-   float specularStrength;
    vec3 baseColor = vertexColor;
-   
-   if (FragPos.y < 0.01) {
-       
-       shininess = 128.0;
-       specularStrength = 0.8;
-   } else if (FragPos.y > 6.5) {
+#if defined(FLOOR)
+   const float shininess = 128.0;
+   const float specularStrength = 0.8;
+#elif defined(CEILING)
+   const float shininess = 64.0;
+   const float specularStrength = 0.6;
+#elif defined(BOARD)
+   const float shininess = 8.0;
+   const float specularStrength = 0.2;
+#elif defined(WALL)
+   const float shininess = 4.0;
+   const float specularStrength = 0.05;
 
-       shininess = 64.0;
-       specularStrength = 0.6;
-   } else {
+   vec2 texCoord = vec2(FragPos.x * 2.0, FragPos.z * 2.0);
+   float noise = random(floor(texCoord * 50.0)) * 0.04 - 0.02;
+   baseColor = vertexColor + vec3(noise);
 
-    if (FragPos.z > 10.69 && FragPos.z < 10.75) { 
-        shininess = 8.0; 
-        specularStrength = 0.2;  
-    } else {
-       shininess = 4.0;  
-       specularStrength = 0.05;  
-
-       vec2 texCoord = vec2(FragPos.x * 2.0, FragPos.z * 2.0);
-       float noise = random(floor(texCoord * 50.0)) * 0.04 - 0.02;
-       baseColor = vertexColor + vec3(noise);
-       
-       float bumpNoise = random(floor(texCoord * 30.0)) * 0.03;
-       baseColor = baseColor * (1.0 + bumpNoise);
-    }
-    
-   }
+   float bumpNoise = random(floor(texCoord * 30.0)) * 0.03;
+   baseColor = baseColor * (1.0 + bumpNoise);
+#else
+#error "default.frag is built as one surface variant: FLOOR, CEILING, WALL or BOARD"
+#endif
    
    float ambientStrength = 0.5;  
    vec3 ambient = ambientStrength * lightColor * baseColor;
@@ -5,8 +5,24 @@ layout (location = 2) in vec3 aNormal;
 layout (location = 3) in float aAlpha;  
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Shader::NormalMatrix(model), worked out once per draw on the CPU
+uniform mat3 normalMatrix;
+
+#define MAX_LIGHTS 2
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
 
 out vec3 vertexColor;
 out vec3 Normal;
@@ -18,6 +34,6 @@ void main()
    gl_Position = projection * view * model * vec4(aPos, 1.0);
    vertexColor = aColor;
    FragPos = vec3(model * vec4(aPos, 1.0));
-   Normal = mat3(transpose(inverse(model))) * aNormal;
+   Normal = normalMatrix * aNormal;
    vertexAlpha = aAlpha;  
 }
\ No newline at end of file
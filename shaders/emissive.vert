@@ -6,8 +6,22 @@ layout (location = 2) in vec3 aNormal;
 out vec3 vertexColor;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+#define MAX_LIGHTS 2
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
 
 void main()
 {
@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColor;
+
+// Each shaded fragment adds one step to the red channel (additive blending);
+// fragments rejected by the depth test never get here
+void main()
+{
+    FragColor = vec4(1.0 / 255.0, 0.0, 0.0, 1.0);
+}
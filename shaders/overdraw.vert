@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+#define MAX_LIGHTS 2
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+
+// Same position decoding as texture.vert
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(positionOffset + aPos * positionScale, 1.0);
+}
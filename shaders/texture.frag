@@ -6,17 +6,38 @@ in vec2 TexCoord;
 out vec4 FragColor;
 
 #define MAX_LIGHTS 2
-uniform vec3 lightPos[MAX_LIGHTS];
-uniform vec3 tubeCenter;
-uniform vec3 tubeAxis;
-uniform float tubeLength;
-uniform float tubeRadius;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+
+// Variants (ShaderVariants): TEXTURED, TEXTURE_ARRAY, WHITE_PLASTIC, or none
+// of them for the material's color
+#if defined(WHITE_PLASTIC)
+const vec3 objectColor = vec3(0.95, 0.95, 0.95);
+const float specularStrength = 0.5;
+#elif defined(TEXTURED)
 uniform sampler2D tex0;
-uniform int hasTexture;
-uniform int isWhitePlastic;
+const float specularStrength = 0.15;
+#elif defined(TEXTURE_ARRAY)
+uniform sampler2DArray texArray;
+uniform int texLayer;
+const float specularStrength = 0.15;
+#else
 uniform vec3 materialDiffuse;
+// Set per model (Model::untexturedSpecular)
+uniform float specularStrength;
+#endif
 
 vec3 closestPointOnTube(vec3 fragPos, vec3 tubeCenter, vec3 tubeAxis, float tubeLength, float tubeRadius) {
     vec3 toFrag = fragPos - tubeCenter;
@@ -41,15 +62,13 @@ vec3 closestPointOnTube(vec3 fragPos, vec3 tubeCenter, vec3 tubeAxis, float tube
 
 void main()
 {
-    vec3 objectColor;
-    
-    if (isWhitePlastic == 1) {
-        objectColor = vec3(0.95f, 0.95f, 0.95f);
-    } else if (hasTexture == 1) {
-        objectColor = texture(tex0, TexCoord).rgb;
-    } else {
-        objectColor = materialDiffuse;
-    }
+#if defined(TEXTURED)
+    vec3 objectColor = texture(tex0, TexCoord).rgb;
+#elif defined(TEXTURE_ARRAY)
+    vec3 objectColor = texture(texArray, vec3(TexCoord, float(texLayer))).rgb;
+#elif !defined(WHITE_PLASTIC)
+    vec3 objectColor = materialDiffuse;
+#endif
     
     float ambientStrength = 0.06;
     vec3 ambient = ambientStrength * lightColor;
@@ -60,15 +79,6 @@ void main()
     vec3 diffuse = vec3(0.0);
     vec3 specular = vec3(0.0);
     
-    float specularStrength = 0.6;
-    if (isWhitePlastic == 1) {
-        specularStrength = 0.5;
-    } else if (hasTexture == 1) {
-        specularStrength = 0.15;
-    } else if (FragPos.y < 4.0) {
-        specularStrength = 0.2;
-    }
-    
     for (int i = 0; i < MAX_LIGHTS; i++) {
         vec3 lightDir = normalize(lightPos[i] - FragPos);
         float diff = max(dot(norm, lightDir), 0.0);
@@ -3,21 +3,82 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
+#ifdef INSTANCED
+// One desk, fan, ... of Model::DrawInstanced: its transform and
+// Shader::NormalMatrix of it, per instance
+layout (location = 3) in mat4 instanceModel;
+layout (location = 7) in mat3 instanceNormalMatrix;
+#ifdef SPINNING
+// Spin about the copy's y axis: turns per second and phase in turns
+layout (location = 10) in vec2 instanceSpin;
+// Seconds the spin has run
+uniform float time;
+#endif
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Shader::NormalMatrix(model), worked out once per draw on the CPU
+uniform mat3 normalMatrix;
+#endif
+
+#define MAX_LIGHTS 2
+// Per-frame camera and lighting, shared by every program; layout mirrored
+// by FrameUniforms::Block
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos[MAX_LIGHTS];
+    vec3 tubeCenter;
+    float tubeLength;
+    vec3 tubeAxis;
+    float tubeRadius;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+
+// Packed meshes (see VertexPacking.h): aPos is in [0, 1] across the mesh
+// bounds and aNormal.xy is octahedral-encoded. Float meshes use offset 0,
+// scale 1 and packedNormals 0.
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int packedNormals;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+#ifdef INSTANCED
+    mat4 model = instanceModel;
+    mat3 normalMatrix = instanceNormalMatrix;
+#ifdef SPINNING
+    float angle = 6.28318531 * fract(time * instanceSpin.x + instanceSpin.y);
+    float c = cos(angle), s = sin(angle);
+    // Rotation about y, applied before the copy's transform; the inverse
+    // transpose of model * spin is normalMatrix * spin
+    mat3 spin = mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+    model = model * mat4(spin);
+    normalMatrix = normalMatrix * spin;
+#endif
+#endif
+    vec3 position = positionOffset + aPos * positionScale;
+    vec3 normal = packedNormals == 1 ? octDecode(aNormal.xy) : aNormal;
+
+    FragPos = vec3(model * vec4(position, 1.0));
     
-    Normal = normalize(mat3(transpose(inverse(model))) * aNormal);
+    Normal = normalize(normalMatrix * normal);
     
     TexCoord = aTexCoord;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+}
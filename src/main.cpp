@@ -1,5 +1,7 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -21,6 +23,19 @@
 #include "Door.h"
 #include "ProjectorScreen.h"
 #include "models/Model.h"
+#include "models/ModelLoader.h"
+#include "ResourceCache.h"
+#include "RenderStats.h"
+#include "OverdrawMeter.h"
+#include "FrameUniforms.h"
+#include "ProgramCache.h"
+#include "ShaderVariants.h"
+#include "VertexPacking.h"
+#include "SceneConfig.h"
+#include "LoadReport.h"
+#include "PixelBufferRing.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
 
 // Camera state
 glm::vec3 cameraPos = glm::vec3(-10.0f, 3.0f, 2.0f);
@@ -42,8 +57,12 @@ int lightCoord[ceilingTiles::numLights][2] = {
 };
 glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 0.9f);
 
-float fanRotationSpeed[furniture::fans];
+std::vector<float> fanRotationSpeed;
 ProjectorScreen *projectorScreen = nullptr;
+bool overdrawMode = false;
+bool lodEnabled = true;
+bool reportFurnitureTriangles = false;
+bool reportTextureStreaming = false;
 
 void setCameraPreset(int preset)
 {
@@ -93,6 +112,19 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
     if (action == GLFW_PRESS && key == GLFW_KEY_P && projectorScreen)
         projectorScreen->ToggleScreen();
+    if (action == GLFW_PRESS && key == GLFW_KEY_O)
+    {
+        overdrawMode = !overdrawMode;
+        std::cout << "Overdraw measurement " << (overdrawMode ? "on" : "off") << std::endl;
+    }
+    if (action == GLFW_PRESS && key == GLFW_KEY_L)
+    {
+        lodEnabled = !lodEnabled;
+        reportFurnitureTriangles = true;
+        std::cout << "Mesh LODs " << (lodEnabled ? "on" : "off") << std::endl;
+    }
+    if (action == GLFW_PRESS && key == GLFW_KEY_T)
+        reportTextureStreaming = true;
 }
 
 void mouse_callback(GLFWwindow *window, double xpos, double ypos)
@@ -225,27 +257,14 @@ void createRightWall(std::vector<GLfloat> &vertices, std::vector<GLuint> &indice
                 wallR, wallG, wallB, -1.0f, 0.0f, 0.0f);
 }
 
-void setLightingUniforms(GLuint shaderID, const glm::vec3 *lights,
-                         const TubeLight &tubeLight, const glm::vec3 &color, const glm::vec3 *viewPos = nullptr)
+int main(int argc, char **argv)
 {
-    // glUniform3fv(glGetUniformLocation(shaderID, "lightPos1"), 1, glm::value_ptr(light1));
-    // glUniform3fv(glGetUniformLocation(shaderID, "lightPos2"), 1, glm::value_ptr(light2));
-    for (int i = 0; i < ceilingTiles::numLights; i++)
-    {
-        std::string uniformName = "lightPos[" + std::to_string(i) + "]";
-        glUniform3fv(glGetUniformLocation(shaderID, uniformName.c_str()), 1, glm::value_ptr(lights[i]));
-    }
-    glUniform3fv(glGetUniformLocation(shaderID, "tubeCenter"), 1, glm::value_ptr(tubeLight.GetTubeCenter()));
-    glUniform3fv(glGetUniformLocation(shaderID, "tubeAxis"), 1, glm::value_ptr(tubeLight.GetTubeAxis()));
-    glUniform1f(glGetUniformLocation(shaderID, "tubeLength"), tubeLight.GetTubeLength());
-    glUniform1f(glGetUniformLocation(shaderID, "tubeRadius"), tubeLight.GetTubeRadius());
-    glUniform3fv(glGetUniformLocation(shaderID, "lightColor"), 1, glm::value_ptr(color));
-    if (viewPos)
-        glUniform3fv(glGetUniformLocation(shaderID, "viewPos"), 1, glm::value_ptr(*viewPos));
-}
+    SceneConfig scene;
+    if (!scene.ParseArgs(argc, argv))
+        return -1;
+    LoadReport::Shared().SetQuiet(scene.quiet);
+    LoadReport::Shared().SetDetailed(!scene.loadReportPath.empty());
 
-int main()
-{
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -274,10 +293,9 @@ int main()
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
 
-    for (int i = 0; i < furniture::fans; i++)
-        fanRotationSpeed[i] = 2.0f;
+    fanRotationSpeed.assign(scene.Fans(), 2.0f);
 
-    float roomLength = room::length, roomWidth = room::width, roomHeight = room::height;
+    float roomLength = scene.roomLength, roomWidth = scene.roomWidth, roomHeight = scene.roomHeight;
 
     // Window parameters
     const float frameThickness = 0.05f;
@@ -328,42 +346,55 @@ int main()
 
     GLuint indices[] = {0, 1, 2, 2, 3, 0, 4, 6, 5, 6, 4, 7, 8, 10, 9, 10, 8, 11};
 
-    Shader roomShader("shaders/default.vert", "shaders/default.frag");
-    Shader furnitureShader("shaders/texture.vert", "shaders/texture.frag");
+    // Every variant the scene draws with, compiled (or loaded from the
+    // program binary cache) before the first frame
+    ShaderVariants roomShaders("shaders/default.vert", "shaders/default.frag");
+    ShaderVariants furnitureShaders("shaders/texture.vert", "shaders/texture.frag");
+    roomShaders.Prepare({ShaderVariants::FLOOR, ShaderVariants::CEILING, ShaderVariants::WALL, ShaderVariants::BOARD});
+    furnitureShaders.Prepare({0, ShaderVariants::TEXTURED, ShaderVariants::TEXTURE_ARRAY, ShaderVariants::WHITE_PLASTIC,
+                              ShaderVariants::INSTANCED, ShaderVariants::TEXTURED | ShaderVariants::INSTANCED,
+                              ShaderVariants::TEXTURE_ARRAY | ShaderVariants::INSTANCED,
+                              ShaderVariants::INSTANCED | ShaderVariants::SPINNING,
+                              ShaderVariants::TEXTURED | ShaderVariants::INSTANCED | ShaderVariants::SPINNING,
+                              ShaderVariants::TEXTURE_ARRAY | ShaderVariants::INSTANCED | ShaderVariants::SPINNING});
+    Shader &floorShader = roomShaders.Get(ShaderVariants::FLOOR);
+    Shader &ceilingShader = roomShaders.Get(ShaderVariants::CEILING);
+    Shader &wallShader = roomShaders.Get(ShaderVariants::WALL);
+    Shader &boardShader = roomShaders.Get(ShaderVariants::BOARD);
 
     VAO roomVAO;
     roomVAO.Bind();
-    VBO roomVBO(vertices, sizeof(vertices));
+    VBO *roomVBO = VertexPacking::CreateColorVertexBuffer(roomVAO, vertices, sizeof(vertices) / (9 * sizeof(GLfloat)), 9);
     EBO roomEBO(indices, sizeof(indices));
-    roomVAO.LinkVBOAttrib(roomVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    roomVAO.LinkVBOAttrib(roomVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    roomVAO.LinkVBOAttrib(roomVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     roomVAO.Unbind();
 
     VAO backWallVAO;
     backWallVAO.Bind();
-    VBO backWallVBO(backWallVertices.data(), backWallVertices.size() * sizeof(GLfloat));
+    VBO *backWallVBO = VertexPacking::CreateColorVertexBuffer(backWallVAO, backWallVertices.data(), backWallVertices.size() / 9, 9);
     EBO backWallEBO(backWallIndices.data(), backWallIndices.size() * sizeof(GLuint));
-    backWallVAO.LinkVBOAttrib(backWallVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    backWallVAO.LinkVBOAttrib(backWallVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    backWallVAO.LinkVBOAttrib(backWallVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     backWallVAO.Unbind();
 
     VAO rightWallVAO;
     rightWallVAO.Bind();
-    VBO rightWallVBO(rightWallVertices.data(), rightWallVertices.size() * sizeof(GLfloat));
+    VBO *rightWallVBO = VertexPacking::CreateColorVertexBuffer(rightWallVAO, rightWallVertices.data(), rightWallVertices.size() / 9, 9);
     EBO rightWallEBO(rightWallIndices.data(), rightWallIndices.size() * sizeof(GLuint));
-    rightWallVAO.LinkVBOAttrib(rightWallVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    rightWallVAO.LinkVBOAttrib(rightWallVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    rightWallVAO.LinkVBOAttrib(rightWallVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     rightWallVAO.Unbind();
 
-    // Load models
-    Model customDesk("models/desk.obj");
-    Model customFan("models/classroom_fan.obj");
-    Model customPodium("models/podium.obj");
-    Model customProjector("models/classroom_projector.obj");
-    Model projectorScreenRod("models/project_screen_rod.obj");
+    // Before any model texture is uploaded
+    if (scene.textureBudgetMB)
+        TextureStreamer::Shared().Enable(scene.textureBudgetMB << 20, ThreadPool::Shared());
+
+    // Load models in the background; they appear as their uploads finish
+    double loadStart = glfwGetTime();
+    ModelLoader modelLoader;
+    Model &customDesk = *modelLoader.Request(scene.deskModel.c_str());
+    Model &customFan = *modelLoader.Request(scene.fanModel.c_str());
+    Model &customPodium = *modelLoader.Request("models/podium.obj");
+    Model &customProjector = *modelLoader.Request("models/classroom_projector.obj");
+    Model &projectorScreenRod = *modelLoader.Request("models/project_screen_rod.obj");
+    Model *furnitureModels[] = {&customDesk, &customFan, &customPodium, &customProjector, &projectorScreenRod};
+    bool firstFrame = true;
+    bool modelsResident = false;
 
     CeilingTiles ceilingTiles(roomLength, roomWidth, roomHeight, 10, 15);
     LightPanelPositions lightPositions[ceilingTiles::numLights] = {
@@ -391,151 +422,259 @@ int main()
         lightPos[i] = glm::vec3(lightX, lightY, lightZ);
     }
 
-    // Render loop
-    while (!glfwWindowShouldClose(window))
-    {
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        if (projectorScreen)
-            projectorScreen->Update(deltaTime);
-
-        processInput(window);
-
-        glClearColor(0.53f, 0.81f, 0.98f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(60.0f),
-                                                (float)window::width / window::height, 0.1f, 100.0f);
-        glm::mat4 model = glm::mat4(1.0f);
-
-        // Render room
-        roomShader.Activate();
-        glUniformMatrix4fv(glGetUniformLocation(roomShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(roomShader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(roomShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        // setLightingUniforms(roomShader.ID, lightPos1, lightPos2, tubeLight, lightColor);
-        setLightingUniforms(roomShader.ID, lightPos, tubeLight, lightColor, &cameraPos);
+    // Surfaces the fragment shader used to tell apart by height; the fans and
+    // rod hang high up and keep the brighter highlight
+    customProjector.shaderFeatures = ShaderVariants::WHITE_PLASTIC;
+    customFan.untexturedSpecular = 0.6f;
+    projectorScreenRod.untexturedSpecular = 0.6f;
 
-        roomVAO.Bind();
-        glDrawElements(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0);
-        backWallVAO.Bind();
-        glDrawElements(GL_TRIANGLES, backWallIndices.size(), GL_UNSIGNED_INT, 0);
-        rightWallVAO.Bind();
-        glDrawElements(GL_TRIANGLES, rightWallIndices.size(), GL_UNSIGNED_INT, 0);
-
-        ceilingTiles.Draw(roomShader, model, view, projection);
-        lightPanels.Draw(model, view, projection);
-        tubeLight.Draw(model, view, projection);
-        backWallWindows.Draw(roomShader, model, view, projection);
-        rightWallWindows.Draw(roomShader, model, view, projection);
-        greenBoards.Draw(roomShader, model, view, projection);
-        if (projectorScreen)
-            projectorScreen->Draw(roomShader, model, view, projection);
-        entranceDoor.Draw(roomShader, model, view, projection);
-
-        // Render furniture
-        furnitureShader.Activate();
-        setLightingUniforms(furnitureShader.ID, lightPos, tubeLight, lightColor, &cameraPos);
-        glUniform1i(glGetUniformLocation(furnitureShader.ID, "isWhitePlastic"), 0);
-
-        // Render desks
+    // Desk grid transforms; the grid never moves, so its instance buffer is
+    // written once
+    std::vector<glm::mat4> deskTransforms;
+    {
         const float deskScale = furniture::deskScale;
         const float deskYPos = 1.6f;
-        const float colSpacing = 5.0f, rowSpacing = 3.5f;
-        const float benchWidth = 1.8f;
-        const float backMargin = 2.5f;
-        const float startZ = -roomWidth / 2 + backMargin;
-        const float gridWidth = (furniture::cols - 1) * colSpacing + benchWidth;
+        const float colSpacing = furniture::deskColSpacing, rowSpacing = furniture::deskRowSpacing;
+        const float benchWidth = furniture::benchWidth;
+        const float startZ = -roomWidth / 2 + furniture::backMargin;
+        const float gridWidth = (scene.deskCols - 1) * colSpacing + benchWidth;
         const float sideSpace = (roomLength - gridWidth) / 2.0f;
         const float startXDesk = -roomLength / 2 + sideSpace + benchWidth / 2.0f;
 
-        for (int row = 0; row < furniture::rows; row++)
+        for (int row = 0; row < scene.deskRows; row++)
         {
-            for (int col = 0; col < furniture::cols; col++)
+            for (int col = 0; col < scene.deskCols; col++)
             {
                 glm::mat4 deskModel = glm::mat4(1.0f);
                 deskModel = glm::translate(deskModel, glm::vec3(startXDesk + col * colSpacing,
                                                                 deskYPos, startZ + row * rowSpacing));
                 deskModel = glm::scale(deskModel, glm::vec3(deskScale));
                 deskModel = glm::rotate(deskModel, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-                customDesk.Draw(furnitureShader, deskModel, view, projection);
+                deskTransforms.push_back(deskModel);
             }
         }
+    }
 
-        // Render fans
+    // Fan positions and spins (turns per second, phase in turns), fixed like
+    // the desks; only the time uniform changes from frame to frame
+    std::vector<glm::mat4> fanTransforms;
+    std::vector<glm::vec2> fanSpins;
+    {
         const float fanScale = furniture::fanScale;
         const float fanYPos = roomHeight - 1.2f;
-        const float fanSpacingX = roomLength * 0.7f / (furniture::fanCols - 1);
-        const float fanSpacingZ = roomWidth * 0.6f / (furniture::fanRows - 1);
-        const float fanStartX = -roomLength * 0.35f;
-        const float fanStartZ = -roomWidth * 0.3f;
+        // A single row or column of fans hangs along the room's centre line
+        const float fanSpacingX = scene.fanCols > 1 ? roomLength * 0.7f / (scene.fanCols - 1) : 0.0f;
+        const float fanSpacingZ = scene.fanRows > 1 ? roomWidth * 0.6f / (scene.fanRows - 1) : 0.0f;
+        const float fanStartX = scene.fanCols > 1 ? -roomLength * 0.35f : 0.0f;
+        const float fanStartZ = scene.fanRows > 1 ? -roomWidth * 0.3f : 0.0f;
 
-        int fanIndex = 0;
-        for (int row = 0; row < furniture::fanRows; row++)
+        for (int row = 0; row < scene.fanRows; row++)
         {
-            for (int col = 0; col < furniture::fanCols; col++)
+            for (int col = 0; col < scene.fanCols; col++)
             {
-                float rotation = fmod(glfwGetTime() * fanRotationSpeed[fanIndex] * 360.0f + fanIndex * 45.0f, 360.0f);
                 glm::mat4 fanModel = glm::mat4(1.0f);
                 fanModel = glm::translate(fanModel, glm::vec3(fanStartX + col * fanSpacingX,
                                                               fanYPos, fanStartZ + row * fanSpacingZ));
                 fanModel = glm::scale(fanModel, glm::vec3(fanScale));
-                fanModel = glm::rotate(fanModel, glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
-                customFan.Draw(furnitureShader, fanModel, view, projection);
-                fanIndex++;
+                int fanIndex = (int)fanTransforms.size();
+                fanTransforms.push_back(fanModel);
+                fanSpins.push_back(glm::vec2(fanRotationSpeed[fanIndex], fanIndex * 45.0f / 360.0f));
             }
         }
+    }
+    // The shader's time wraps here so float keeps it precise in long sessions
+    const double fanSpinPeriod = Model::SpinPeriod(fanSpins);
+
+    // Desks, fans, podium, projector and screen rod, drawn with `shader`: a
+    // Shader, or ShaderVariants to pick each material's variant
+    auto renderFurniture = [&](auto &shader, const glm::mat4 &view, const glm::mat4 &projection)
+    {
+        // Render desks, one instanced draw per desk mesh however many seats
+        customDesk.DrawInstanced(shader, deskTransforms, view, projection);
+
+        // Render fans, spun by the vertex shader
+        customFan.DrawInstanced(shader, fanTransforms, fanSpins, (float)fmod(glfwGetTime(), fanSpinPeriod), view,
+                                projection);
 
         // Render podium
         glm::mat4 podiumModel = glm::mat4(1.0f);
         podiumModel = glm::translate(podiumModel, glm::vec3(roomLength / 2 - 5.5f, 1.35f, roomWidth / 2 - 2.0f));
         podiumModel = glm::scale(podiumModel, glm::vec3(1.2f));
         podiumModel = glm::rotate(podiumModel, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        customPodium.Draw(furnitureShader, podiumModel, view, projection);
+        customPodium.Draw(shader, podiumModel, view, projection);
 
         // Render projector
-        glUniform1i(glGetUniformLocation(furnitureShader.ID, "isWhitePlastic"), 1);
         glm::mat4 projectorModel = glm::mat4(1.0f);
         projectorModel = glm::translate(projectorModel, glm::vec3(0.0f, roomHeight - 2.2f, 0.0f));
         projectorModel = glm::scale(projectorModel, glm::vec3(0.3f));
         projectorModel = glm::rotate(projectorModel, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        customProjector.Draw(furnitureShader, projectorModel, view, projection);
+        customProjector.Draw(shader, projectorModel, view, projection);
 
         // Render screen rod
-        glUniform1i(glGetUniformLocation(furnitureShader.ID, "isWhitePlastic"), 0);
         float boardHeight = roomHeight * 0.35f;
         float boardTopY = roomHeight / 2.0f + boardHeight / 2.0f;
         glm::mat4 screenRodModel = glm::mat4(1.0f);
         screenRodModel = glm::translate(screenRodModel, glm::vec3(0.0f, boardTopY + 0.3f, frontWallZ - 0.15f));
         screenRodModel = glm::scale(screenRodModel, glm::vec3(0.5f));
         screenRodModel = glm::rotate(screenRodModel, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        projectorScreenRod.Draw(furnitureShader, screenRodModel, view, projection);
+        projectorScreenRod.Draw(shader, screenRodModel, view, projection);
+    };
+
+    // Far enough for scaled-up rooms, never nearer than the original 100
+    const float farPlane = std::max(100.0f, scene.ViewDistance());
+
+    OverdrawMeter overdrawMeter(window::width, window::height);
+    FrameUniforms frameUniforms;
+    frameUniforms.SetLights(lightPos, tubeLight, lightColor);
+    float lastOverdrawReport = 0.0f;
+
+    // Render loop
+    while (!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        if (projectorScreen)
+            projectorScreen->Update(deltaTime);
+
+        processInput(window);
+
+        modelLoader.ProcessUploads(loading::uploadBudgetMs);
+        if (!modelsResident && modelLoader.Done())
+        {
+            modelsResident = true;
+            std::cout << "All models resident after " << (glfwGetTime() - loadStart) * 1000.0 << " ms" << std::endl;
+            ResourceCache::Shared().Report();
+            if (!scene.loadReportPath.empty())
+            {
+                if (LoadReport::Shared().WriteJSON(scene.loadReportPath.c_str()))
+                    std::cout << "Load report written to " << scene.loadReportPath << std::endl;
+                else
+                    std::cerr << "Failed to write load report: " << scene.loadReportPath << std::endl;
+            }
+        }
+
+        glClearColor(0.53f, 0.81f, 0.98f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f),
+                                                (float)window::width / window::height, 0.1f, farPlane);
+        glm::mat4 model = glm::mat4(1.0f);
+        frameUniforms.SetCamera(view, projection, cameraPos);
+        frameUniforms.Upload();
+
+        // Render room: the floor quad, then the front and left walls
+        floorShader.Activate();
+        floorShader.SetModel(model);
+        roomVAO.Bind();
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+        wallShader.Activate();
+        wallShader.SetModel(model);
+        glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_INT, (void *)(6 * sizeof(GLuint)));
+        backWallVAO.Bind();
+        glDrawElements(GL_TRIANGLES, backWallIndices.size(), GL_UNSIGNED_INT, 0);
+        rightWallVAO.Bind();
+        glDrawElements(GL_TRIANGLES, rightWallIndices.size(), GL_UNSIGNED_INT, 0);
+        backWallWindows.Draw(wallShader, model);
+        rightWallWindows.Draw(wallShader, model);
+        if (projectorScreen)
+            projectorScreen->Draw(wallShader, model);
+        entranceDoor.Draw(wallShader, model);
+
+        greenBoards.Draw(boardShader, model);
+        ceilingTiles.Draw(ceilingShader, model);
+        lightPanels.Draw(model);
+        tubeLight.Draw(model);
+
+        // Render furniture
+
+        for (Model *furnitureModel : furnitureModels)
+        {
+            furnitureModel->lodPixelError = lodEnabled ? lod::pixelError : 0.0f;
+            furnitureModel->trianglesDrawn = 0;
+        }
+        RenderStats::Frame().Reset();
+
+        renderFurniture(furnitureShaders, view, projection);
+
+        if (reportFurnitureTriangles)
+        {
+            size_t triangles = 0;
+            for (Model *furnitureModel : furnitureModels)
+                triangles += furnitureModel->trianglesDrawn;
+            const RenderStats &stats = RenderStats::Frame();
+            std::cout << "Furniture this frame: " << triangles << " triangles, " << stats.Total() << " GL calls ("
+                      << stats.drawCalls << " draws)" << std::endl;
+            reportFurnitureTriangles = false;
+        }
+
+        // Streams for the levels this frame's furniture asked for
+        TextureStreamer::Shared().Update();
+        if (reportTextureStreaming)
+        {
+            if (TextureStreamer::Shared().Enabled())
+                TextureStreamer::Shared().Report();
+            else
+                std::cout << "Texture streaming is off (see --texture-budget)" << std::endl;
+            reportTextureStreaming = false;
+        }
+
+        if (overdrawMode)
+        {
+            // Same furniture again, counting shaded fragments instead
+            overdrawMeter.Begin();
+            overdrawMeter.shader.Activate();
+            renderFurniture(overdrawMeter.shader, view, projection);
+            OverdrawMeter::Stats overdraw = overdrawMeter.End();
+
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            overdrawMeter.Show(framebufferWidth, framebufferHeight);
+
+            if (currentFrame - lastOverdrawReport >= 1.0f)
+            {
+                lastOverdrawReport = currentFrame;
+                std::cout << "Overdraw: " << overdraw.fragments << " fragments over " << overdraw.pixels
+                          << " pixels, " << overdraw.Ratio() << " per pixel" << std::endl;
+            }
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        if (firstFrame)
+        {
+            firstFrame = false;
+            std::cout << "First frame after " << (glfwGetTime() - loadStart) * 1000.0 << " ms" << std::endl;
+            ProgramCache::Stats shaderStats = ProgramCache::GetStats();
+            std::cout << "Shader programs: " << shaderStats.programs << " in " << shaderStats.milliseconds << " ms ("
+                      << shaderStats.loaded << " from the binary cache)" << std::endl;
+        }
     }
 
     // Cleanup
     roomVAO.Delete();
-    roomVBO.Delete();
+    roomVBO->Delete();
+    delete roomVBO;
     roomEBO.Delete();
     backWallVAO.Delete();
-    backWallVBO.Delete();
+    backWallVBO->Delete();
+    delete backWallVBO;
     backWallEBO.Delete();
     rightWallVAO.Delete();
-    rightWallVBO.Delete();
+    rightWallVBO->Delete();
+    delete rightWallVBO;
     rightWallEBO.Delete();
-    roomShader.Delete();
-    furnitureShader.Delete();
-
-    customDesk.Delete();
-    customFan.Delete();
-    customPodium.Delete();
-    customProjector.Delete();
-    projectorScreenRod.Delete();
+    roomShaders.Delete();
+    furnitureShaders.Delete();
+    overdrawMeter.Delete();
+    frameUniforms.Delete();
+
+    for (Model *furnitureModel : furnitureModels)
+        ResourceCache::Shared().Release(furnitureModel);
     ceilingTiles.Delete();
     lightPanels.Delete();
     tubeLight.Delete();
@@ -549,6 +688,8 @@ int main()
         projectorScreen->Delete();
         delete projectorScreen;
     }
+    TextureStreamer::Shared().Delete();
+    PixelBufferRing::Shared().Delete();
 
     glfwDestroyWindow(window);
     glfwTerminate();
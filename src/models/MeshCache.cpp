@@ -0,0 +1,423 @@
+#include "models/MeshCache.h"
+#include "models/Model.h"
+#include "MappedFile.h"
+#include "LoadReport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexSize;
+        uint32_t flags;
+        uint64_t sourceHash;
+        uint32_t dependencyCount;
+        uint32_t materialCount;
+        uint32_t meshCount;
+        uint32_t optionsKey;
+    };
+
+    const char cacheMagic[4] = {'C', 'L', 'M', 'C'};
+
+    static_assert(alignof(Vertex) <= MeshCache::sectionAlignment && alignof(glm::vec4) <= MeshCache::sectionAlignment &&
+                      alignof(unsigned int) <= MeshCache::sectionAlignment,
+                  "mesh cache arrays are read in place");
+
+    // Bounds-checked reader over the mapped cache
+    struct Reader
+    {
+        const char *begin;
+        const char *p;
+        const char *end;
+        bool ok;
+
+        template <typename T>
+        T read()
+        {
+            T value{};
+            if ((size_t)(end - p) < sizeof(T))
+            {
+                ok = false;
+                return value;
+            }
+            memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+            return value;
+        }
+
+        std::string readString()
+        {
+            uint32_t length = read<uint32_t>();
+            if (!ok || (size_t)(end - p) < length)
+            {
+                ok = false;
+                return std::string();
+            }
+            std::string value(p, length);
+            p += length;
+            return value;
+        }
+
+        const char *skip(size_t bytes)
+        {
+            if ((size_t)(end - p) < bytes)
+            {
+                ok = false;
+                return nullptr;
+            }
+            const char *start = p;
+            p += bytes;
+            return start;
+        }
+
+        // An array section, after the padding that aligns it
+        const char *skipSection(size_t bytes)
+        {
+            size_t misalignment = (size_t)(p - begin) % MeshCache::sectionAlignment;
+            if (misalignment && !skip(MeshCache::sectionAlignment - misalignment))
+                return nullptr;
+            return skip(bytes);
+        }
+    };
+
+    template <typename T>
+    void write(FILE *out, const T &value)
+    {
+        fwrite(&value, sizeof(T), 1, out);
+    }
+
+    // Pads with zeros up to the next array section
+    void writeSectionPadding(FILE *out)
+    {
+        static const char zeros[MeshCache::sectionAlignment] = {};
+        long offset = ftell(out);
+        size_t misalignment = offset < 0 ? 0 : (size_t)offset % MeshCache::sectionAlignment;
+        if (misalignment)
+            fwrite(zeros, 1, MeshCache::sectionAlignment - misalignment, out);
+    }
+
+    void writeString(FILE *out, const std::string &value)
+    {
+        write<uint32_t>(out, (uint32_t)value.size());
+        fwrite(value.data(), 1, value.size(), out);
+    }
+
+    void writeVec3(FILE *out, const glm::vec3 &value)
+    {
+        write(out, value.x);
+        write(out, value.y);
+        write(out, value.z);
+    }
+
+    // Indices within the mesh's vertices and LOD ranges within its LOD
+    // indices, so a cache that reads cleanly cannot draw out of bounds
+    bool validMesh(const MeshData &data, const std::vector<MeshLod> &lods, uint32_t tangentCount)
+    {
+        for (size_t i = 0; i < data.indexCount; i++)
+            if (data.indices[i] >= data.vertexCount)
+                return false;
+        for (size_t i = 0; i < data.lodIndexCount; i++)
+            if (data.lodIndices[i] >= data.vertexCount)
+                return false;
+        // Level offsets count from the start of the full index list
+        for (const MeshLod &lod : lods)
+        {
+            if (lod.indexOffset < data.indexCount ||
+                lod.indexOffset + lod.indexCount > data.indexCount + data.lodIndexCount)
+                return false;
+        }
+        return tangentCount == 0 || tangentCount == data.vertexCount;
+    }
+
+    glm::vec3 readVec3(Reader &in)
+    {
+        glm::vec3 value(0.0f);
+        value.x = in.read<float>();
+        value.y = in.read<float>();
+        value.z = in.read<float>();
+        return value;
+    }
+}
+
+std::string MeshCache::CachePath(const char *objFile, uint32_t flags, uint32_t optionsKey)
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%02x%08x.meshcache", flags, optionsKey);
+    return std::string(objFile) + suffix;
+}
+
+void MeshCache::Clear(const char *objFile)
+{
+    std::string path = objFile;
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+    std::string prefix = (slash == std::string::npos ? path : path.substr(slash + 1)) + ".";
+    const std::string extension = ".meshcache";
+
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.size() > prefix.size() + extension.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+            remove((directory + "/" + name).c_str());
+    }
+    closedir(dir);
+}
+
+uint64_t MeshCache::HashFile(const char *path)
+{
+    MappedFile file(path);
+    if (!file.IsOpen())
+        return 0;
+    return file.ContentHash();
+}
+
+bool MeshCache::Load(const char *objFile, uint32_t flags, uint32_t optionsKey, Model &model, bool upload)
+{
+    // Misses are timed too: validating the cache is part of every load
+    LoadReport::Timer timer(objFile, "model", LoadReport::CACHE_READ);
+    std::chrono::steady_clock::time_point uploadStart;
+    double uploadMs = 0.0;
+
+    MappedFile file(CachePath(objFile, flags, optionsKey).c_str());
+    if (!file.IsOpen() || file.size < sizeof(CacheHeader))
+        return false;
+
+    Reader in = {file.data, file.data, file.data + file.size, true};
+    CacheHeader header = in.read<CacheHeader>();
+    if (memcmp(header.magic, cacheMagic, 4) != 0 || header.version != version ||
+        header.vertexSize != sizeof(Vertex) || header.flags != flags || header.optionsKey != optionsKey)
+        return false;
+
+    if (header.sourceHash != HashFile(objFile))
+        return false;
+
+    for (uint32_t i = 0; i < header.dependencyCount; i++)
+    {
+        std::string path = in.readString();
+        uint64_t hash = in.read<uint64_t>();
+        if (!in.ok || hash != HashFile(path.c_str()))
+            return false;
+    }
+
+    std::vector<Material *> materialTable;
+    for (uint32_t i = 0; i < header.materialCount && in.ok; i++)
+    {
+        Material *material = new Material();
+        material->name = in.readString();
+        material->ambient = readVec3(in);
+        material->diffuse = readVec3(in);
+        material->specular = readVec3(in);
+        material->shininess = in.read<float>();
+        material->diffuseMapPath = in.readString();
+
+        materialTable.push_back(material);
+        model.materials[material->name] = material;
+    }
+
+    // Views into the mapping for a merged upload once all meshes are known
+    std::vector<MeshData> uploads;
+
+    for (uint32_t i = 0; i < header.meshCount && in.ok; i++)
+    {
+        int32_t materialIndex = in.read<int32_t>();
+        uint32_t vertexCount = in.read<uint32_t>();
+        uint32_t indexCount = in.read<uint32_t>();
+        const char *vertexData = in.skipSection((size_t)vertexCount * sizeof(Vertex));
+        const char *indexData = in.skipSection((size_t)indexCount * sizeof(unsigned int));
+
+        Mesh mesh;
+        uint32_t lodCount = in.read<uint32_t>();
+        for (uint32_t l = 0; l < lodCount && in.ok; l++)
+        {
+            MeshLod lod;
+            lod.indexOffset = in.read<uint32_t>();
+            lod.indexCount = in.read<uint32_t>();
+            lod.error = in.read<float>();
+            mesh.lods.push_back(lod);
+        }
+        uint32_t lodIndexCount = in.read<uint32_t>();
+        const char *lodIndexData = in.skipSection((size_t)lodIndexCount * sizeof(unsigned int));
+        uint32_t tangentCount = in.read<uint32_t>();
+        const char *tangentData = in.skipSection((size_t)tangentCount * sizeof(glm::vec4));
+        if (!in.ok)
+            break;
+
+        if (materialIndex >= 0 && (size_t)materialIndex < materialTable.size())
+            mesh.material = materialTable[materialIndex];
+
+        MeshData data = {reinterpret_cast<const Vertex *>(vertexData), vertexCount,
+                         reinterpret_cast<const unsigned int *>(indexData), indexCount,
+                         reinterpret_cast<const unsigned int *>(lodIndexData), lodIndexCount};
+        if (!validMesh(data, mesh.lods, tangentCount))
+        {
+            in.ok = false;
+            break;
+        }
+        if (upload)
+        {
+            // Straight from the mapping into the GL buffers, no CPU copy is kept
+            if (model.mergeBuffers)
+                uploads.push_back(data);
+            else
+            {
+                timer.Pause();
+                uploadStart = std::chrono::steady_clock::now();
+                mesh.setupMesh(data);
+                uploadMs += LoadReport::MillisecondsSince(uploadStart);
+                timer.Resume();
+            }
+        }
+        else
+        {
+            mesh.vertices.assign(data.vertices, data.vertices + vertexCount);
+            mesh.indices.assign(data.indices, data.indices + indexCount);
+            mesh.lodIndices.assign(data.lodIndices, data.lodIndices + lodIndexCount);
+            const glm::vec4 *tangents = reinterpret_cast<const glm::vec4 *>(tangentData);
+            mesh.tangents.assign(tangents, tangents + tangentCount);
+            mesh.indexCount = indexCount;
+        }
+        model.meshes.push_back(std::move(mesh));
+    }
+
+    if (in.ok && !uploads.empty())
+    {
+        timer.Pause();
+        uploadStart = std::chrono::steady_clock::now();
+        model.AllocateBuffers(uploads);
+        for (size_t i = 0; i < uploads.size(); i++)
+            model.UploadMesh(i, uploads[i]);
+        uploadMs += LoadReport::MillisecondsSince(uploadStart);
+        timer.Resume();
+    }
+
+    if (!in.ok)
+    {
+        std::cerr << "Corrupt mesh cache for " << objFile << ", reloading from source" << std::endl;
+        model.Delete();
+        return false;
+    }
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (const Mesh &mesh : model.meshes)
+    {
+        vertexCount += mesh.vertices.size();
+        indexCount += mesh.indices.size() + mesh.lodIndices.size();
+    }
+    if (upload)
+    {
+        // Nothing was copied out of the mapping; count what went to the GPU
+        vertexCount = indexCount = 0;
+        for (const MeshData &data : uploads)
+        {
+            vertexCount += data.vertexCount;
+            indexCount += data.indexCount + data.lodIndexCount;
+        }
+        LoadReport::Shared().AddTime(objFile, "model", LoadReport::GL_UPLOAD, uploadMs);
+    }
+    LoadReport::Shared().AddCounts(objFile, "model", vertexCount, indexCount, file.size, upload ? model.BufferBytes() : 0);
+    return true;
+}
+
+bool MeshCache::Save(const char *objFile, uint32_t flags, uint32_t optionsKey, const Model &model,
+                     const std::vector<std::string> &dependencies)
+{
+    std::string path = CachePath(objFile, flags, optionsKey);
+    std::vector<char> tempPath(path.begin(), path.end());
+    const char tempSuffix[] = ".XXXXXX";
+    tempPath.insert(tempPath.end(), tempSuffix, tempSuffix + sizeof(tempSuffix));
+    int fd = mkstemp(tempPath.data());
+    if (fd < 0)
+        return false;
+    fchmod(fd, 0644); // mkstemp creates it private
+    FILE *out = fdopen(fd, "wb");
+    if (!out)
+    {
+        close(fd);
+        remove(tempPath.data());
+        return false;
+    }
+
+    std::vector<const Material *> materialTable;
+    for (const auto &pair : model.materials)
+        materialTable.push_back(pair.second);
+
+    CacheHeader header;
+    memcpy(header.magic, cacheMagic, 4);
+    header.version = version;
+    header.vertexSize = sizeof(Vertex);
+    header.flags = flags;
+    header.sourceHash = HashFile(objFile);
+    header.dependencyCount = dependencies.size();
+    header.materialCount = materialTable.size();
+    header.meshCount = model.meshes.size();
+    header.optionsKey = optionsKey;
+    write(out, header);
+
+    for (const std::string &dependency : dependencies)
+    {
+        writeString(out, dependency);
+        write<uint64_t>(out, HashFile(dependency.c_str()));
+    }
+
+    for (const Material *material : materialTable)
+    {
+        writeString(out, material->name);
+        writeVec3(out, material->ambient);
+        writeVec3(out, material->diffuse);
+        writeVec3(out, material->specular);
+        write(out, material->shininess);
+        writeString(out, material->diffuseMapPath);
+    }
+
+    for (const Mesh &mesh : model.meshes)
+    {
+        int32_t materialIndex = -1;
+        for (size_t i = 0; i < materialTable.size(); i++)
+            if (materialTable[i] == mesh.material)
+                materialIndex = (int32_t)i;
+
+        write<int32_t>(out, materialIndex);
+        write<uint32_t>(out, (uint32_t)mesh.vertices.size());
+        write<uint32_t>(out, (uint32_t)mesh.indices.size());
+        writeSectionPadding(out);
+        fwrite(mesh.vertices.data(), sizeof(Vertex), mesh.vertices.size(), out);
+        writeSectionPadding(out);
+        fwrite(mesh.indices.data(), sizeof(unsigned int), mesh.indices.size(), out);
+
+        write<uint32_t>(out, (uint32_t)mesh.lods.size());
+        for (const MeshLod &lod : mesh.lods)
+        {
+            write<uint32_t>(out, (uint32_t)lod.indexOffset);
+            write<uint32_t>(out, (uint32_t)lod.indexCount);
+            write(out, lod.error);
+        }
+        write<uint32_t>(out, (uint32_t)mesh.lodIndices.size());
+        writeSectionPadding(out);
+        fwrite(mesh.lodIndices.data(), sizeof(unsigned int), mesh.lodIndices.size(), out);
+        write<uint32_t>(out, (uint32_t)mesh.tangents.size());
+        writeSectionPadding(out);
+        fwrite(mesh.tangents.data(), sizeof(glm::vec4), mesh.tangents.size(), out);
+    }
+
+    bool ok = ferror(out) == 0;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok || rename(tempPath.data(), path.c_str()) != 0)
+    {
+        remove(tempPath.data());
+        return false;
+    }
+    return true;
+}
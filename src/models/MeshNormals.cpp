@@ -0,0 +1,394 @@
+#include "models/MeshNormals.h"
+#include "models/Model.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    // Triangles (or corners, or vertices) per ParallelFor task
+    const size_t blockSize = 4096;
+    const unsigned int none = ~0u;
+    // Triangles whose edges meet at a smaller sine than this have no normal
+    const float degenerateSine = 1e-6f;
+
+    // Runs fn(first, last) over [0, count) in blocks on the pool
+    template <typename Fn>
+    void forBlocks(ThreadPool &pool, size_t count, const Fn &fn)
+    {
+        pool.ParallelFor((count + blockSize - 1) / blockSize, [&](size_t block)
+        {
+            size_t first = block * blockSize;
+            fn(first, std::min(count, first + blockSize));
+        });
+    }
+
+    struct Vectors
+    {
+        std::vector<float> x, y, z;
+
+        void resize(size_t count)
+        {
+            x.assign(count, 0.0f);
+            y.assign(count, 0.0f);
+            z.assign(count, 0.0f);
+        }
+    };
+
+    void gatherPositions(const std::vector<Vertex> &vertices, Vectors &positions, ThreadPool &pool)
+    {
+        positions.resize(vertices.size());
+        forBlocks(pool, vertices.size(), [&](size_t first, size_t last)
+        {
+            for (size_t v = first; v < last; v++)
+            {
+                positions.x[v] = vertices[v].Position.x;
+                positions.y[v] = vertices[v].Position.y;
+                positions.z[v] = vertices[v].Position.z;
+            }
+        });
+    }
+
+    // Angle between two edges leaving a corner; 0 if either is degenerate
+    float cornerAngle(float ux, float uy, float uz, float vx, float vy, float vz)
+    {
+        float lengths = std::sqrt((ux * ux + uy * uy + uz * uz) * (vx * vx + vy * vy + vz * vz));
+        if (lengths <= 0.0f)
+            return 0.0f;
+        float cosine = (ux * vx + uy * vy + uz * vz) / lengths;
+        return std::acos(std::min(1.0f, std::max(-1.0f, cosine)));
+    }
+
+    // Unit face normals and the weight each corner gives its face: twice the
+    // area, or the corner angle. Both are zero for degenerate triangles.
+    void computeFaces(const Vectors &p, const std::vector<unsigned int> &indices, MeshNormals::Weighting weighting,
+                      Vectors &normals, std::vector<float> &weights, ThreadPool &pool)
+    {
+        size_t triangleCount = indices.size() / 3;
+        normals.resize(triangleCount);
+        weights.assign(triangleCount * 3, 0.0f);
+
+        forBlocks(pool, triangleCount, [&](size_t first, size_t last)
+        {
+            for (size_t t = first; t < last; t++)
+            {
+                unsigned int a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+                float e1x = p.x[b] - p.x[a], e1y = p.y[b] - p.y[a], e1z = p.z[b] - p.z[a];
+                float e2x = p.x[c] - p.x[a], e2y = p.y[c] - p.y[a], e2z = p.z[c] - p.z[a];
+                float nx = e1y * e2z - e1z * e2y;
+                float ny = e1z * e2x - e1x * e2z;
+                float nz = e1x * e2y - e1y * e2x;
+                float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+                float edges = std::sqrt((e1x * e1x + e1y * e1y + e1z * e1z) * (e2x * e2x + e2y * e2y + e2z * e2z));
+                // Slivers' normals are rounding noise; treat them as degenerate
+                if (length <= degenerateSine * edges)
+                    continue;
+                float inverse = 1.0f / length;
+                normals.x[t] = nx * inverse;
+                normals.y[t] = ny * inverse;
+                normals.z[t] = nz * inverse;
+
+                if (weighting == MeshNormals::AREA_WEIGHTED)
+                {
+                    weights[t * 3] = weights[t * 3 + 1] = weights[t * 3 + 2] = length;
+                    continue;
+                }
+                float e3x = p.x[c] - p.x[b], e3y = p.y[c] - p.y[b], e3z = p.z[c] - p.z[b];
+                weights[t * 3] = cornerAngle(e1x, e1y, e1z, e2x, e2y, e2z);
+                weights[t * 3 + 1] = cornerAngle(-e1x, -e1y, -e1z, e3x, e3y, e3z);
+                weights[t * 3 + 2] = cornerAngle(-e2x, -e2y, -e2z, -e3x, -e3y, -e3z);
+            }
+        });
+    }
+
+    // Numbers distinct positions; vertices with equal positions (as the
+    // loader makes for corners sharing an OBJ "v") get the same id
+    std::vector<unsigned int> weldPositions(const Vectors &p, size_t &positionCount)
+    {
+        size_t count = p.x.size();
+        size_t capacity = 16;
+        while (capacity < count * 2)
+            capacity <<= 1;
+        std::vector<unsigned int> table(capacity, none);
+        std::vector<unsigned int> ids(count);
+        positionCount = 0;
+
+        for (size_t v = 0; v < count; v++)
+        {
+            // + 0.0f so -0 and 0 hash alike; they compare equal below
+            float key[3] = {p.x[v] + 0.0f, p.y[v] + 0.0f, p.z[v] + 0.0f};
+            uint32_t bits[3];
+            memcpy(bits, key, sizeof(bits));
+            uint64_t h = (bits[0] * 0x9E3779B97F4A7C15ull) ^ (bits[1] * 0xC2B2AE3D27D4EB4Full) ^ (bits[2] * 0x165667B19E3779F9ull);
+            size_t slot = (size_t)(h ^ (h >> 29)) & (capacity - 1);
+
+            while (true)
+            {
+                unsigned int other = table[slot];
+                if (other == none)
+                {
+                    table[slot] = (unsigned int)v;
+                    ids[v] = (unsigned int)positionCount++;
+                    break;
+                }
+                if (p.x[other] == p.x[v] && p.y[other] == p.y[v] && p.z[other] == p.z[v])
+                {
+                    ids[v] = ids[other];
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+        return ids;
+    }
+
+    // Corners bucketed by a key per corner, in corner order within a bucket:
+    // bucket k is list[start[k] .. start[k + 1])
+    struct CornerBuckets
+    {
+        std::vector<unsigned int> start;
+        std::vector<unsigned int> list;
+    };
+
+    template <typename KeyOf>
+    void bucketCorners(size_t cornerCount, size_t keyCount, const KeyOf &keyOf, CornerBuckets &buckets)
+    {
+        buckets.start.assign(keyCount + 1, 0);
+        for (size_t c = 0; c < cornerCount; c++)
+            buckets.start[keyOf(c) + 1]++;
+        for (size_t k = 0; k < keyCount; k++)
+            buckets.start[k + 1] += buckets.start[k];
+
+        std::vector<unsigned int> fill(buckets.start.begin(), buckets.start.end() - 1);
+        buckets.list.resize(cornerCount);
+        for (size_t c = 0; c < cornerCount; c++)
+            buckets.list[fill[keyOf(c)]++] = (unsigned int)c;
+    }
+
+    glm::vec3 anyPerpendicular(const glm::vec3 &normal)
+    {
+        glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 tangent = glm::cross(normal, axis);
+        float length = glm::length(tangent);
+        return length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+    }
+}
+
+size_t MeshNormals::GenerateNormals(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                    float creaseAngle, Weighting weighting, ThreadPool &pool)
+{
+    const size_t vertexCount = vertices.size();
+    const size_t cornerCount = indices.size() - indices.size() % 3;
+
+    std::vector<uint8_t> missing(vertexCount);
+    size_t missingCount = 0;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        missing[v] = vertices[v].Normal == glm::vec3(0.0f);
+        missingCount += missing[v];
+    }
+    if (missingCount == 0)
+        return 0;
+
+    Vectors positions, faceNormals;
+    std::vector<float> weights;
+    gatherPositions(vertices, positions, pool);
+    computeFaces(positions, indices, weighting, faceNormals, weights, pool);
+
+    size_t positionCount;
+    std::vector<unsigned int> positionIds = weldPositions(positions, positionCount);
+    CornerBuckets around;
+    bucketCorners(cornerCount, positionCount, [&](size_t c) { return positionIds[indices[c]]; }, around);
+
+    // Each corner sums the faces around its position that are within the
+    // crease angle of its own face; a degenerate own face takes them all
+    float cosCrease = std::cos(glm::radians(std::min(180.0f, std::max(0.0f, creaseAngle))));
+    Vectors cornerNormals;
+    cornerNormals.resize(cornerCount);
+    forBlocks(pool, cornerCount, [&](size_t first, size_t last)
+    {
+        for (size_t c = first; c < last; c++)
+        {
+            if (!missing[indices[c]])
+                continue;
+
+            size_t t = c / 3;
+            float ox = faceNormals.x[t], oy = faceNormals.y[t], oz = faceNormals.z[t];
+            bool degenerate = ox == 0.0f && oy == 0.0f && oz == 0.0f;
+            float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+
+            unsigned int position = positionIds[indices[c]];
+            for (unsigned int k = around.start[position]; k < around.start[position + 1]; k++)
+            {
+                unsigned int other = around.list[k];
+                size_t u = other / 3;
+                float fx = faceNormals.x[u], fy = faceNormals.y[u], fz = faceNormals.z[u];
+                if (!degenerate && ox * fx + oy * fy + oz * fz < cosCrease)
+                    continue;
+                float w = weights[other];
+                sx += w * fx;
+                sy += w * fy;
+                sz += w * fz;
+            }
+
+            float length = std::sqrt(sx * sx + sy * sy + sz * sz);
+            if (length > 0.0f)
+            {
+                cornerNormals.x[c] = sx / length;
+                cornerNormals.y[c] = sy / length;
+                cornerNormals.z[c] = sz / length;
+            }
+            else
+                cornerNormals.y[c] = 1.0f;
+        }
+    });
+
+    // A vertex takes its first corner's normal; corners that disagree (across
+    // a crease) move to a copy with their normal, shared where they agree
+    std::vector<unsigned int> nextCopy(vertexCount, none);
+    std::vector<uint8_t> assigned(vertexCount, 0);
+    for (size_t c = 0; c < cornerCount; c++)
+    {
+        unsigned int v = indices[c];
+        if (!missing[v])
+            continue;
+
+        glm::vec3 normal(cornerNormals.x[c], cornerNormals.y[c], cornerNormals.z[c]);
+        if (!assigned[v])
+        {
+            vertices[v].Normal = normal;
+            assigned[v] = 1;
+            continue;
+        }
+
+        unsigned int candidate = v;
+        while (vertices[candidate].Normal != normal)
+        {
+            if (nextCopy[candidate] == none)
+            {
+                Vertex copy = vertices[v];
+                copy.Normal = normal;
+                nextCopy[candidate] = (unsigned int)vertices.size();
+                vertices.push_back(copy);
+                nextCopy.push_back(none);
+            }
+            candidate = nextCopy[candidate];
+        }
+        indices[c] = candidate;
+    }
+
+    // Vertices no triangle uses
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (missing[v] && !assigned[v])
+            vertices[v].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    return missingCount;
+}
+
+void MeshNormals::GenerateTangents(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                   std::vector<glm::vec4> &tangents, ThreadPool &pool)
+{
+    const size_t triangleCount = indices.size() / 3;
+    const size_t cornerCount = triangleCount * 3;
+
+    // Per corner: the triangle's UV-gradient tangent projected into the
+    // corner normal's plane and weighted by the corner angle in that plane;
+    // per triangle: its handedness (+1/-1, 0 for degenerate UVs)
+    Vectors cornerTangents;
+    cornerTangents.resize(cornerCount);
+    std::vector<int8_t> handedness(triangleCount, 0);
+
+    forBlocks(pool, triangleCount, [&](size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            const Vertex *corner[3] = {&vertices[indices[t * 3]], &vertices[indices[t * 3 + 1]],
+                                       &vertices[indices[t * 3 + 2]]};
+            glm::vec3 e1 = corner[1]->Position - corner[0]->Position;
+            glm::vec3 e2 = corner[2]->Position - corner[0]->Position;
+            glm::vec2 d1 = corner[1]->TexCoords - corner[0]->TexCoords;
+            glm::vec2 d2 = corner[2]->TexCoords - corner[0]->TexCoords;
+
+            // Twice the signed UV area; its sign is the handedness
+            float area = d1.x * d2.y - d1.y * d2.x;
+            glm::vec3 direction = e1 * d2.y - e2 * d1.y;
+            if (area == 0.0f || glm::dot(direction, direction) == 0.0f)
+                continue;
+            if (area < 0.0f)
+                direction = -direction;
+            handedness[t] = area > 0.0f ? 1 : -1;
+
+            for (int k = 0; k < 3; k++)
+            {
+                const glm::vec3 &normal = corner[k]->Normal;
+                glm::vec3 projected = direction - normal * glm::dot(normal, direction);
+                float length = glm::length(projected);
+                if (length <= 0.0f)
+                    continue;
+
+                glm::vec3 toNext = corner[(k + 1) % 3]->Position - corner[k]->Position;
+                glm::vec3 toPrevious = corner[(k + 2) % 3]->Position - corner[k]->Position;
+                toNext -= normal * glm::dot(normal, toNext);
+                toPrevious -= normal * glm::dot(normal, toPrevious);
+                float weight = cornerAngle(toNext.x, toNext.y, toNext.z, toPrevious.x, toPrevious.y, toPrevious.z);
+
+                size_t c = t * 3 + k;
+                cornerTangents.x[c] = projected.x / length * weight;
+                cornerTangents.y[c] = projected.y / length * weight;
+                cornerTangents.z[c] = projected.z / length * weight;
+            }
+        }
+    });
+
+    // A vertex takes the handedness of its first textured corner; corners of
+    // the other handedness move to a copy. Degenerate corners stay put.
+    const size_t vertexCount = vertices.size();
+    std::vector<int8_t> vertexHandedness(vertexCount, 0);
+    std::vector<unsigned int> mirrored(vertexCount, none);
+    for (size_t c = 0; c < cornerCount; c++)
+    {
+        int8_t side = handedness[c / 3];
+        unsigned int v = indices[c];
+        if (side == 0 || vertexHandedness[v] == side)
+            continue;
+        if (vertexHandedness[v] == 0)
+        {
+            vertexHandedness[v] = side;
+            continue;
+        }
+        if (mirrored[v] == none)
+        {
+            mirrored[v] = (unsigned int)vertices.size();
+            vertices.push_back(vertices[v]);
+            vertexHandedness.push_back(side);
+        }
+        indices[c] = mirrored[v];
+    }
+
+    CornerBuckets uses;
+    bucketCorners(cornerCount, vertices.size(), [&](size_t c) { return indices[c]; }, uses);
+
+    tangents.assign(vertices.size(), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    forBlocks(pool, vertices.size(), [&](size_t first, size_t last)
+    {
+        for (size_t v = first; v < last; v++)
+        {
+            glm::vec3 sum(0.0f);
+            for (unsigned int k = uses.start[v]; k < uses.start[v + 1]; k++)
+            {
+                unsigned int c = uses.list[k];
+                sum += glm::vec3(cornerTangents.x[c], cornerTangents.y[c], cornerTangents.z[c]);
+            }
+
+            const glm::vec3 &normal = vertices[v].Normal;
+            glm::vec3 tangent = sum - normal * glm::dot(normal, sum);
+            float length = glm::length(tangent);
+            tangent = length > 0.0f ? tangent / length : anyPerpendicular(normal);
+            tangents[v] = glm::vec4(tangent, vertexHandedness[v] < 0 ? -1.0f : 1.0f);
+        }
+    });
+}
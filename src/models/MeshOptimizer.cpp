@@ -0,0 +1,604 @@
+#include "models/MeshOptimizer.h"
+#include "models/Model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+    // Tuning from Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    const int scoringCacheSize = 32;
+    const float cacheDecayPower = 1.5f;
+    const float lastTriangleScore = 0.75f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+    const unsigned int valenceTableSize = 64;
+
+    struct ScoreTables
+    {
+        float cache[scoringCacheSize];
+        float valence[valenceTableSize];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < scoringCacheSize; i++)
+            {
+                if (i < 3)
+                    cache[i] = lastTriangleScore;
+                else
+                    cache[i] = powf(1.0f - float(i - 3) / float(scoringCacheSize - 3), cacheDecayPower);
+            }
+            valence[0] = 0.0f;
+            for (unsigned int i = 1; i < valenceTableSize; i++)
+                valence[i] = valenceBoostScale * powf(float(i), -valenceBoostPower);
+        }
+    };
+
+    float vertexScore(const ScoreTables &tables, int cachePosition, unsigned int remaining)
+    {
+        // No triangles left to draw: never worth picking
+        if (remaining == 0)
+            return -1.0f;
+
+        float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+        if (remaining < valenceTableSize)
+            score += tables.valence[remaining];
+        else
+            score += valenceBoostScale * powf(float(remaining), -valenceBoostPower);
+        return score;
+    }
+
+    // Sum of squared distances to a set of area-weighted planes
+    struct Quadric
+    {
+        double a00, a11, a22, a01, a02, a12;
+        double b0, b1, b2;
+        double c;
+        double weight;
+    };
+
+    void addPlane(Quadric &q, const glm::dvec3 &n, double d, double weight)
+    {
+        q.a00 += weight * n.x * n.x;
+        q.a11 += weight * n.y * n.y;
+        q.a22 += weight * n.z * n.z;
+        q.a01 += weight * n.x * n.y;
+        q.a02 += weight * n.x * n.z;
+        q.a12 += weight * n.y * n.z;
+        q.b0 += weight * n.x * d;
+        q.b1 += weight * n.y * d;
+        q.b2 += weight * n.z * d;
+        q.c += weight * d * d;
+        q.weight += weight;
+    }
+
+    void addQuadric(Quadric &q, const Quadric &other)
+    {
+        q.a00 += other.a00;
+        q.a11 += other.a11;
+        q.a22 += other.a22;
+        q.a01 += other.a01;
+        q.a02 += other.a02;
+        q.a12 += other.a12;
+        q.b0 += other.b0;
+        q.b1 += other.b1;
+        q.b2 += other.b2;
+        q.c += other.c;
+        q.weight += other.weight;
+    }
+
+    // Mean squared plane distance of p, so the error reads as a distance^2
+    // independent of how much area was merged into the quadric
+    double quadricError(const Quadric &q, const glm::dvec3 &p)
+    {
+        double e = q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+                   2.0 * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+                   2.0 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+        return q.weight > 0.0 ? fabs(e) / q.weight : 0.0;
+    }
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                            unsigned int cacheSize)
+{
+    CacheStats stats = {};
+    stats.triangles = indices.size() / 3;
+
+    // A vertex is cached if fewer than cacheSize misses happened since its own
+    std::vector<unsigned int> missStamp(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<bool> seen(vertexCount, false);
+
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+            continue;
+        if (!seen[index])
+        {
+            seen[index] = true;
+            stats.vertices++;
+        }
+        if (time - missStamp[index] > cacheSize)
+        {
+            missStamp[index] = time++;
+            stats.transformed++;
+        }
+    }
+
+    stats.acmr = stats.triangles ? float(stats.transformed) / float(stats.triangles) : 0.0f;
+    stats.atvr = stats.vertices ? float(stats.transformed) / float(stats.vertices) : 0.0f;
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    static const ScoreTables tables;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Per-vertex lists of the triangles still to be emitted, packed into one
+    // array; remaining[v] is the live prefix of vertex v's slice
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+
+    std::vector<size_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            adjacency[adjacencyOffset[v] + filled[v]++] = (unsigned int)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(tables, -1, remaining[v]);
+
+    // Start from the best-scoring triangle of the whole mesh
+    size_t bestTriangle = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+                      vertexScores[indices[t * 3 + 2]];
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(scoringCacheSize + 3);
+    nextCache.reserve(scoringCacheSize + 3);
+
+    size_t inputCursor = 0;
+
+    while (output.size() < triangleCount * 3)
+    {
+        // Nothing adjacent to the cache left: continue in input order
+        if (bestTriangle == triangleCount)
+        {
+            while (emitted[inputCursor])
+                inputCursor++;
+            bestTriangle = inputCursor;
+        }
+
+        const unsigned int *corners = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = corners[k];
+            output.push_back(v);
+
+            // Drop the triangle from the vertex's live list
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            unsigned int *end = begin + remaining[v];
+            unsigned int *found = std::find(begin, end, (unsigned int)bestTriangle);
+            std::swap(*found, *(end - 1));
+            remaining[v]--;
+
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        }
+
+        // The new triangle's vertices move to the front, the rest shift back
+        for (unsigned int v : cache)
+        {
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        }
+
+        for (size_t i = 0; i < nextCache.size(); i++)
+        {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < (size_t)scoringCacheSize ? (int)i : -1;
+            vertexScores[v] = vertexScore(tables, cachePosition[v], remaining[v]);
+        }
+        if (nextCache.size() > (size_t)scoringCacheSize)
+            nextCache.resize(scoringCacheSize);
+        cache.swap(nextCache);
+
+        // Rescore only triangles touching the cache; the best becomes next
+        bestTriangle = triangleCount;
+        bestScore = -1.0f;
+        for (unsigned int v : cache)
+        {
+            const unsigned int *live = &adjacency[adjacencyOffset[v]];
+            for (unsigned int i = 0; i < remaining[v]; i++)
+            {
+                unsigned int t = live[i];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+                              vertexScores[indices[t * 3 + 2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                     float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    const unsigned int cacheSize = statsCacheSize;
+    std::vector<unsigned int> missStamp(vertices.size(), 0);
+    unsigned int time = cacheSize + 1;
+
+    auto missesOf = [&](size_t t)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - missStamp[v] > cacheSize)
+            {
+                missStamp[v] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+
+    // Hard cluster starts: triangles missing the cache on all three vertices,
+    // where the cache optimizer restarted anyway
+    std::vector<size_t> hardStart;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (missesOf(t) == 3 || t == 0)
+            hardStart.push_back(t);
+    }
+    hardStart.push_back(triangleCount);
+
+    // Soft starts inside each hard cluster: wherever the part so far, simulated
+    // from a cold cache, is already within `threshold` of the whole cluster's
+    // ACMR. Each resulting cluster then costs about the same drawn in any order.
+    std::vector<size_t> clusterStart;
+    for (size_t h = 0; h + 1 < hardStart.size(); h++)
+    {
+        size_t begin = hardStart[h], end = hardStart[h + 1];
+
+        time += cacheSize + 1;
+        size_t hardMisses = 0;
+        for (size_t t = begin; t < end; t++)
+            hardMisses += missesOf(t);
+        float targetAcmr = threshold * float(hardMisses) / float(end - begin);
+
+        time += cacheSize + 1;
+        clusterStart.push_back(begin);
+        size_t clusterMisses = 0, clusterTriangles = 0;
+        for (size_t t = begin; t < end; t++)
+        {
+            clusterMisses += missesOf(t);
+            clusterTriangles++;
+            if (t + 1 < end && float(clusterMisses) <= targetAcmr * float(clusterTriangles))
+            {
+                clusterStart.push_back(t + 1);
+                time += cacheSize + 1;
+                clusterMisses = 0;
+                clusterTriangles = 0;
+            }
+        }
+    }
+    clusterStart.push_back(triangleCount);
+    size_t clusterCount = clusterStart.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    // Area-weighted centroid and normal of each cluster and of the whole mesh
+    std::vector<glm::vec3> centroids(clusterCount), normals(clusterCount);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3]].Position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &c2 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 cross = glm::cross(b - a, c2 - a);
+            float triangleArea = glm::length(cross);
+            centroid += (a + b + c2) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        centroids[c] = area > 0.0f ? centroid / area : vertices[indices[clusterStart[c] * 3]].Position;
+        normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+        meshCentroid += centroid;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the mesh centre are the outer surfaces
+    std::vector<float> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (size_t c : order)
+        output.insert(output.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int unassigned = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unassigned);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == unassigned)
+        {
+            remap[index] = (unsigned int)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(ordered);
+}
+
+std::vector<unsigned int> MeshOptimizer::Simplify(const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                                  size_t targetIndexCount, float targetError, float *resultError)
+{
+    std::vector<unsigned int> result(indices.begin(), indices.end() - indices.size() % 3);
+    if (resultError)
+        *resultError = 0.0f;
+
+    size_t vertexCount = vertices.size();
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Positions scaled so the largest extent is 1, which makes errors relative
+    glm::vec3 minimum = vertices[0].Position, maximum = vertices[0].Position;
+    for (const Vertex &vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    glm::vec3 extent = maximum - minimum;
+    double scale = std::max(extent.x, std::max(extent.y, extent.z));
+    if (scale <= 0.0)
+        return result;
+
+    std::vector<glm::dvec3> positions(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        positions[v] = glm::dvec3(vertices[v].Position - minimum) / scale;
+
+    // Every triangle's plane goes into the quadrics of its three corners
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::dvec3 &p0 = positions[result[i]];
+        glm::dvec3 normal = glm::cross(positions[result[i + 1]] - p0, positions[result[i + 2]] - p0);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        double d = -glm::dot(normal, p0);
+        for (int k = 0; k < 3; k++)
+            addPlane(quadrics[result[i + k]], normal, d, length * 0.5);
+    }
+
+    std::vector<size_t> adjacencyOffset(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    auto buildAdjacency = [&]()
+    {
+        std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+        for (unsigned int index : result)
+            adjacencyOffset[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        adjacency.resize(result.size());
+        std::vector<size_t> filled(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < result.size() / 3; t++)
+        {
+            for (int k = 0; k < 3; k++)
+                adjacency[filled[result[t * 3 + k]]++] = (unsigned int)t;
+        }
+    };
+
+    // An edge no triangle uses in the opposite direction is an open border or
+    // an attribute seam (the far side uses split vertices); its vertices are
+    // locked
+    buildAdjacency();
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+            bool twin = false;
+            for (size_t j = adjacencyOffset[b]; j < adjacencyOffset[b + 1] && !twin; j++)
+            {
+                const unsigned int *corners = &result[adjacency[j] * 3];
+                for (int m = 0; m < 3; m++)
+                    twin = twin || (corners[m] == b && corners[(m + 1) % 3] == a);
+            }
+            if (!twin)
+                locked[a] = locked[b] = true;
+        }
+    }
+
+    double errorLimit = double(targetError) * double(targetError);
+    double maxError = 0.0;
+
+    std::vector<Collapse> collapses;
+    std::vector<Collapse> best(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    // Passes of independent collapses, cheapest first, until the target count
+    // or the error limit is reached
+    while (result.size() > targetIndexCount)
+    {
+        size_t triangleCount = result.size() / 3;
+        buildAdjacency();
+
+        // Each directed edge proposes collapsing its start onto its end, so an
+        // interior edge is tried both ways; every vertex keeps its cheapest
+        const unsigned int none = ~0u;
+        for (size_t v = 0; v < vertexCount; v++)
+            best[v] = {(unsigned int)v, none, 0.0};
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int from = result[i + k], to = result[i + (k + 1) % 3];
+                if (locked[from])
+                    continue;
+                Quadric q = quadrics[from];
+                addQuadric(q, quadrics[to]);
+                double cost = quadricError(q, positions[to]);
+                if (best[from].to == none || cost < best[from].cost)
+                    best[from] = {from, to, cost};
+            }
+        }
+        collapses.clear();
+        for (const Collapse &collapse : best)
+        {
+            if (collapse.to != none && collapse.cost <= errorLimit)
+                collapses.push_back(collapse);
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+        for (size_t v = 0; v < vertexCount; v++)
+            remap[v] = (unsigned int)v;
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t remaining = triangleCount;
+        size_t applied = 0;
+        for (const Collapse &collapse : collapses)
+        {
+            if (collapse.cost > errorLimit || remaining * 3 <= targetIndexCount)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Reject collapses that fold a surviving triangle over
+            bool flips = false;
+            size_t removed = 0;
+            for (size_t a = adjacencyOffset[collapse.from]; a < adjacencyOffset[collapse.from + 1] && !flips; a++)
+            {
+                const unsigned int *corners = &result[adjacency[a] * 3];
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                glm::dvec3 p[3], q[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = positions[corners[k]];
+                    q[k] = corners[k] == collapse.from ? positions[collapse.to] : p[k];
+                }
+                glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::dvec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                if (glm::dot(before, after) <= 0.25 * glm::length(before) * glm::length(after))
+                    flips = true;
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            maxError = std::max(maxError, collapse.cost);
+            remaining -= removed;
+            applied++;
+
+            // Keep the one-ring fixed for the rest of the pass so no triangle
+            // sees two collapses whose flip checks assumed the other's absence
+            touched[collapse.to] = true;
+            for (size_t a = adjacencyOffset[collapse.from]; a < adjacencyOffset[collapse.from + 1]; a++)
+            {
+                for (int k = 0; k < 3; k++)
+                    touched[result[adjacency[a] * 3 + k]] = true;
+            }
+        }
+
+        if (applied == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = float(sqrt(maxError));
+    return result;
+}
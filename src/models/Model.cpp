@@ -1,61 +1,351 @@
 #include "models/Model.h"
+#include "models/ObjTokenizer.h"
+#include "models/MeshCache.h"
+#include "models/ObjChunkParser.h"
+#include "models/MeshOptimizer.h"
+#include "MappedFile.h"
+#include "VertexPacking.h"
+#include "ThreadPool.h"
+#include "ResourceCache.h"
+#include "TextureArray.h"
+#include "TextureStreamer.h"
+#include "RenderStats.h"
+#include "LoadReport.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // Load options that change the cached output
+    uint32_t meshCacheFlags(const ModelLoadOptions &options)
+    {
+        uint32_t flags = 0;
+        if (options.optimizeMeshes)
+            flags |= MeshCache::OPTIMIZED_VERTEX_ORDER;
+        if (options.optimizeMeshes && options.optimizeOverdraw)
+            flags |= MeshCache::OPTIMIZED_OVERDRAW;
+        if (options.generateLods)
+            flags |= MeshCache::GENERATED_LODS;
+        if (options.generateTangents)
+            flags |= MeshCache::GENERATED_TANGENTS;
+        return flags;
+    }
+
+    // Normal and LOD settings the cached meshes were built with
+    uint32_t meshCacheOptionsKey(const ModelLoadOptions &options)
+    {
+        uint32_t key = 0;
+        if (options.generateNormals)
+        {
+            uint32_t bits;
+            memcpy(&bits, &options.creaseAngle, sizeof(bits));
+            key = (1u ^ bits ^ ((uint32_t)options.normalWeighting << 1)) * 0x9E3779B1u;
+        }
+        if (!options.generateLods)
+            return key;
+        key ^= options.lodLevels;
+        for (float value : {options.lodReduction, options.lodMaxError})
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            key = (key ^ bits) * 0x9E3779B1u;
+        }
+        return key;
+    }
+
+    void linkVertexAttributes(VAO &vao, VBO &vbo, bool packed)
+    {
+        if (packed)
+        {
+            vao.LinkVBOAttrib(vbo, 0, 3, GL_UNSIGNED_SHORT, sizeof(PackedVertex), (void *)(offsetof(PackedVertex, position)), GL_TRUE);
+
+            vao.LinkVBOAttrib(vbo, 1, 2, GL_SHORT, sizeof(PackedVertex), (void *)(offsetof(PackedVertex, normal)), GL_TRUE);
+
+            vao.LinkVBOAttrib(vbo, 2, 2, GL_HALF_FLOAT, sizeof(PackedVertex), (void *)(offsetof(PackedVertex, texCoords)));
+        }
+        else
+        {
+            vao.LinkVBOAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void *)0);
+
+            vao.LinkVBOAttrib(vbo, 1, 3, GL_FLOAT, sizeof(Vertex), (void *)(offsetof(Vertex, Normal)));
+
+            vao.LinkVBOAttrib(vbo, 2, 2, GL_FLOAT, sizeof(Vertex), (void *)(offsetof(Vertex, TexCoords)));
+        }
+    }
+
+    // A mesh's full index list followed by its LOD lists, as T
+    template <typename T>
+    std::vector<T> gatherIndices(const MeshData &data)
+    {
+        std::vector<T> gathered(data.indexCount + data.lodIndexCount);
+        std::copy(data.indices, data.indices + data.indexCount, gathered.begin());
+        std::copy(data.lodIndices, data.lodIndices + data.lodIndexCount, gathered.begin() + data.indexCount);
+        return gathered;
+    }
+
+    // Uniforms of shaders/texture.* the draw paths set
+    struct DrawUniforms
+    {
+        Shader::UniformHandle texLayer, tex0, texArray, materialDiffuse, specularStrength;
+        Shader::UniformHandle packedNormals, positionOffset, positionScale;
+        Shader::UniformHandle time;
+
+        DrawUniforms()
+            : texLayer(Shader::Uniform("texLayer")), tex0(Shader::Uniform("tex0")),
+              texArray(Shader::Uniform("texArray")), materialDiffuse(Shader::Uniform("materialDiffuse")),
+              specularStrength(Shader::Uniform("specularStrength")), packedNormals(Shader::Uniform("packedNormals")),
+              positionOffset(Shader::Uniform("positionOffset")), positionScale(Shader::Uniform("positionScale")),
+              time(Shader::Uniform("time")) {}
+    };
+
+    const DrawUniforms &drawUniforms()
+    {
+        static DrawUniforms uniforms;
+        return uniforms;
+    }
+
+    // Largest axis scale of a transform, for screen-space error
+    float largestScale(const glm::mat4 &model)
+    {
+        return std::max(glm::length(glm::vec3(model[0])),
+                        std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    }
+
+    // Pixels covered by one model unit at view distance 1 in the current
+    // viewport: the distance-independent part of the screen-space error
+    float viewportPixelsPerUnit(const glm::mat4 &projection)
+    {
+        GLint viewport[4] = {0, 0, window::width, window::height};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        RenderStats::Frame().otherCalls++;
+        return projection[1][1] * viewport[3] * 0.5f;
+    }
+
+    // `transform` turned about its y axis as a SPINNING variant turns it
+    glm::mat4 spun(const glm::mat4 &transform, const glm::vec2 &spin, float time)
+    {
+        float turns = time * spin.x + spin.y;
+        return glm::rotate(transform, glm::radians(360.0f * (turns - std::floor(turns))), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
+
+std::string ModelLoadOptions::Key() const
+{
+    char key[64];
+    snprintf(key, sizeof(key), "%08x:%08x:%d%d", meshCacheFlags(*this), meshCacheOptionsKey(*this), mergeBuffers ? 1 : 0,
+             textureArrays ? 1 : 0);
+    return key;
+}
+
+MeshData Mesh::Data() const
+{
+    MeshData data = {vertices.data(), vertices.size(), indices.data(), indices.size(), lodIndices.data(), lodIndices.size()};
+    return data;
+}
+
+void Mesh::computeBounds(const MeshData &data)
+{
+    if (data.vertexCount == 0)
+        return;
+
+    glm::vec3 minimum = data.vertices[0].Position, maximum = data.vertices[0].Position;
+    for (size_t i = 1; i < data.vertexCount; i++)
+    {
+        minimum = glm::min(minimum, data.vertices[i].Position);
+        maximum = glm::max(maximum, data.vertices[i].Position);
+    }
+    boundsCenter = (minimum + maximum) * 0.5f;
+    boundsRadius = glm::length(maximum - minimum) * 0.5f;
+
+    if (!material || material->diffuseMapPath.empty() || !TextureStreamer::Shared().Enabled())
+        return;
+    // Twice the triangle areas on both sides; the factors cancel
+    double uvArea = 0.0, area = 0.0;
+    for (size_t i = 0; i + 2 < data.indexCount; i += 3)
+    {
+        const Vertex &a = data.vertices[data.indices[i]];
+        const Vertex &b = data.vertices[data.indices[i + 1]];
+        const Vertex &c = data.vertices[data.indices[i + 2]];
+        glm::vec2 uv1 = b.TexCoords - a.TexCoords, uv2 = c.TexCoords - a.TexCoords;
+        uvArea += std::fabs(uv1.x * uv2.y - uv1.y * uv2.x);
+        area += glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+    }
+    uvDensity = area > 0.0 ? (float)std::sqrt(uvArea / area) : 0.0f;
+}
 
 void Mesh::setupMesh()
 {
-    meshVAO.Bind();
+    setupMesh(Data());
+}
 
-    meshVBO = new VBO((GLfloat *)vertices.data(), vertices.size() * sizeof(Vertex));
-    meshEBO = new EBO(indices.data(), indices.size() * sizeof(unsigned int));
+void Mesh::setupMesh(const MeshData &data)
+{
+    computeBounds(data);
 
-    meshVAO.LinkVBOAttrib(*meshVBO, 0, 3, GL_FLOAT, sizeof(Vertex), (void *)0);
-    
-    meshVAO.LinkVBOAttrib(*meshVBO, 1, 3, GL_FLOAT, sizeof(Vertex), (void *)(offsetof(Vertex, Normal)));
-    
-    meshVAO.LinkVBOAttrib(*meshVBO, 2, 2, GL_FLOAT, sizeof(Vertex), (void *)(offsetof(Vertex, TexCoords)));
+    meshVAO = new VAO();
+    meshVAO->Bind();
 
-    meshVAO.Unbind();
+    if (packed)
+    {
+        std::vector<PackedVertex> packedVertices = VertexPacking::PackVertices(data.vertices, data.vertexCount, positionOffset, positionScale);
+        meshVBO = new VBO((GLfloat *)packedVertices.data(), packedVertices.size() * sizeof(PackedVertex));
+        bufferBytes = packedVertices.size() * sizeof(PackedVertex);
+    }
+    else
+    {
+        meshVBO = new VBO((GLfloat *)data.vertices, data.vertexCount * sizeof(Vertex));
+        bufferBytes = data.vertexCount * sizeof(Vertex);
+        positionOffset = glm::vec3(0.0f);
+        positionScale = glm::vec3(1.0f);
+    }
+    linkVertexAttributes(*meshVAO, *meshVBO, packed);
+
+    // The LOD index lists go right after the full one in the same buffer
+    indexCount = data.indexCount;
+    indexType = packed && data.vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    size_t totalIndices = data.indexCount + data.lodIndexCount;
+    if (indexType == GL_UNSIGNED_SHORT)
+    {
+        std::vector<GLushort> shortIndices = gatherIndices<GLushort>(data);
+        meshEBO = new EBO((GLuint *)shortIndices.data(), totalIndices * sizeof(GLushort));
+        bufferBytes += totalIndices * sizeof(GLushort);
+    }
+    else if (data.lodIndexCount > 0)
+    {
+        std::vector<GLuint> allIndices = gatherIndices<GLuint>(data);
+        meshEBO = new EBO(allIndices.data(), totalIndices * sizeof(GLuint));
+        bufferBytes += totalIndices * sizeof(GLuint);
+    }
+    else
+    {
+        meshEBO = new EBO((GLuint *)data.indices, data.indexCount * sizeof(GLuint));
+        bufferBytes += data.indexCount * sizeof(GLuint);
+    }
+
+    meshVAO->Unbind();
     meshVBO->Unbind();
     meshEBO->Unbind();
+    resident = true;
+}
+
+size_t Mesh::TriangleCount(size_t level) const
+{
+    if (level == 0 || lods.empty())
+        return (indices.empty() ? indexCount : indices.size()) / 3;
+    return lods[std::min(level, lods.size()) - 1].indexCount / 3;
 }
 
-void Mesh::Draw(Shader &shader)
+void Mesh::LevelRange(size_t level, size_t &first, size_t &count) const
 {
-    if (material)
+    first = 0;
+    count = indexCount;
+    if (level > 0 && !lods.empty())
     {
-        if (material->diffuseMap != nullptr)
+        const MeshLod &lod = lods[std::min(level, lods.size()) - 1];
+        first = lod.indexOffset;
+        count = lod.indexCount;
+    }
+}
+
+void Mesh::ApplyMaterial(Shader &shader)
+{
+    const TextureArray *boundArray = nullptr;
+    ApplyMaterial(shader, boundArray);
+}
+
+void Mesh::ApplyMaterial(Shader &shader, const TextureArray *&boundArray)
+{
+    const DrawUniforms &uniforms = drawUniforms();
+    RenderStats &stats = RenderStats::Frame();
+    if (material && material->diffuseArray)
+    {
+        // Arrays live on unit 1 (see Model::Draw); only the layer changes
+        // between meshes sharing one
+        if (material->diffuseArray != boundArray)
         {
+            glActiveTexture(GL_TEXTURE1);
+            material->diffuseArray->Bind();
             glActiveTexture(GL_TEXTURE0);
-            material->diffuseMap->Bind();
-            material->diffuseMap->texUnit(shader.ID, "tex0", 0);
-            glUniform1i(glGetUniformLocation(shader.ID, "hasTexture"), 1);
-        }
-        else
-        {
-
-            glUniform1i(glGetUniformLocation(shader.ID, "hasTexture"), 0);
-            glUniform3fv(glGetUniformLocation(shader.ID, "materialDiffuse"), 1, glm::value_ptr(material->diffuse));
+            boundArray = material->diffuseArray;
+            stats.otherCalls += 2;
+            stats.bindCalls++;
         }
+        shader.SetInt(uniforms.texLayer, material->diffuseLayer);
     }
-    else
+    else if (material && material->diffuseMap != nullptr)
     {
-        glUniform1i(glGetUniformLocation(shader.ID, "hasTexture"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        material->diffuseMap->Bind();
+        shader.SetInt(uniforms.tex0, 0);
+        stats.otherCalls++;
+        stats.bindCalls++;
     }
+    else if (material)
+        shader.SetVec3(uniforms.materialDiffuse, material->diffuse);
+}
 
-    meshVAO.Bind();
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    meshVAO.Unbind();
+unsigned int Mesh::ShaderFeatures() const
+{
+    if (material && material->diffuseArray)
+        return ShaderVariants::TEXTURE_ARRAY;
+    if (material && material->diffuseMap)
+        return ShaderVariants::TEXTURED;
+    return 0;
+}
+
+void Mesh::Draw(Shader &shader, size_t level)
+{
+    // Not uploaded yet, or part of a merged model (drawn by Model::Draw)
+    if (!meshVAO)
+        return;
+
+    ApplyMaterial(shader);
+
+    const DrawUniforms &uniforms = drawUniforms();
+    shader.SetInt(uniforms.packedNormals, packed ? 1 : 0);
+    shader.SetVec3(uniforms.positionOffset, positionOffset);
+    shader.SetVec3(uniforms.positionScale, positionScale);
+
+    size_t first, count;
+    LevelRange(level, first, count);
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+    meshVAO->Bind();
+    glDrawElements(GL_TRIANGLES, (GLsizei)count, indexType, (void *)(first * indexSize));
+    meshVAO->Unbind();
+
+    RenderStats &stats = RenderStats::Frame();
+    stats.bindCalls += 2;
+    stats.drawCalls++;
 
     if (material && material->diffuseMap != nullptr)
     {
         material->diffuseMap->Unbind();
+        stats.bindCalls++;
+    }
+    else if (material && material->diffuseArray)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        material->diffuseArray->Unbind();
+        glActiveTexture(GL_TEXTURE0);
+        stats.otherCalls += 2;
+        stats.bindCalls++;
     }
 }
 
 void Mesh::Delete()
 {
-    meshVAO.Delete();
+    if (meshVAO)
+    {
+        meshVAO->Delete();
+        delete meshVAO;
+        meshVAO = nullptr;
+    }
     if (meshVBO)
     {
         meshVBO->Delete();
@@ -70,299 +360,1308 @@ void Mesh::Delete()
     }
 }
 
-Model::Model(const char *objFile)
+Model::Model()
+    : lodPixelError(lod::pixelError), trianglesDrawn(0), shaderFeatures(0), untexturedSpecular(0.2f),
+      mergeBuffers(true), modelVAO(nullptr), modelVBO(nullptr), modelEBO(nullptr), packed(vertexFormat::packed),
+      positionOffset(0.0f), positionScale(1.0f), indexType(GL_UNSIGNED_INT), bufferBytes(0), useTextureArrays(false),
+      currentProgram(nullptr), drawTransform(1.0f), linkedInstanceSet(0), spinTime(0.0f)
+{
+}
+
+Model::Model(const char *objFile, const ModelLoadOptions &options) : Model()
 {
-    loadOBJ(objFile);
+    load(objFile, options);
 }
 
-Model::Model(const char *objFile, const char *texturePath)
+Model::Model(const char *objFile, const char *texturePath) : Model()
 {
     // Load OBJ with materials, then override with single texture
-    loadOBJ(objFile);
+    load(objFile, ModelLoadOptions());
 
     // Apply single texture to all meshes (legacy support)
     for (auto &mesh : meshes)
     {
         if (mesh.material && mesh.material->diffuseMap == nullptr)
         {
-            mesh.material->diffuseMap = new Texture(texturePath);
+            mesh.material->diffuseMap = ResourceCache::Shared().AcquireTexture(texturePath);
+        }
+    }
+}
+
+void Model::load(const char *objFile, const ModelLoadOptions &options)
+{
+    mergeBuffers = options.mergeBuffers;
+    useTextureArrays = options.textureArrays && !TextureStreamer::Shared().Enabled();
+    sourcePath = objFile;
+    LoadReport::Shared().CountLoad(objFile, "model");
+
+    // A warm cache is uploaded straight from its mapping instead of via Parse()
+    if (options.useCache && MeshCache::Load(objFile, meshCacheFlags(options), meshCacheOptionsKey(options), *this, true))
+    {
+        if (!LoadReport::Shared().Quiet())
+            std::cout << "Loaded " << objFile << " from mesh cache\n";
+        loadTextures();
+        return;
+    }
+
+    parseOBJ(objFile, options);
+    Upload();
+}
+
+void Model::Parse(const char *objFile, const ModelLoadOptions &options)
+{
+    mergeBuffers = options.mergeBuffers;
+    useTextureArrays = options.textureArrays && !TextureStreamer::Shared().Enabled();
+    sourcePath = objFile;
+    LoadReport::Shared().CountLoad(objFile, "model");
+
+    if (options.useCache && MeshCache::Load(objFile, meshCacheFlags(options), meshCacheOptionsKey(options), *this, false))
+    {
+        if (!LoadReport::Shared().Quiet())
+            std::cout << "Loaded " << objFile << " from mesh cache\n";
+        return;
+    }
+
+    parseOBJ(objFile, options);
+}
+
+void Model::parseOBJ(const char *objFile, const ModelLoadOptions &options)
+{
+    loadOBJ(objFile, options.parseThreads);
+    {
+        LoadReport::Timer timer(objFile, "model", LoadReport::NORMALS);
+        generateNormals(objFile, options);
+    }
+    if (options.optimizeMeshes)
+    {
+        LoadReport::Timer timer(objFile, "model", LoadReport::OPTIMIZE);
+        optimizeMeshes(objFile, options);
+    }
+    if (options.generateTangents)
+    {
+        LoadReport::Timer timer(objFile, "model", LoadReport::TANGENTS);
+        for (Mesh &mesh : meshes)
+            MeshNormals::GenerateTangents(mesh.vertices, mesh.indices, mesh.tangents, ThreadPool::Shared());
+    }
+    if (options.generateLods)
+    {
+        LoadReport::Timer timer(objFile, "model", LoadReport::LOD);
+        generateLods(objFile, options);
+    }
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (const Mesh &mesh : meshes)
+    {
+        vertexCount += mesh.vertices.size();
+        indexCount += mesh.indices.size() + mesh.lodIndices.size();
+    }
+    LoadReport::Shared().AddCounts(objFile, "model", vertexCount, indexCount, 0, 0);
+
+    if (options.useCache && !meshes.empty() &&
+        !MeshCache::Save(objFile, meshCacheFlags(options), meshCacheOptionsKey(options), *this, mtlFiles))
+        std::cerr << "Failed to write mesh cache: " << MeshCache::CachePath(objFile, meshCacheFlags(options), meshCacheOptionsKey(options))
+                  << std::endl;
+}
+
+void Model::generateNormals(const char *objFile, const ModelLoadOptions &options)
+{
+    size_t generated = 0;
+    for (Mesh &mesh : meshes)
+    {
+        if (options.generateNormals)
+        {
+            // Each mesh already splits its triangles across the pool
+            generated += MeshNormals::GenerateNormals(mesh.vertices, mesh.indices, options.creaseAngle,
+                                                      options.normalWeighting, ThreadPool::Shared());
+            continue;
+        }
+        for (Vertex &vertex : mesh.vertices)
+        {
+            if (vertex.Normal == glm::vec3(0.0f))
+                vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    if (generated > 0 && !LoadReport::Shared().Quiet())
+        std::cout << "Generated normals for " << generated << " vertices of " << objFile << '\n';
+}
+
+void Model::optimizeMeshes(const char *objFile, const ModelLoadOptions &options)
+{
+    std::vector<MeshOptimizer::CacheStats> before(meshes.size()), after(meshes.size());
+
+    ThreadPool::Shared().ParallelFor(meshes.size(), [&](size_t i)
+    {
+        Mesh &mesh = meshes[i];
+        before[i] = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+        if (options.optimizeOverdraw)
+            MeshOptimizer::OptimizeOverdraw(mesh.indices, mesh.vertices);
+        MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+        after[i] = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    });
+
+    size_t triangles = 0, vertices = 0, transformedBefore = 0, transformedAfter = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        triangles += before[i].triangles;
+        vertices += before[i].vertices;
+        transformedBefore += before[i].transformed;
+        transformedAfter += after[i].transformed;
+    }
+    if (triangles == 0 || LoadReport::Shared().Quiet())
+        return;
+
+    std::cout << "Optimized " << objFile << ": ACMR " << float(transformedBefore) / triangles
+              << " -> " << float(transformedAfter) / triangles
+              << ", ATVR " << float(transformedBefore) / vertices
+              << " -> " << float(transformedAfter) / vertices << '\n';
+}
+
+void Model::generateLods(const char *objFile, const ModelLoadOptions &options)
+{
+    ThreadPool::Shared().ParallelFor(meshes.size(), [&](size_t i)
+    {
+        Mesh &mesh = meshes[i];
+        mesh.lods.clear();
+        mesh.lodIndices.clear();
+
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!mesh.vertices.empty())
+        {
+            minimum = maximum = mesh.vertices[0].Position;
+            for (const Vertex &vertex : mesh.vertices)
+            {
+                minimum = glm::min(minimum, vertex.Position);
+                maximum = glm::max(maximum, vertex.Position);
+            }
+        }
+        glm::vec3 extent = maximum - minimum;
+        float size = std::max(extent.x, std::max(extent.y, extent.z));
+
+        // Each level is simplified from the previous one, so errors add up
+        std::vector<unsigned int> previous = mesh.indices;
+        float error = 0.0f;
+        for (unsigned int level = 1; level < options.lodLevels; level++)
+        {
+            size_t target = size_t(previous.size() / 3 * options.lodReduction) * 3;
+            float levelError = 0.0f;
+            std::vector<unsigned int> simplified =
+                MeshOptimizer::Simplify(previous, mesh.vertices, target, options.lodMaxError - error, &levelError);
+
+            // Not worth a level if the error limit stopped it early
+            if (simplified.empty() || simplified.size() > previous.size() * 9 / 10)
+                break;
+
+            if (options.optimizeMeshes)
+                MeshOptimizer::OptimizeVertexCache(simplified, mesh.vertices.size());
+
+            error += levelError;
+            MeshLod lod;
+            lod.indexOffset = mesh.indices.size() + mesh.lodIndices.size();
+            lod.indexCount = simplified.size();
+            lod.error = error * size;
+            mesh.lods.push_back(lod);
+            mesh.lodIndices.insert(mesh.lodIndices.end(), simplified.begin(), simplified.end());
+            previous.swap(simplified);
+        }
+    });
+
+    std::vector<size_t> triangles = LodTriangleCounts();
+    if (triangles.size() < 2 || LoadReport::Shared().Quiet())
+        return;
+
+    std::cout << "LODs for " << objFile << ":";
+    for (size_t level = 0; level < triangles.size(); level++)
+        std::cout << (level ? " / " : " ") << triangles[level];
+    std::cout << " triangles\n";
+}
+
+void Model::Upload()
+{
+    loadTextures();
+
+    auto start = std::chrono::steady_clock::now();
+    if (!mergeBuffers)
+    {
+        for (auto &mesh : meshes)
+        {
+            if (!mesh.resident)
+                mesh.setupMesh();
+        }
+    }
+    else
+    {
+        if (!modelVAO)
+        {
+            std::vector<MeshData> data;
+            for (const Mesh &mesh : meshes)
+                data.push_back(mesh.Data());
+            AllocateBuffers(data);
+        }
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (!meshes[i].resident)
+                UploadMesh(i, meshes[i].Data());
+        }
+    }
+
+    if (!sourcePath.empty())
+    {
+        LoadReport::Shared().AddTime(sourcePath, "model", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(start));
+        LoadReport::Shared().AddCounts(sourcePath, "model", 0, 0, 0, BufferBytes());
+    }
+}
+
+size_t Model::BufferBytes() const
+{
+    // Meshes in merged buffers only record their share of the model's
+    if (modelVAO)
+        return bufferBytes;
+
+    size_t bytes = 0;
+    for (const Mesh &mesh : meshes)
+        bytes += mesh.bufferBytes;
+    return bytes;
+}
+
+void Model::AllocateBuffers(const std::vector<MeshData> &data)
+{
+    if (data.empty())
+        return;
+
+    // Packed positions are quantized to the bounds of the whole model, so
+    // the offset/scale uniforms are set once per draw
+    bool fitsShortIndices = true;
+    glm::vec3 lower(1e30f), upper(-1e30f);
+    size_t vertexCount = 0, indexCount = 0;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        for (size_t v = 0; v < data[i].vertexCount; v++)
+        {
+            lower = glm::min(lower, data[i].vertices[v].Position);
+            upper = glm::max(upper, data[i].vertices[v].Position);
+        }
+        fitsShortIndices = fitsShortIndices && data[i].vertexCount <= 65536;
+
+        meshes[i].baseVertex = (GLint)vertexCount;
+        meshes[i].firstIndex = indexCount;
+        vertexCount += data[i].vertexCount;
+        indexCount += data[i].indexCount + data[i].lodIndexCount;
+    }
+    positionOffset = packed && vertexCount ? lower : glm::vec3(0.0f);
+    positionScale = packed && vertexCount ? upper - lower : glm::vec3(1.0f);
+    indexType = packed && fitsShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    size_t vertexSize = packed ? sizeof(PackedVertex) : sizeof(Vertex);
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    bufferBytes = vertexCount * vertexSize + indexCount * indexSize;
+
+    modelVAO = new VAO();
+    modelVAO->Bind();
+    modelVBO = new VBO(nullptr, vertexCount * vertexSize);
+    linkVertexAttributes(*modelVAO, *modelVBO, packed);
+    modelEBO = new EBO(nullptr, indexCount * indexSize);
+    modelVAO->Unbind();
+    modelVBO->Unbind();
+    modelEBO->Unbind();
+
+    sortDrawOrder();
+}
+
+void Model::sortDrawOrder()
+{
+    // Meshes sharing a material next to each other, so they batch,
+    // materials sharing a texture array next to each other, so it stays
+    // bound, and textured materials apart from plain colors, so shader
+    // variants switch once (the maps themselves may not be loaded yet)
+    drawOrder.resize(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+        drawOrder[i] = i;
+    std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](size_t a, size_t b)
+    {
+        const Material *left = meshes[a].material, *right = meshes[b].material;
+        size_t leftArray = arrayIndex(left), rightArray = arrayIndex(right);
+        if (leftArray != rightArray)
+            return leftArray < rightArray;
+        bool leftTextured = left && !left->diffuseMapPath.empty();
+        bool rightTextured = right && !right->diffuseMapPath.empty();
+        if (leftTextured != rightTextured)
+            return leftTextured;
+        return (left ? left->name : std::string()) < (right ? right->name : std::string());
+    });
+}
+
+void Model::UploadMesh(size_t index, const MeshData &data)
+{
+    Mesh &mesh = meshes[index];
+    mesh.computeBounds(data);
+    mesh.packed = packed;
+    mesh.positionOffset = positionOffset;
+    mesh.positionScale = positionScale;
+    mesh.indexType = indexType;
+    mesh.indexCount = data.indexCount;
+
+    modelVBO->Bind();
+    if (packed)
+    {
+        std::vector<PackedVertex> packedVertices =
+            VertexPacking::PackVerticesInBounds(data.vertices, data.vertexCount, positionOffset, positionScale);
+        glBufferSubData(GL_ARRAY_BUFFER, mesh.baseVertex * sizeof(PackedVertex),
+                        packedVertices.size() * sizeof(PackedVertex), packedVertices.data());
+        mesh.bufferBytes = packedVertices.size() * sizeof(PackedVertex);
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, mesh.baseVertex * sizeof(Vertex), data.vertexCount * sizeof(Vertex),
+                        data.vertices);
+        mesh.bufferBytes = data.vertexCount * sizeof(Vertex);
+    }
+    modelVBO->Unbind();
+
+    // The element buffer binding belongs to the VAO
+    modelVAO->Bind();
+    if (indexType == GL_UNSIGNED_SHORT)
+    {
+        std::vector<GLushort> shortIndices = gatherIndices<GLushort>(data);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, mesh.firstIndex * sizeof(GLushort),
+                        shortIndices.size() * sizeof(GLushort), shortIndices.data());
+        mesh.bufferBytes += shortIndices.size() * sizeof(GLushort);
+    }
+    else
+    {
+        std::vector<GLuint> allIndices = gatherIndices<GLuint>(data);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, mesh.firstIndex * sizeof(GLuint),
+                        allIndices.size() * sizeof(GLuint), allIndices.data());
+        mesh.bufferBytes += allIndices.size() * sizeof(GLuint);
+    }
+    modelVAO->Unbind();
+
+    mesh.resident = true;
+}
+
+void Model::loadTextures()
+{
+    // Decode each distinct diffuse map on the pool; only the uploads are left
+    // to this thread. Unless they are packed into arrays, maps that are
+    // already resident are shared instead.
+    std::vector<std::string> paths;
+    for (auto &pair : materials)
+    {
+        const Material *material = pair.second;
+        const std::string &path = material->diffuseMapPath;
+        if (material->diffuseMap || material->diffuseArray || path.empty() ||
+            (!useTextureArrays && ResourceCache::Shared().HasTexture(path.c_str())) ||
+            std::find(paths.begin(), paths.end(), path) != paths.end())
+            continue;
+        paths.push_back(path);
+    }
+    std::vector<TextureImage> images = Texture::DecodeAll(paths, ThreadPool::Shared());
+    if (useTextureArrays)
+        PackTextures(images);
+
+    for (auto &pair : materials)
+    {
+        Material *material = pair.second;
+        if (material->diffuseMap || material->diffuseArray || material->diffuseMapPath.empty())
+            continue;
+        auto image = std::find_if(images.begin(), images.end(), [material](const TextureImage &image)
+        {
+            return image.path == material->diffuseMapPath;
+        });
+        if (image != images.end())
+            material->diffuseMap = ResourceCache::Shared().AcquireTexture(*image);
+        else
+            material->diffuseMap = ResourceCache::Shared().AcquireTexture(material->diffuseMapPath.c_str());
+    }
+
+    for (TextureImage &image : images)
+        image.Free();
+}
+
+void Model::PackTextures(std::vector<TextureImage> &images)
+{
+    // std::map keeps the arrays, and the layers in input order, deterministic
+    std::map<std::string, std::vector<const TextureImage *>> groups;
+    for (const TextureImage &image : images)
+    {
+        std::string key = TextureArray::CompatibilityKey(image);
+        if (!key.empty())
+            groups[key].push_back(&image);
+    }
+
+    for (auto &group : groups)
+    {
+        // A lone map gains nothing from an array and stays shareable as a
+        // plain texture
+        if (group.second.size() < 2)
+            continue;
+
+        TextureArray *array = new TextureArray(group.second);
+        textureArrays.push_back(array);
+        for (size_t layer = 0; layer < group.second.size(); layer++)
+        {
+            for (auto &pair : materials)
+            {
+                Material *material = pair.second;
+                if (!material->diffuseMap && !material->diffuseArray &&
+                    material->diffuseMapPath == group.second[layer]->path)
+                {
+                    material->diffuseArray = array;
+                    material->diffuseLayer = (int)layer;
+                }
+            }
         }
     }
+
+    // Drop the packed images; the rest are left to the caller
+    std::vector<TextureImage> unpacked;
+    for (TextureImage &image : images)
+    {
+        auto group = groups.find(TextureArray::CompatibilityKey(image));
+        if (group != groups.end() && group->second.size() >= 2)
+            image.Free();
+        else
+            unpacked.push_back(image);
+    }
+    images.swap(unpacked);
+
+    // A warm mesh cache allocates the merged buffers, and sorts, before the
+    // textures are packed
+    if (!textureArrays.empty() && !drawOrder.empty())
+        sortDrawOrder();
+}
+
+size_t Model::arrayIndex(const Material *material) const
+{
+    if (!material || !material->diffuseArray)
+        return textureArrays.size();
+    return std::find(textureArrays.begin(), textureArrays.end(), material->diffuseArray) - textureArrays.begin();
 }
 
 void Model::loadMTL(const std::string &mtlFile, const std::string &basePath)
 {
-    std::ifstream file(mtlFile);
-    if (!file.is_open())
+    mtlFiles.push_back(mtlFile);
+    LoadReport &report = LoadReport::Shared();
+    bool quiet = report.Quiet();
+    report.CountLoad(mtlFile, "materials");
+    LoadReport::Timer timer(mtlFile, "materials", LoadReport::MTL_PARSE);
+
+    MappedFile file(mtlFile.c_str());
+    if (!file.IsOpen())
     {
         std::cerr << "Failed to open MTL file: " << mtlFile << std::endl;
         return;
     }
 
     Material *currentMaterial = nullptr;
-    std::string line;
+    const char *p = file.data;
+    const char *fileEnd = file.data + file.size;
 
-    while (std::getline(file, line))
+    while (p < fileEnd)
     {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
+        const char *end = objtok::lineEnd(p, fileEnd);
+        std::string_view prefix = objtok::nextToken(p, end);
 
         if (prefix == "newmtl")
         {
-            std::string materialName;
-            iss >> materialName;
+            std::string materialName(objtok::nextToken(p, end));
 
             currentMaterial = new Material();
             currentMaterial->name = materialName;
             materials[materialName] = currentMaterial;
 
-            std::cout << "Loading material: " << materialName << std::endl;
+            if (!quiet)
+                std::cout << "Loading material: " << materialName << '\n';
         }
         else if (currentMaterial != nullptr)
         {
             if (prefix == "Ka")
             {
-                iss >> currentMaterial->ambient.x >> currentMaterial->ambient.y >> currentMaterial->ambient.z;
+                objtok::parseFloat(p, end, currentMaterial->ambient.x);
+                objtok::parseFloat(p, end, currentMaterial->ambient.y);
+                objtok::parseFloat(p, end, currentMaterial->ambient.z);
             }
             else if (prefix == "Kd")
             {
-                iss >> currentMaterial->diffuse.x >> currentMaterial->diffuse.y >> currentMaterial->diffuse.z;
+                objtok::parseFloat(p, end, currentMaterial->diffuse.x);
+                objtok::parseFloat(p, end, currentMaterial->diffuse.y);
+                objtok::parseFloat(p, end, currentMaterial->diffuse.z);
             }
             else if (prefix == "Ks")
             {
-                iss >> currentMaterial->specular.x >> currentMaterial->specular.y >> currentMaterial->specular.z;
+                objtok::parseFloat(p, end, currentMaterial->specular.x);
+                objtok::parseFloat(p, end, currentMaterial->specular.y);
+                objtok::parseFloat(p, end, currentMaterial->specular.z);
             }
             else if (prefix == "Ns")
             {
-                iss >> currentMaterial->shininess;
+                objtok::parseFloat(p, end, currentMaterial->shininess);
             }
             else if (prefix == "map_Kd")
             {
-                std::string texturePath;
-                iss >> texturePath;
+                std::string texturePath(objtok::nextToken(p, end));
 
                 // Check if path is absolute or relative
-                if (texturePath[0] == '/')
+                if (!texturePath.empty() && texturePath[0] == '/')
                 {
                     // Absolute path
-                    currentMaterial->diffuseMap = new Texture(texturePath.c_str());
-                    std::cout << "  -> Loaded texture (absolute): " << texturePath << std::endl;
+                    currentMaterial->diffuseMapPath = texturePath;
+                    if (!quiet)
+                        std::cout << "  -> Texture (absolute): " << texturePath << '\n';
                 }
                 else
                 {
                     // Relative path
                     std::string fullPath = basePath + texturePath;
-                    currentMaterial->diffuseMap = new Texture(fullPath.c_str());
-                    std::cout << "  -> Loaded texture (relative): " << fullPath << std::endl;
+                    currentMaterial->diffuseMapPath = fullPath;
+                    if (!quiet)
+                        std::cout << "  -> Texture (relative): " << fullPath << '\n';
                 }
             }
         }
+
+        p = end < fileEnd ? end + 1 : fileEnd;
     }
 
-    file.close();
-    std::cout << "Loaded " << materials.size() << " materials from MTL file" << std::endl;
+    report.AddCounts(mtlFile, "materials", 0, 0, file.size, 0);
+    if (!quiet)
+        std::cout << "Loaded " << materials.size() << " materials from MTL file\n";
 }
 
-void Model::loadOBJ(const char *objFile)
+void Model::loadOBJ(const char *objFile, unsigned int parseThreads)
 {
-    std::ifstream file(objFile);
-    if (!file.is_open())
+    typedef std::chrono::steady_clock clock;
+    LoadReport &report = LoadReport::Shared();
+
+    // The file is mapped and tokenized in place: no per-line strings or streams
+    clock::time_point readStart = clock::now();
+    MappedFile file(objFile);
+    if (!file.IsOpen())
     {
         std::cerr << "Failed to open OBJ file: " << objFile << std::endl;
         return;
     }
+    report.AddTime(objFile, "model", LoadReport::FILE_READ, LoadReport::MillisecondsSince(readStart));
+    report.AddCounts(objFile, "model", 0, 0, file.size, 0);
 
     // Extract base path from obj file path
     std::string objPath(objFile);
     std::string basePath = objPath.substr(0, objPath.find_last_of("/\\") + 1);
 
+    // Small files are not worth splitting; an explicit thread count always is
+    if (parseThreads == 0)
+        parseThreads = file.size >= parallelParseThreshold ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+    if (parseThreads > 1)
+    {
+        loadOBJParallel(objFile, file, basePath, parseThreads);
+        return;
+    }
+
     std::vector<glm::vec3> temp_vertices;
     std::vector<glm::vec2> temp_uvs;
     std::vector<glm::vec3> temp_normals;
 
     Mesh currentMesh;
     Material *currentMaterial = nullptr;
-    std::map<std::string, unsigned int> vertexMap;
+    VertexIndexMap vertexMap;
+    bool vertexMapSized = false;
+
+    // Face corners of the current line and the triangles they make; n-gons
+    // beyond this are rare enough to spill
+    std::vector<FaceIndex> faceVertices, triangleCorners;
+    faceVertices.reserve(8);
+    triangleCorners.reserve(18);
 
-    std::string line;
-    while (std::getline(file, line))
+    // Detailed reports time the triangulation and dedup of every face; the
+    // rest of the loop, less any MTL parsing, is tokenization
+    const bool detailed = report.Detailed();
+    clock::time_point parseStart = clock::now();
+    clock::duration mtlTime(0), triangulateTime(0), dedupTime(0);
+
+    const char *p = file.data;
+    const char *fileEnd = file.data + file.size;
+    const char *releasedUpTo = file.data;
+    const size_t releaseChunk = 64 << 20;
+
+    while (p < fileEnd)
     {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
+        // Parsed text is never revisited, so keep the mapping's footprint bounded
+        if ((size_t)(p - releasedUpTo) >= releaseChunk)
+        {
+            file.Release(p);
+            releasedUpTo = p;
+        }
+
+        const char *end = objtok::lineEnd(p, fileEnd);
+        std::string_view prefix = objtok::nextToken(p, end);
 
         if (prefix == "v")
         {
-            glm::vec3 vertex;
-            iss >> vertex.x >> vertex.y >> vertex.z;
+            glm::vec3 vertex(0.0f);
+            objtok::parseFloat(p, end, vertex.x);
+            objtok::parseFloat(p, end, vertex.y);
+            objtok::parseFloat(p, end, vertex.z);
             temp_vertices.push_back(vertex);
         }
         else if (prefix == "vt")
         {
-            glm::vec2 uv;
-            iss >> uv.x >> uv.y;
+            glm::vec2 uv(0.0f);
+            objtok::parseFloat(p, end, uv.x);
+            objtok::parseFloat(p, end, uv.y);
             temp_uvs.push_back(uv);
         }
         else if (prefix == "vn")
         {
-            glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
+            glm::vec3 normal(0.0f);
+            objtok::parseFloat(p, end, normal.x);
+            objtok::parseFloat(p, end, normal.y);
+            objtok::parseFloat(p, end, normal.z);
             temp_normals.push_back(normal);
         }
         else if (prefix == "mtllib")
         {
             // MTL library reference
-            std::string mtlFileName;
-            iss >> mtlFileName;
-            std::string mtlPath = basePath + mtlFileName;
+            std::string mtlPath = basePath + std::string(objtok::nextToken(p, end));
+            clock::time_point mtlStart = clock::now();
             loadMTL(mtlPath, basePath);
+            mtlTime += clock::now() - mtlStart;
         }
         else if (prefix == "usemtl")
         {
             // Material switch - save current mesh and start new one
-            std::string materialName;
-            iss >> materialName;
+            std::string materialName(objtok::nextToken(p, end));
+            switchMaterial(materialName, currentMesh, currentMaterial, vertexMap);
+        }
+        else if (prefix == "f")
+        {
+            // Vertex data precedes the faces in practice, so the attribute counts
+            // are a good estimate of the distinct corners per submesh
+            if (!vertexMapSized)
+            {
+                vertexMap.Reserve(std::max({temp_vertices.size(), temp_uvs.size(), temp_normals.size()}));
+                vertexMapSized = true;
+            }
 
-            // Save previous mesh if it has data
-            if (!currentMesh.vertices.empty())
+            // Read all vertices in the face
+            faceVertices.clear();
+            for (std::string_view token = objtok::nextToken(p, end); !token.empty(); token = objtok::nextToken(p, end))
             {
-                currentMesh.material = currentMaterial;
-                currentMesh.setupMesh();
-                meshes.push_back(currentMesh);
+                faceVertices.push_back(objtok::parseFaceIndex(token, temp_vertices.size(), temp_uvs.size(), temp_normals.size()));
             }
 
-            // Start new mesh with new material
-            currentMesh = Mesh();
-            vertexMap.clear();
+            clock::time_point triangulateStart, dedupStart;
+            if (detailed)
+                triangulateStart = clock::now();
 
-            if (materials.find(materialName) != materials.end())
+            // Triangles pass through; quads and n-gons become a fan around corner 0
+            triangleCorners.clear();
+            for (size_t i = 1; i + 1 < faceVertices.size(); i++)
             {
-                currentMaterial = materials[materialName];
+                triangleCorners.push_back(faceVertices[0]);
+                triangleCorners.push_back(faceVertices[i]);
+                triangleCorners.push_back(faceVertices[i + 1]);
             }
-            else
+
+            if (detailed)
+                dedupStart = clock::now();
+            for (const FaceIndex &corner : triangleCorners)
+                processVertex(corner, temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
+            if (detailed)
             {
-                std::cout << "Warning: Material '" << materialName << "' not found!" << std::endl;
-                currentMaterial = nullptr;
+                clock::time_point dedupEnd = clock::now();
+                triangulateTime += dedupStart - triangulateStart;
+                dedupTime += dedupEnd - dedupStart;
             }
         }
-        else if (prefix == "f")
+
+        p = end < fileEnd ? end + 1 : fileEnd;
+    }
+
+    // Save final mesh
+    finishMesh(currentMesh, currentMaterial);
+
+    typedef std::chrono::duration<double, std::milli> milliseconds;
+    double parseMs = milliseconds(clock::now() - parseStart - mtlTime).count();
+    report.AddTime(objFile, "model", LoadReport::PARSE, parseMs);
+    if (detailed)
+    {
+        double triangulateMs = milliseconds(triangulateTime).count(), dedupMs = milliseconds(dedupTime).count();
+        report.AddTime(objFile, "model", LoadReport::TOKENIZE, parseMs - triangulateMs - dedupMs);
+        report.AddTime(objFile, "model", LoadReport::TRIANGULATE, triangulateMs);
+        report.AddTime(objFile, "model", LoadReport::DEDUP, dedupMs);
+    }
+}
+
+void Model::loadOBJParallel(const char *objFile, const MappedFile &file, const std::string &basePath,
+                            unsigned int chunkCount)
+{
+    // Chunks triangulate as they tokenize, so that time counts as tokenization
+    typedef std::chrono::steady_clock clock;
+    clock::time_point parseStart = clock::now();
+
+    // Parse line-aligned slices of the file concurrently
+    std::vector<std::pair<size_t, size_t>> ranges = ObjChunkParser::SplitLines(file.data, file.size, chunkCount);
+    std::vector<ObjChunk> chunks(ranges.size());
+
+    // On the shared pool, like the later stages: ModelLoader may be running
+    // several parses on its workers, and the caller takes part
+    ThreadPool &pool = ThreadPool::Shared();
+    pool.ParallelFor(chunks.size(), [&](size_t i) {
+        ObjChunkParser::Parse(file.data + ranges[i].first, file.data + ranges[i].second, chunks[i]);
+    });
+
+    // Attribute counts of all earlier chunks give each chunk its global offsets
+    std::vector<size_t> vBase(chunks.size()), vtBase(chunks.size()), vnBase(chunks.size());
+    size_t vCount = 0, vtCount = 0, vnCount = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        vBase[i] = vCount;
+        vtBase[i] = vtCount;
+        vnBase[i] = vnCount;
+        vCount += chunks[i].positions.size();
+        vtCount += chunks[i].uvs.size();
+        vnCount += chunks[i].normals.size();
+    }
+
+    std::vector<glm::vec3> temp_vertices(vCount);
+    std::vector<glm::vec2> temp_uvs(vtCount);
+    std::vector<glm::vec3> temp_normals(vnCount);
+
+    pool.ParallelFor(chunks.size(), [&](size_t i) {
+        ObjChunk &chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), temp_vertices.begin() + vBase[i]);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), temp_uvs.begin() + vtBase[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), temp_normals.begin() + vnBase[i]);
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec2>().swap(chunk.uvs);
+        std::vector<glm::vec3>().swap(chunk.normals);
+
+        for (size_t r = 0; r < chunk.relativeCorners.size(); r++)
         {
-            // Read all vertices in the face
-            std::vector<std::string> faceVertices;
-            std::string vertexStr;
-            while (iss >> vertexStr)
-            {
-                faceVertices.push_back(vertexStr);
-            }
+            FaceIndex &corner = chunk.corners[chunk.relativeCorners[r]];
+            uint8_t mask = chunk.relativeMasks[r];
+            if (mask & ObjChunkParser::RELATIVE_V)
+                corner.v += vBase[i];
+            if (mask & ObjChunkParser::RELATIVE_VT)
+                corner.vt += vtBase[i];
+            if (mask & ObjChunkParser::RELATIVE_VN)
+                corner.vn += vnBase[i];
+        }
+    });
 
-            // Handle triangles and quads
-            if (faceVertices.size() == 3)
-            {
-                // Triangle
-                for (const std::string &vertexStr : faceVertices)
-                {
-                    processVertex(vertexStr, temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                }
-            }
-            else if (faceVertices.size() == 4)
-            {
-                // Quad - triangulate
-                processVertex(faceVertices[0], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                processVertex(faceVertices[1], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                processVertex(faceVertices[2], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-
-                processVertex(faceVertices[0], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                processVertex(faceVertices[2], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                processVertex(faceVertices[3], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-            }
-            else if (faceVertices.size() > 4)
+    double tokenizeMs = LoadReport::MillisecondsSince(parseStart);
+    clock::time_point dedupStart = clock::now();
+    clock::duration mtlTime(0);
+
+    // Replay corners and material events in file order so the submesh split and
+    // vertex numbering match the serial loader exactly
+    Mesh currentMesh;
+    Material *currentMaterial = nullptr;
+    VertexIndexMap vertexMap;
+    vertexMap.Reserve(std::max({vCount, vtCount, vnCount}));
+
+    for (ObjChunk &chunk : chunks)
+    {
+        size_t e = 0;
+        for (size_t c = 0; c <= chunk.corners.size(); c++)
+        {
+            for (; e < chunk.events.size() && chunk.events[e].cornerOffset == c; e++)
             {
-                // N-gon - fan triangulation
-                for (size_t i = 1; i < faceVertices.size() - 1; i++)
+                const ObjChunk::Event &event = chunk.events[e];
+                if (event.type == ObjChunk::Event::MTLLIB)
                 {
-                    processVertex(faceVertices[0], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                    processVertex(faceVertices[i], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
-                    processVertex(faceVertices[i + 1], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
+                    clock::time_point mtlStart = clock::now();
+                    loadMTL(basePath + event.name, basePath);
+                    mtlTime += clock::now() - mtlStart;
                 }
+                else
+                    switchMaterial(event.name, currentMesh, currentMaterial, vertexMap);
             }
+            if (c < chunk.corners.size())
+                processVertex(chunk.corners[c], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
         }
+        std::vector<FaceIndex>().swap(chunk.corners);
     }
 
-    // Save final mesh
+    finishMesh(currentMesh, currentMaterial);
+
+    double dedupMs = std::chrono::duration<double, std::milli>(clock::now() - dedupStart - mtlTime).count();
+    LoadReport &report = LoadReport::Shared();
+    report.AddTime(objFile, "model", LoadReport::PARSE, tokenizeMs + dedupMs);
+    report.AddTime(objFile, "model", LoadReport::TOKENIZE, tokenizeMs);
+    report.AddTime(objFile, "model", LoadReport::DEDUP, dedupMs);
+}
+
+void Model::switchMaterial(const std::string &materialName, Mesh &currentMesh, Material *&currentMaterial,
+                           VertexIndexMap &vertexMap)
+{
+    // Save previous mesh if it has data
+    finishMesh(currentMesh, currentMaterial);
+
+    // Start new mesh with new material
+    currentMesh = Mesh();
+    vertexMap.Clear();
+
+    auto it = materials.find(materialName);
+    if (it != materials.end())
+    {
+        currentMaterial = it->second;
+    }
+    else
+    {
+        std::cout << "Warning: Material '" << materialName << "' not found!" << std::endl;
+        currentMaterial = nullptr;
+    }
+}
+
+void Model::finishMesh(Mesh &currentMesh, Material *currentMaterial)
+{
     if (!currentMesh.vertices.empty())
     {
         currentMesh.material = currentMaterial;
-        currentMesh.setupMesh();
-        meshes.push_back(currentMesh);
+        meshes.push_back(std::move(currentMesh));
     }
-
-    file.close();
 }
 
-void Model::processVertex(const std::string &vertexStr, const std::vector<glm::vec3> &temp_vertices,
+void Model::processVertex(const FaceIndex &corner, const std::vector<glm::vec3> &temp_vertices,
                           const std::vector<glm::vec2> &temp_uvs, const std::vector<glm::vec3> &temp_normals,
-                          std::map<std::string, unsigned int> &vertexMap, Mesh &currentMesh)
+                          VertexIndexMap &vertexMap, Mesh &currentMesh)
 {
     // Check if we've already processed this exact vertex combination
-    auto it = vertexMap.find(vertexStr);
-    if (it != vertexMap.end())
-    {
-        // Reuse existing vertex
-        currentMesh.indices.push_back(it->second);
-    }
+    bool inserted;
+    unsigned int index = vertexMap.FindOrInsert(corner, currentMesh.vertices.size(), inserted);
+    currentMesh.indices.push_back(index);
+    if (!inserted)
+        return;
+
+    // Create new vertex; indices are already 0-based, -1 or out of range means absent
+    Vertex vertex;
+    if ((unsigned int)corner.v < temp_vertices.size())
+        vertex.Position = temp_vertices[corner.v];
     else
-    {
-        // Create new vertex
-        std::string mutableVertexStr = vertexStr;
-        std::replace(mutableVertexStr.begin(), mutableVertexStr.end(), '/', ' ');
-        std::istringstream vertexStream(mutableVertexStr);
+        vertex.Position = glm::vec3(0.0f);
 
-        unsigned int vertexIndex, uvIndex, normalIndex;
-        vertexStream >> vertexIndex >> uvIndex >> normalIndex;
+    if ((unsigned int)corner.vt < temp_uvs.size())
+        vertex.TexCoords = temp_uvs[corner.vt];
+    else
+        vertex.TexCoords = glm::vec2(0.0f);
 
-        // OBJ indices are 1-based, convert to 0-based
-        vertexIndex--;
-        uvIndex--;
-        normalIndex--;
+    if ((unsigned int)corner.vn < temp_normals.size())
+        vertex.Normal = glm::normalize(temp_normals[corner.vn]);
+    else
+        vertex.Normal = glm::vec3(0.0f); // filled in by generateNormals()
 
-        Vertex vertex;
-        if (vertexIndex < temp_vertices.size())
-            vertex.Position = temp_vertices[vertexIndex];
-        else
-            vertex.Position = glm::vec3(0.0f);
+    currentMesh.vertices.push_back(vertex);
+}
 
-        if (uvIndex < temp_uvs.size())
-            vertex.TexCoords = temp_uvs[uvIndex];
-        else
-            vertex.TexCoords = glm::vec2(0.0f);
+void Model::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+{
+    draw(nullptr, &shader, model, view, projection);
+}
 
-        if (normalIndex < temp_normals.size())
-            vertex.Normal = glm::normalize(temp_normals[normalIndex]);
-        else
-            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+void Model::Draw(ShaderVariants &variants, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+{
+    draw(&variants, nullptr, model, view, projection);
+}
 
-        currentMesh.vertices.push_back(vertex);
-        unsigned int newIndex = currentMesh.vertices.size() - 1;
-        vertexMap[vertexStr] = newIndex;
-        currentMesh.indices.push_back(newIndex);
-    }
+unsigned int Model::variantFeatures(const Mesh &mesh) const
+{
+    if (shaderFeatures & ShaderVariants::WHITE_PLASTIC)
+        return shaderFeatures;
+    return shaderFeatures | mesh.ShaderFeatures();
 }
 
-void Model::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void Model::useProgram(Shader &shader)
 {
+    if (&shader == currentProgram)
+        return;
+    currentProgram = &shader;
     shader.Activate();
+    RenderStats::Frame().bindCalls++;
 
-    // Pass matrices to shader
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    const DrawUniforms &uniforms = drawUniforms();
+    shader.SetModel(drawTransform);
+    // Samplers of different types may not share a unit, even unused ones:
+    // tex0 keeps unit 0 and texArray takes unit 1
+    shader.SetInt(uniforms.texArray, 1);
+    shader.SetFloat(uniforms.specularStrength, untexturedSpecular);
+    shader.SetFloat(uniforms.time, spinTime);
+    if (modelVAO)
+    {
+        // Shared by every mesh in the merged buffers
+        shader.SetInt(uniforms.packedNormals, packed ? 1 : 0);
+        shader.SetVec3(uniforms.positionOffset, positionOffset);
+        shader.SetVec3(uniforms.positionScale, positionScale);
+    }
+}
+
+void Model::draw(ShaderVariants *variants, Shader *shader, const glm::mat4 &model, const glm::mat4 &view,
+                 const glm::mat4 &projection)
+{
+    currentProgram = nullptr;
+    drawTransform = model;
+    if (shader)
+        useProgram(*shader);
+
+    float unitPixels = viewportPixelsPerUnit(projection);
+    float modelScale = largestScale(model);
+    glm::mat4 modelView = view * model;
+
+    if (modelVAO)
+    {
+        drawMerged(variants, modelView, modelScale, unitPixels);
+        return;
+    }
 
     // Draw all submeshes with their respective materials
+    bool streaming = TextureStreamer::Shared().Enabled();
     for (auto &mesh : meshes)
     {
-        mesh.Draw(shader);
+        if (!mesh.resident)
+            continue;
+        if (streaming)
+            requestTexture(mesh, modelView, modelScale, unitPixels);
+        if (variants)
+            useProgram(variants->Get(variantFeatures(mesh)));
+        size_t level = selectLevel(mesh, modelView, modelScale, unitPixels);
+        trianglesDrawn += mesh.TriangleCount(level);
+        mesh.Draw(*currentProgram, level);
+    }
+}
+
+void Model::drawMerged(ShaderVariants *variants, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit)
+{
+    RenderStats &stats = RenderStats::Frame();
+    modelVAO->Bind();
+    stats.bindCalls++;
+
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    bool textureBound = false;
+    const TextureArray *boundArray = nullptr;
+    Material *batchMaterial = nullptr;
+    bool streaming = TextureStreamer::Shared().Enabled();
+
+    for (size_t i : drawOrder)
+    {
+        Mesh &mesh = meshes[i];
+        if (!mesh.resident)
+            continue;
+        if (streaming)
+            requestTexture(mesh, modelView, modelScale, pixelsPerUnit);
+
+        // A material change ends the batch; the next mesh sets its own
+        if (!batchCounts.empty() && mesh.material != batchMaterial)
+            flushBatch();
+        if (batchCounts.empty())
+        {
+            // Meshes of one material always share a variant
+            if (variants)
+                useProgram(variants->Get(variantFeatures(mesh)));
+            mesh.ApplyMaterial(*currentProgram, boundArray);
+            batchMaterial = mesh.material;
+            textureBound = textureBound || (batchMaterial && batchMaterial->diffuseMap);
+        }
+
+        size_t level = selectLevel(mesh, modelView, modelScale, pixelsPerUnit);
+        size_t first, count;
+        mesh.LevelRange(level, first, count);
+        batchCounts.push_back((GLsizei)count);
+        batchOffsets.push_back((const void *)((mesh.firstIndex + first) * indexSize));
+        batchBaseVertices.push_back(mesh.baseVertex);
+        trianglesDrawn += count / 3;
+    }
+    flushBatch();
+
+    modelVAO->Unbind();
+    stats.bindCalls++;
+    unbindMaterials(textureBound, boundArray);
+}
+
+void Model::unbindMaterials(bool textureBound, const TextureArray *boundArray)
+{
+    RenderStats &stats = RenderStats::Frame();
+    if (textureBound)
+    {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        stats.bindCalls++;
+    }
+    if (boundArray)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glActiveTexture(GL_TEXTURE0);
+        stats.otherCalls += 2;
+        stats.bindCalls++;
+    }
+}
+
+void Model::DrawInstanced(ShaderVariants &variants, const std::vector<glm::mat4> &instances, glm::mat4 view,
+                          glm::mat4 projection)
+{
+    if (modelVAO)
+    {
+        if (!instances.empty())
+            drawInstances(variants, instances, nullptr, view, projection);
+        return;
+    }
+    for (const glm::mat4 &instance : instances)
+        Draw(variants, instance, view, projection);
+}
+
+void Model::DrawInstanced(Shader &shader, const std::vector<glm::mat4> &instances, glm::mat4 view,
+                          glm::mat4 projection)
+{
+    for (const glm::mat4 &instance : instances)
+        Draw(shader, instance, view, projection);
+}
+
+void Model::DrawInstanced(ShaderVariants &variants, const std::vector<glm::mat4> &instances,
+                          const std::vector<glm::vec2> &spins, float time, glm::mat4 view, glm::mat4 projection)
+{
+    if (modelVAO)
+    {
+        spinTime = time;
+        if (!instances.empty())
+            drawInstances(variants, instances, &spins, view, projection);
+        return;
+    }
+    for (size_t i = 0; i < instances.size(); i++)
+        Draw(variants, spun(instances[i], spins[i], time), view, projection);
+}
+
+void Model::DrawInstanced(Shader &shader, const std::vector<glm::mat4> &instances, const std::vector<glm::vec2> &spins,
+                          float time, glm::mat4 view, glm::mat4 projection)
+{
+    for (size_t i = 0; i < instances.size(); i++)
+        Draw(shader, spun(instances[i], spins[i], time), view, projection);
+}
+
+double Model::SpinPeriod(const std::vector<glm::vec2> &spins)
+{
+    const int longest = 3600;
+    for (int seconds = 1; seconds < longest; seconds++)
+    {
+        bool whole = true;
+        for (size_t i = 0; i < spins.size() && whole; i++)
+        {
+            double turns = double(spins[i].x) * seconds;
+            whole = std::fabs(turns - std::round(turns)) < 1e-6 * std::max(1.0, std::fabs(turns));
+        }
+        if (whole)
+            return seconds;
     }
+    return longest;
+}
+
+void Model::uploadInstances(const std::vector<glm::mat4> &transforms, const std::vector<glm::vec2> *spins)
+{
+    RenderStats &stats = RenderStats::Frame();
+    size_t index = 0;
+    while (index < instanceSets.size() && instanceSets[index].owner != &transforms)
+        index++;
+    if (index == instanceSets.size())
+    {
+        if (instanceSets.size() == maxInstanceSets)
+        {
+            instanceSets.front().buffer->Delete();
+            delete instanceSets.front().buffer;
+            instanceSets.erase(instanceSets.begin());
+            index--;
+        }
+        InstanceSet added = {&transforms, {}, new VBO(nullptr, 0), 0};
+        instanceSets.push_back(added);
+        linkedInstanceSet = instanceSets.size(); // indices shifted, or a new set
+    }
+    InstanceSet &set = instanceSets[index];
+
+    if (linkedInstanceSet != index)
+    {
+        modelVAO->Bind();
+        for (GLuint column = 0; column < 4; column++)
+            modelVAO->LinkInstanceAttrib(*set.buffer, 3 + column, 4, GL_FLOAT, sizeof(Instance),
+                                         (void *)(offsetof(Instance, model) + column * sizeof(glm::vec4)));
+        for (GLuint column = 0; column < 3; column++)
+            modelVAO->LinkInstanceAttrib(*set.buffer, 7 + column, 3, GL_FLOAT, sizeof(Instance),
+                                         (void *)(offsetof(Instance, normalMatrix) + column * sizeof(glm::vec3)));
+        modelVAO->LinkInstanceAttrib(*set.buffer, 10, 2, GL_FLOAT, sizeof(Instance), (void *)offsetof(Instance, spin));
+        modelVAO->Unbind();
+        linkedInstanceSet = index;
+        // Per attribute: buffer bind and unbind, pointer, enable, divisor
+        stats.bindCalls += 2 + 8 * 2;
+        stats.otherCalls += 8 * 3;
+    }
+
+    // A still grid (the desks) or spinning copies (the fans) keep their
+    // buffer from frame to frame
+    std::vector<Instance> &instances = set.instances;
+    bool changed = transforms.size() != instances.size();
+    instances.resize(transforms.size());
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        glm::vec2 spin = spins ? (*spins)[i] : glm::vec2(0.0f);
+        if (!changed && memcmp(&instances[i].model, &transforms[i], sizeof(glm::mat4)) == 0 && instances[i].spin == spin)
+            continue;
+        changed = true;
+        instances[i].model = transforms[i];
+        instances[i].normalMatrix = Shader::NormalMatrix(transforms[i]);
+        instances[i].spin = spin;
+    }
+    if (!changed)
+        return;
+
+    set.buffer->Bind();
+    if (instances.size() > set.capacity)
+    {
+        set.capacity = std::max(instances.size(), set.capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, set.capacity * sizeof(Instance), NULL, GL_DYNAMIC_DRAW);
+        stats.otherCalls++;
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    set.buffer->Unbind();
+    stats.bindCalls += 2;
+    stats.otherCalls++;
+}
+
+void Model::drawInstances(ShaderVariants &variants, const std::vector<glm::mat4> &transforms,
+                          const std::vector<glm::vec2> *spins, const glm::mat4 &view, const glm::mat4 &projection)
+{
+    // The INSTANCED variants take the transform from the instance buffer
+    currentProgram = nullptr;
+    drawTransform = glm::mat4(1.0f);
+    uploadInstances(transforms, spins);
+    unsigned int instanceFeatures = ShaderVariants::INSTANCED | (spins ? ShaderVariants::SPINNING : 0);
+    RenderStats &stats = RenderStats::Frame();
+
+    float unitPixels = viewportPixelsPerUnit(projection);
+    instanceModelViews.resize(transforms.size());
+    instanceScales.resize(transforms.size());
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        instanceModelViews[i] = view * transforms[i];
+        instanceScales[i] = largestScale(transforms[i]);
+    }
+
+    modelVAO->Bind();
+    stats.bindCalls++;
+
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    bool textureBound = false;
+    const TextureArray *boundArray = nullptr;
+    bool materialApplied = false;
+    Material *appliedMaterial = nullptr;
+    bool streaming = TextureStreamer::Shared().Enabled();
+
+    for (size_t i : drawOrder)
+    {
+        Mesh &mesh = meshes[i];
+        if (!mesh.resident)
+            continue;
+
+        // One level for every copy: the finest any of them asks for
+        size_t level = mesh.LevelCount();
+        for (size_t k = 0; k < transforms.size(); k++)
+        {
+            if (streaming)
+                requestTexture(mesh, instanceModelViews[k], instanceScales[k], unitPixels);
+            level = std::min(level, selectLevel(mesh, instanceModelViews[k], instanceScales[k], unitPixels));
+        }
+
+        if (!materialApplied || mesh.material != appliedMaterial)
+        {
+            useProgram(variants.Get(variantFeatures(mesh) | instanceFeatures));
+            mesh.ApplyMaterial(*currentProgram, boundArray);
+            materialApplied = true;
+            appliedMaterial = mesh.material;
+            textureBound = textureBound || (appliedMaterial && appliedMaterial->diffuseMap);
+        }
+
+        size_t first, count;
+        mesh.LevelRange(level, first, count);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)count, indexType,
+                                          (void *)((mesh.firstIndex + first) * indexSize), (GLsizei)transforms.size(),
+                                          mesh.baseVertex);
+        stats.drawCalls++;
+        trianglesDrawn += count / 3 * transforms.size();
+    }
+
+    modelVAO->Unbind();
+    stats.bindCalls++;
+    unbindMaterials(textureBound, boundArray);
+}
+
+void Model::flushBatch()
+{
+    if (batchCounts.empty())
+        return;
+
+    if (batchCounts.size() == 1)
+        glDrawElementsBaseVertex(GL_TRIANGLES, batchCounts[0], indexType, (void *)batchOffsets[0], batchBaseVertices[0]);
+    else
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, batchCounts.data(), indexType, batchOffsets.data(),
+                                      (GLsizei)batchCounts.size(), batchBaseVertices.data());
+    RenderStats::Frame().drawCalls++;
+
+    batchCounts.clear();
+    batchOffsets.clear();
+    batchBaseVertices.clear();
+}
+
+void Model::requestTexture(const Mesh &mesh, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit) const
+{
+    if (!mesh.material || !mesh.material->diffuseMap)
+        return;
+    const Texture &texture = *mesh.material->diffuseMap;
+
+    // Level 0 texels per model unit against pixels per model unit at the
+    // nearest point of the bounding sphere; inside it, full resolution.
+    // Without UV extent one texel covers the mesh, so the coarsest will do.
+    float texelsPerPixel = FLT_MAX;
+    if (mesh.uvDensity > 0.0f)
+    {
+        glm::vec3 center = glm::vec3(modelView * glm::vec4(mesh.boundsCenter, 1.0f));
+        float distance = std::max(0.0f, glm::length(center) - mesh.boundsRadius * modelScale);
+        float texelsPerUnit = mesh.uvDensity * std::sqrt(float(texture.width) * texture.height);
+        texelsPerPixel = texelsPerUnit * distance / (modelScale * pixelsPerUnit);
+    }
+    TextureStreamer::Shared().Request(texture, texelsPerPixel);
+}
+
+size_t Model::selectLevel(const Mesh &mesh, const glm::mat4 &modelView, float modelScale, float pixelsPerUnit) const
+{
+    if (mesh.lods.empty() || lodPixelError <= 0.0f)
+        return 0;
+
+    // Nearest point of the bounding sphere; inside it, always full detail
+    glm::vec3 center = glm::vec3(modelView * glm::vec4(mesh.boundsCenter, 1.0f));
+    float distance = glm::length(center) - mesh.boundsRadius * modelScale;
+    if (distance <= 0.0f)
+        return 0;
+
+    size_t level = 0;
+    for (size_t i = 0; i < mesh.lods.size(); i++)
+    {
+        float pixels = mesh.lods[i].error * modelScale * pixelsPerUnit / distance;
+        if (pixels > lodPixelError)
+            break;
+        level = i + 1;
+    }
+    return level;
+}
+
+std::vector<size_t> Model::LodTriangleCounts() const
+{
+    size_t levels = 0;
+    for (const Mesh &mesh : meshes)
+        levels = std::max(levels, mesh.LevelCount());
+
+    std::vector<size_t> triangles(levels, 0);
+    for (const Mesh &mesh : meshes)
+    {
+        for (size_t level = 0; level < levels; level++)
+            triangles[level] += mesh.TriangleCount(level);
+    }
+    return triangles;
 }
 
 void Model::Delete()
@@ -373,15 +1672,47 @@ void Model::Delete()
         mesh.Delete();
     }
     meshes.clear();
+    drawOrder.clear();
 
-    // Delete all materials and their textures
+    if (modelVAO)
+    {
+        modelVAO->Delete();
+        delete modelVAO;
+        modelVAO = nullptr;
+    }
+    if (modelVBO)
+    {
+        modelVBO->Delete();
+        delete modelVBO;
+        modelVBO = nullptr;
+    }
+    if (modelEBO)
+    {
+        modelEBO->Delete();
+        delete modelEBO;
+        modelEBO = nullptr;
+    }
+    for (InstanceSet &set : instanceSets)
+    {
+        set.buffer->Delete();
+        delete set.buffer;
+    }
+    instanceSets.clear();
+    linkedInstanceSet = 0;
+    bufferBytes = 0;
+
+    for (TextureArray *array : textureArrays)
+    {
+        array->Delete();
+        delete array;
+    }
+    textureArrays.clear();
+
+    // Delete all materials and drop their (shared) textures
     for (auto &pair : materials)
     {
         if (pair.second->diffuseMap != nullptr)
-        {
-            pair.second->diffuseMap->Delete();
-            delete pair.second->diffuseMap;
-        }
+            ResourceCache::Shared().Release(pair.second->diffuseMap);
         delete pair.second;
     }
     materials.clear();
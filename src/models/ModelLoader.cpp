@@ -0,0 +1,227 @@
+#include "models/ModelLoader.h"
+#include "ResourceCache.h"
+#include "LoadReport.h"
+
+#include <chrono>
+#include <vector>
+
+ModelLoader::ModelLoader(ThreadPool &pool) : pool(pool), inFlight(0)
+{
+}
+
+ModelLoader::~ModelLoader()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return inFlight == 0; });
+
+    for (auto &pending : ready)
+        release(*pending);
+    ready.clear();
+}
+
+void ModelLoader::Request(Model &target, const char *objFile, const ModelLoadOptions &options)
+{
+    PendingModel *pending = new PendingModel();
+    pending->target = &target;
+    pending->path = objFile;
+    pending->nextMesh = 0;
+    pending->started = false;
+    pending->packed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight++;
+    }
+
+    pool.Enqueue([this, pending, options]
+    {
+        parse(*pending, options);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.emplace_back(pending);
+            inFlight--;
+        }
+        jobFinished.notify_all();
+    });
+}
+
+Model *ModelLoader::Request(const char *objFile, const ModelLoadOptions &options)
+{
+    bool created;
+    Model *model = ResourceCache::Shared().ReserveModel(objFile, options, created);
+    if (created)
+        Request(*model, objFile, options);
+    return model;
+}
+
+void ModelLoader::parse(PendingModel &pending, const ModelLoadOptions &options)
+{
+    pending.staged.Parse(pending.path.c_str(), options);
+
+    // Decode each distinct diffuse map once, in parallel, unless another model
+    // already made it resident (maps packed into arrays are never shared)
+    std::vector<std::string> paths;
+    for (auto &pair : pending.staged.materials)
+    {
+        const std::string &path = pair.second->diffuseMapPath;
+        if (path.empty() ||
+            (!pending.staged.useTextureArrays && ResourceCache::Shared().HasTexture(path.c_str())))
+            continue;
+        if (pending.images.emplace(path, TextureImage()).second)
+            paths.push_back(path);
+    }
+
+    std::vector<TextureImage> decoded = Texture::DecodeAll(paths, pool);
+    for (size_t i = 0; i < paths.size(); i++)
+        pending.images[paths[i]] = decoded[i];
+}
+
+size_t ModelLoader::ProcessUploads(double budgetMs)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t uploads = 0;
+
+    while (true)
+    {
+        PendingModel *pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready.empty())
+                break;
+            pending = ready.front().get();
+        }
+
+        bool finished = uploadNext(*pending);
+        uploads++;
+
+        if (finished)
+        {
+            LoadReport::Shared().AddCounts(pending->path, "model", 0, 0, 0, pending->target->BufferBytes());
+            if (!LoadReport::Shared().Quiet())
+            {
+                std::cout << "Model resident: " << pending->path << " (" << pending->target->meshes.size() << " meshes";
+                std::vector<size_t> levels = pending->target->LodTriangleCounts();
+                if (levels.size() > 1)
+                {
+                    std::cout << ", LOD triangles";
+                    for (size_t level = 0; level < levels.size(); level++)
+                        std::cout << (level ? " / " : " ") << levels[level];
+                }
+                std::cout << ")\n";
+            }
+            release(*pending);
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.pop_front();
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budgetMs)
+            break;
+    }
+
+    return uploads;
+}
+
+bool ModelLoader::uploadNext(PendingModel &pending)
+{
+    Model &target = *pending.target;
+
+    if (!pending.started)
+    {
+        // Hand the materials over first so uploaded meshes can point at them
+        target.materials.insert(pending.staged.materials.begin(), pending.staged.materials.end());
+        pending.staged.materials.clear();
+        target.meshes.reserve(target.meshes.size() + pending.staged.meshes.size());
+        target.mergeBuffers = pending.staged.mergeBuffers && target.meshes.empty();
+        target.useTextureArrays = pending.staged.useTextureArrays;
+        pending.nextMaterial = target.materials.begin();
+        pending.started = true;
+    }
+
+    // Texture arrays take the decoded maps in one step; whatever they do not
+    // take is uploaded on its own below
+    if (target.useTextureArrays && !pending.packed)
+    {
+        std::vector<TextureImage> images;
+        for (auto &pair : pending.images)
+            images.push_back(pair.second);
+        pending.images.clear();
+        target.PackTextures(images);
+        for (const TextureImage &image : images)
+            pending.images[image.path] = image;
+        pending.packed = true;
+        return false;
+    }
+
+    // Textures first, one per step
+    while (pending.nextMaterial != target.materials.end())
+    {
+        Material *material = (pending.nextMaterial++)->second;
+        if (material->diffuseMap || material->diffuseArray || material->diffuseMapPath.empty())
+            continue;
+
+        auto image = pending.images.find(material->diffuseMapPath);
+        if (image != pending.images.end())
+            material->diffuseMap = ResourceCache::Shared().AcquireTexture(image->second);
+        else
+            material->diffuseMap = ResourceCache::Shared().AcquireTexture(material->diffuseMapPath.c_str());
+        return false;
+    }
+
+    // Textures report their own upload time
+    LoadReport::Timer timer(pending.path, "model", LoadReport::GL_UPLOAD);
+
+    // Merged buffers: take all meshes over and size the shared buffers in one
+    // step, then fill in one mesh per step
+    if (target.mergeBuffers)
+    {
+        if (!target.modelVAO)
+        {
+            for (Mesh &mesh : pending.staged.meshes)
+                target.meshes.push_back(std::move(mesh));
+            pending.staged.meshes.clear();
+
+            std::vector<MeshData> data;
+            for (const Mesh &mesh : target.meshes)
+                data.push_back(mesh.Data());
+            target.AllocateBuffers(data);
+            return target.meshes.empty();
+        }
+
+        if (pending.nextMesh < target.meshes.size())
+        {
+            size_t index = pending.nextMesh++;
+            target.UploadMesh(index, target.meshes[index].Data());
+        }
+        return pending.nextMesh >= target.meshes.size();
+    }
+
+    // Otherwise meshes with their own buffers, one per step
+    if (pending.nextMesh < pending.staged.meshes.size())
+    {
+        Mesh &mesh = pending.staged.meshes[pending.nextMesh++];
+        mesh.setupMesh();
+        target.meshes.push_back(std::move(mesh));
+    }
+
+    return pending.nextMesh >= pending.staged.meshes.size();
+}
+
+void ModelLoader::release(PendingModel &pending)
+{
+    for (auto &pair : pending.images)
+        pair.second.Free();
+    pending.images.clear();
+
+    // Uploaded meshes were moved out but still hold copies of their GL handles,
+    // and the rest own no GL objects yet, so only the CPU side is dropped here
+    pending.staged.meshes.clear();
+    pending.staged.Delete();
+}
+
+bool ModelLoader::Done()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight == 0 && ready.empty();
+}
@@ -0,0 +1,104 @@
+#include "models/ObjChunkParser.h"
+#include "models/ObjTokenizer.h"
+
+std::vector<std::pair<size_t, size_t>> ObjChunkParser::SplitLines(const char *data, size_t size, size_t count)
+{
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t start = 0;
+    for (size_t i = 1; i <= count && start < size; i++)
+    {
+        size_t end = i == count ? size : std::max(start, size * i / count);
+        const char *lineBreak = objtok::lineEnd(data + end, data + size);
+        end = lineBreak < data + size ? lineBreak - data + 1 : size;
+        ranges.push_back({start, end});
+        start = end;
+    }
+    return ranges;
+}
+
+void ObjChunkParser::Parse(const char *begin, const char *fileEnd, ObjChunk &chunk)
+{
+    // Same line dispatch as Model::loadOBJ, minus anything that needs global state
+    std::vector<FaceIndex> face;
+    std::vector<uint8_t> faceMasks;
+    face.reserve(8);
+    faceMasks.reserve(8);
+
+    const char *p = begin;
+    while (p < fileEnd)
+    {
+        const char *end = objtok::lineEnd(p, fileEnd);
+        std::string_view prefix = objtok::nextToken(p, end);
+
+        if (prefix == "v")
+        {
+            glm::vec3 vertex(0.0f);
+            objtok::parseFloat(p, end, vertex.x);
+            objtok::parseFloat(p, end, vertex.y);
+            objtok::parseFloat(p, end, vertex.z);
+            chunk.positions.push_back(vertex);
+        }
+        else if (prefix == "vt")
+        {
+            glm::vec2 uv(0.0f);
+            objtok::parseFloat(p, end, uv.x);
+            objtok::parseFloat(p, end, uv.y);
+            chunk.uvs.push_back(uv);
+        }
+        else if (prefix == "vn")
+        {
+            glm::vec3 normal(0.0f);
+            objtok::parseFloat(p, end, normal.x);
+            objtok::parseFloat(p, end, normal.y);
+            objtok::parseFloat(p, end, normal.z);
+            chunk.normals.push_back(normal);
+        }
+        else if (prefix == "mtllib" || prefix == "usemtl")
+        {
+            ObjChunk::Event event;
+            event.type = prefix == "mtllib" ? ObjChunk::Event::MTLLIB : ObjChunk::Event::USEMTL;
+            event.name = std::string(objtok::nextToken(p, end));
+            event.cornerOffset = chunk.corners.size();
+            chunk.events.push_back(std::move(event));
+        }
+        else if (prefix == "f")
+        {
+            face.clear();
+            faceMasks.clear();
+            for (std::string_view token = objtok::nextToken(p, end); !token.empty(); token = objtok::nextToken(p, end))
+            {
+                // Resolving against the local counts leaves relative indices short by
+                // the attribute counts of all earlier chunks; remember which to fix
+                FaceIndex corner = objtok::parseFaceIndex(token, chunk.positions.size(), chunk.uvs.size(), chunk.normals.size());
+                uint8_t mask = 0;
+                if (token[0] == '-')
+                    mask |= RELATIVE_V;
+                size_t slash = token.find('/');
+                if (slash != std::string_view::npos && slash + 1 < token.size() && token[slash + 1] == '-')
+                    mask |= RELATIVE_VT;
+                size_t slash2 = slash == std::string_view::npos ? slash : token.find('/', slash + 1);
+                if (slash2 != std::string_view::npos && slash2 + 1 < token.size() && token[slash2 + 1] == '-')
+                    mask |= RELATIVE_VN;
+
+                face.push_back(corner);
+                faceMasks.push_back(mask);
+            }
+
+            for (size_t i = 1; i + 1 < face.size(); i++)
+            {
+                const size_t fan[3] = {0, i, i + 1};
+                for (size_t k : fan)
+                {
+                    if (faceMasks[k])
+                    {
+                        chunk.relativeCorners.push_back(chunk.corners.size());
+                        chunk.relativeMasks.push_back(faceMasks[k]);
+                    }
+                    chunk.corners.push_back(face[k]);
+                }
+            }
+        }
+
+        p = end < fileEnd ? end + 1 : fileEnd;
+    }
+}
@@ -0,0 +1,36 @@
+#include "models/VertexIndexMap.h"
+
+void VertexIndexMap::Reserve(size_t expected)
+{
+    // Keep the load factor at or below one half
+    size_t capacity = 16;
+    while (capacity < expected * 2)
+        capacity <<= 1;
+    if (capacity <= slots.size())
+        return;
+
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(capacity, Slot{{0, 0, 0}, 0, 0});
+    mask = capacity - 1;
+
+    uint32_t oldGeneration = generation;
+    generation = 1;
+    count = 0;
+    for (const Slot &slot : old)
+    {
+        if (slot.generation != oldGeneration)
+            continue;
+        size_t i = hash(slot.key) & mask;
+        while (slots[i].generation == generation)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+        slots[i].generation = generation;
+        count++;
+    }
+}
+
+void VertexIndexMap::grow()
+{
+    Reserve(slots.empty() ? 16 : slots.size());
+}
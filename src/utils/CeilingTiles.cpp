@@ -1,4 +1,5 @@
 #include "CeilingTiles.h"
+#include "VertexPacking.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 
@@ -267,25 +268,19 @@ void CeilingTiles::setupCeiling()
 {
     ceilingVAO.Bind();
 
-    ceilingVBO = new VBO((GLfloat *)vertices.data(), vertices.size() * sizeof(CeilingVertex));
+    ceilingVBO = VertexPacking::CreateColorVertexBuffer(ceilingVAO, (const GLfloat *)vertices.data(), vertices.size(), 9);
     ceilingEBO = new EBO(indices.data(), indices.size() * sizeof(unsigned int));
 
-    ceilingVAO.LinkVBOAttrib(*ceilingVBO, 0, 3, GL_FLOAT, sizeof(CeilingVertex), (void *)0);
-    ceilingVAO.LinkVBOAttrib(*ceilingVBO, 1, 3, GL_FLOAT, sizeof(CeilingVertex), (void *)(offsetof(CeilingVertex, Color)));
-    ceilingVAO.LinkVBOAttrib(*ceilingVBO, 2, 3, GL_FLOAT, sizeof(CeilingVertex), (void *)(offsetof(CeilingVertex, Normal)));
-
     ceilingVAO.Unbind();
     ceilingVBO->Unbind();
     ceilingEBO->Unbind();
 }
 
-void CeilingTiles::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void CeilingTiles::Draw(Shader &shader, glm::mat4 model)
 {
     shader.Activate();
 
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    shader.SetModel(model);
 
     ceilingVAO.Bind();
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
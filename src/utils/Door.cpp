@@ -1,4 +1,5 @@
 #include "../../include/Door.h"
+#include "../../include/VertexPacking.h"
 #include <iostream>
 
 Door::Door(float roomLength, float roomWidth, float roomHeight)
@@ -194,38 +195,32 @@ Door::Door(float roomLength, float roomWidth, float roomHeight)
     numFrameIndices = frameIndices.size();
 
     doorVAO.Bind();
-    doorVBO = new VBO(doorVertices.data(), doorVertices.size() * sizeof(GLfloat));
+    doorVBO = VertexPacking::CreateColorVertexBuffer(doorVAO, doorVertices.data(), doorVertices.size() / 9, 9);
     doorEBO = new EBO(doorIndices.data(), doorIndices.size() * sizeof(GLuint));
-    doorVAO.LinkVBOAttrib(*doorVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    doorVAO.LinkVBOAttrib(*doorVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    doorVAO.LinkVBOAttrib(*doorVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     doorVAO.Unbind();
     doorVBO->Unbind();
     doorEBO->Unbind();
 
     frameVAO.Bind();
-    frameVBO = new VBO(frameVertices.data(), frameVertices.size() * sizeof(GLfloat));
+    frameVBO = VertexPacking::CreateColorVertexBuffer(frameVAO, frameVertices.data(), frameVertices.size() / 9, 9);
     frameEBO = new EBO(frameIndices.data(), frameIndices.size() * sizeof(GLuint));
-    frameVAO.LinkVBOAttrib(*frameVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    frameVAO.LinkVBOAttrib(*frameVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    frameVAO.LinkVBOAttrib(*frameVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     frameVAO.Unbind();
     frameVBO->Unbind();
     frameEBO->Unbind();
 }
 
-void Door::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void Door::Draw(Shader &shader, glm::mat4 model)
 {
+    static const Shader::UniformHandle transparency = Shader::Uniform("transparency");
+
     shader.Activate();
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    shader.SetModel(model);
 
-    glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 1.0f);
+    shader.SetFloat(transparency, 1.0f);
     frameVAO.Bind();
     glDrawElements(GL_TRIANGLES, numFrameIndices, GL_UNSIGNED_INT, 0);
 
-    glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 1.0f);
+    shader.SetFloat(transparency, 1.0f);
     doorVAO.Bind();
     glDrawElements(GL_TRIANGLES, numDoorIndices, GL_UNSIGNED_INT, 0);
 }
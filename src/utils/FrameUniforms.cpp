@@ -0,0 +1,56 @@
+#include "FrameUniforms.h"
+#include "TubeLight.h"
+
+#include <cstddef>
+#include <cstring>
+
+static_assert(offsetof(FrameUniforms::Block, lightPos) == 128, "FrameData std140 layout");
+static_assert(offsetof(FrameUniforms::Block, tubeCenter) == 128 + 16 * ceilingTiles::numLights,
+              "FrameData std140 layout");
+static_assert(sizeof(FrameUniforms::Block) == 192 + 16 * ceilingTiles::numLights, "FrameData std140 layout");
+
+FrameUniforms::FrameUniforms() : block(), uploaded(), valid(false)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+void FrameUniforms::SetCamera(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos)
+{
+    block.view = view;
+    block.projection = projection;
+    block.viewPos = viewPos;
+}
+
+void FrameUniforms::SetLights(const glm::vec3 *positions, const TubeLight &tubeLight, const glm::vec3 &color)
+{
+    for (int i = 0; i < ceilingTiles::numLights; i++)
+        block.lightPos[i] = glm::vec4(positions[i], 1.0f);
+    block.tubeCenter = tubeLight.GetTubeCenter();
+    block.tubeLength = tubeLight.GetTubeLength();
+    block.tubeAxis = tubeLight.GetTubeAxis();
+    block.tubeRadius = tubeLight.GetTubeRadius();
+    block.lightColor = color;
+}
+
+void FrameUniforms::Upload()
+{
+    // A still camera leaves the buffer as it is
+    if (valid && memcmp(&block, &uploaded, sizeof(Block)) == 0)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uploaded = block;
+    valid = true;
+}
+
+void FrameUniforms::Delete()
+{
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    valid = false;
+}
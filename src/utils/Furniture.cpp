@@ -172,13 +172,11 @@ void Furniture::setupFurniture()
     furnitureEBO->Unbind();
 }
 
-void Furniture::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void Furniture::Draw(Shader &shader, glm::mat4 model)
 {
     shader.Activate();
 
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    shader.SetModel(model);
 
     furnitureVAO.Bind();
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
@@ -1,4 +1,5 @@
 #include "../../include/GreenBoard.h"
+#include "../../include/VertexPacking.h"
 #include <iostream>
 #include <cmath>
 
@@ -295,34 +296,28 @@ GreenBoard::GreenBoard(float roomLength, float roomWidth, float roomHeight)
     numFrameIndices = frameIndices.size();
 
     boardVAO.Bind();
-    boardVBO = new VBO(boardVertices.data(), boardVertices.size() * sizeof(GLfloat));
+    boardVBO = VertexPacking::CreateColorVertexBuffer(boardVAO, boardVertices.data(), boardVertices.size() / 9, 9);
     boardEBO = new EBO(boardIndices.data(), boardIndices.size() * sizeof(GLuint));
-    boardVAO.LinkVBOAttrib(*boardVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    boardVAO.LinkVBOAttrib(*boardVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    boardVAO.LinkVBOAttrib(*boardVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     boardVAO.Unbind();
     boardVBO->Unbind();
     boardEBO->Unbind();
 
     frameVAO.Bind();
-    frameVBO = new VBO(frameVertices.data(), frameVertices.size() * sizeof(GLfloat));
+    frameVBO = VertexPacking::CreateColorVertexBuffer(frameVAO, frameVertices.data(), frameVertices.size() / 9, 9);
     frameEBO = new EBO(frameIndices.data(), frameIndices.size() * sizeof(GLuint));
-    frameVAO.LinkVBOAttrib(*frameVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    frameVAO.LinkVBOAttrib(*frameVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    frameVAO.LinkVBOAttrib(*frameVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     frameVAO.Unbind();
     frameVBO->Unbind();
     frameEBO->Unbind();
 }
 
-void GreenBoard::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void GreenBoard::Draw(Shader &shader, glm::mat4 model)
 {
+    static const Shader::UniformHandle transparency = Shader::Uniform("transparency");
+
     shader.Activate();
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    shader.SetModel(model);
 
-    glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 1.0f);
+    shader.SetFloat(transparency, 1.0f);
     frameVAO.Bind();
     glDrawElements(GL_TRIANGLES, numFrameIndices, GL_UNSIGNED_INT, 0);
 
@@ -0,0 +1,224 @@
+#include "KtxFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const uint32_t endianness = 0x04030201;
+
+    struct KtxHeader
+    {
+        unsigned char identifier[12];
+        uint32_t endianness;
+        uint32_t glType;
+        uint32_t glTypeSize;
+        uint32_t glFormat;
+        uint32_t glInternalFormat;
+        uint32_t glBaseInternalFormat;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t numberOfArrayElements;
+        uint32_t numberOfFaces;
+        uint32_t numberOfMipmapLevels;
+        uint32_t bytesOfKeyValueData;
+    };
+
+    uint32_t padded(uint32_t size)
+    {
+        return (size + 3) & ~3u;
+    }
+
+    // The stored source hash, or false if the key is absent
+    bool findSourceHash(const char *p, const char *end, uint64_t &hash)
+    {
+        while (end - p >= 4)
+        {
+            uint32_t size;
+            memcpy(&size, p, 4);
+            p += 4;
+            if ((size_t)(end - p) < size)
+                return false;
+
+            size_t keyLength = strnlen(p, size);
+            if (keyLength < size && !strcmp(p, KtxFile::sourceHashKey))
+            {
+                std::string value(p + keyLength + 1, size - keyLength - 1);
+                hash = strtoull(value.c_str(), nullptr, 16);
+                return true;
+            }
+            p += std::min<size_t>(padded(size), end - p);
+        }
+        return false;
+    }
+
+    bool writeAll(FILE *out, const void *data, size_t size)
+    {
+        static const char zeros[4] = {};
+        return fwrite(data, 1, size, out) == size && fwrite(zeros, 1, padded(size) - size, out) == padded(size) - size;
+    }
+}
+
+const char *const KtxFile::sourceHashKey = "ClassroomSourceHash";
+
+int KtxFile::Channels() const
+{
+    if (baseFormat == GL_RED)
+        return 1;
+    return baseFormat == GL_RGB ? 3 : 4;
+}
+
+size_t KtxFile::TotalBytes() const
+{
+    size_t total = 0;
+    for (const Level &level : levels)
+        total += level.size;
+    return total;
+}
+
+std::string KtxFile::BakedPath(const char *imagePath)
+{
+    std::string path = imagePath;
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".ktx") == 0)
+        return path;
+    return path + ".ktx";
+}
+
+KtxFile *KtxFile::Open(const char *path, const char *sourcePath)
+{
+    MappedFile *file = new MappedFile(path);
+    const char *p = file->data;
+    const char *end = file->data + file->size;
+
+    KtxHeader header;
+    bool valid = file->size >= sizeof(KtxHeader);
+    if (valid)
+    {
+        memcpy(&header, p, sizeof(header));
+        p += sizeof(header);
+        valid = memcmp(header.identifier, identifier, 12) == 0 && header.endianness == endianness &&
+                header.pixelDepth == 0 && header.numberOfArrayElements == 0 && header.numberOfFaces == 1 &&
+                header.pixelWidth > 0 && header.pixelHeight > 0 && header.numberOfMipmapLevels > 0 &&
+                header.numberOfMipmapLevels <= 32 && header.bytesOfKeyValueData <= (size_t)(end - p);
+    }
+
+    if (valid && strcmp(path, sourcePath) != 0)
+    {
+        // A baked file is stale once its source changes; without the source
+        // (only the .ktx shipped) it is used as is
+        MappedFile source(sourcePath);
+        uint64_t hash = 0;
+        if (source.IsOpen())
+            valid = findSourceHash(p, p + header.bytesOfKeyValueData, hash) && hash == source.ContentHash();
+    }
+
+    KtxFile *ktx = nullptr;
+    if (valid)
+    {
+        p += header.bytesOfKeyValueData;
+        ktx = new KtxFile();
+        ktx->file = file;
+        ktx->type = header.glType;
+        ktx->format = header.glFormat;
+        ktx->internalFormat = header.glInternalFormat;
+        ktx->baseFormat = header.glBaseInternalFormat;
+        ktx->width = header.pixelWidth;
+        ktx->height = header.pixelHeight;
+
+        int width = header.pixelWidth, height = header.pixelHeight;
+        for (uint32_t i = 0; i < header.numberOfMipmapLevels && valid; i++)
+        {
+            uint32_t size = 0;
+            valid = end - p >= 4;
+            if (valid)
+            {
+                memcpy(&size, p, 4);
+                p += 4;
+                valid = (size_t)(end - p) >= size;
+            }
+            if (valid)
+            {
+                ktx->levels.push_back({p, size, width, height});
+                p += std::min<size_t>(padded(size), end - p);
+            }
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        valid = valid && (ktx->baseFormat == GL_RED || ktx->baseFormat == GL_RGB || ktx->baseFormat == GL_RGBA);
+    }
+
+    if (valid)
+        return ktx;
+
+    if (ktx)
+        ktx->Delete(); // and the mapping with it
+    else
+        delete file;
+    delete ktx;
+    return nullptr;
+}
+
+bool KtxFile::Write(const char *path, GLenum type, GLenum format, GLenum internalFormat, GLenum baseFormat,
+                    const std::vector<LevelData> &levels, uint64_t sourceHash)
+{
+    if (levels.empty())
+        return false;
+
+    char hashText[17];
+    snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)sourceHash);
+    std::string keyValue = std::string(sourceHashKey) + '\0' + hashText + '\0';
+    uint32_t keyValueSize = keyValue.size();
+
+    KtxHeader header;
+    memcpy(header.identifier, identifier, 12);
+    header.endianness = endianness;
+    header.glType = type;
+    header.glTypeSize = 1;
+    header.glFormat = format;
+    header.glInternalFormat = internalFormat;
+    header.glBaseInternalFormat = baseFormat;
+    header.pixelWidth = levels[0].width;
+    header.pixelHeight = levels[0].height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = levels.size();
+    header.bytesOfKeyValueData = 4 + padded(keyValueSize);
+
+    // Written to a temporary and renamed, like the mesh cache
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE *out = fopen(tempPath.c_str(), "wb");
+    if (!out)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(&keyValueSize, 4, 1, out) == 1 &&
+              writeAll(out, keyValue.data(), keyValue.size());
+    for (const LevelData &level : levels)
+    {
+        uint32_t size = level.bytes.size();
+        ok = ok && fwrite(&size, 4, 1, out) == 1 && writeAll(out, level.bytes.data(), size);
+    }
+
+    ok = (fclose(out) == 0) && ok;
+    if (!ok || rename(tempPath.c_str(), path) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void KtxFile::Delete()
+{
+    levels.clear();
+    if (file)
+    {
+        file->Close();
+        delete file;
+    }
+    file = nullptr;
+}
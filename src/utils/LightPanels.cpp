@@ -1,4 +1,6 @@
 #include "LightPanels.h"
+#include "VertexPacking.h"
+#include "ResourceCache.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 
@@ -7,7 +9,7 @@ LightPanels::LightPanels(float roomLength, float roomWidth, float roomHeight, in
     lightVBO = nullptr;
     lightEBO = nullptr;
 
-    emissiveShader = new Shader("shaders/emissive.vert", "shaders/emissive.frag");
+    emissiveShader = ResourceCache::Shared().AcquireShader("shaders/emissive.vert", "shaders/emissive.frag");
 
     generateLightPanels(roomLength, roomWidth, roomHeight, rows, cols, lightsPos, numLights);
     setupLightPanels();
@@ -64,26 +66,19 @@ void LightPanels::setupLightPanels()
 {
     lightVAO.Bind();
 
-    lightVBO = new VBO((GLfloat *)vertices.data(), vertices.size() * sizeof(LightVertex));
+    lightVBO = VertexPacking::CreateColorVertexBuffer(lightVAO, (const GLfloat *)vertices.data(), vertices.size(), 9);
     lightEBO = new EBO(indices.data(), indices.size() * sizeof(unsigned int));
 
-    lightVAO.LinkVBOAttrib(*lightVBO, 0, 3, GL_FLOAT, sizeof(LightVertex), (void *)0);
-
-    lightVAO.LinkVBOAttrib(*lightVBO, 1, 3, GL_FLOAT, sizeof(LightVertex), (void *)(offsetof(LightVertex, Color)));
-    lightVAO.LinkVBOAttrib(*lightVBO, 2, 3, GL_FLOAT, sizeof(LightVertex), (void *)(offsetof(LightVertex, Normal)));
-
     lightVAO.Unbind();
     lightVBO->Unbind();
     lightEBO->Unbind();
 }
 
-void LightPanels::Draw(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void LightPanels::Draw(glm::mat4 model)
 {
     emissiveShader->Activate();
 
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    emissiveShader->SetModel(model);
 
     lightVAO.Bind();
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
@@ -105,7 +100,7 @@ void LightPanels::Delete()
     }
     if (emissiveShader)
     {
-        emissiveShader->Delete();
-        delete emissiveShader;
+        ResourceCache::Shared().Release(emissiveShader);
+        emissiveShader = nullptr;
     }
 }
@@ -0,0 +1,180 @@
+#include "LoadReport.h"
+
+#include <cstdio>
+#include <sstream>
+
+namespace
+{
+    void writeString(std::ostringstream &out, const std::string &text)
+    {
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                out << escaped;
+            }
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    void writePhases(std::ostringstream &out, const double *ms, const bool *timed)
+    {
+        out << '{';
+        bool first = true;
+        for (int phase = 0; phase < LoadReport::PHASE_COUNT; phase++)
+        {
+            if (!timed[phase])
+                continue;
+            char value[32];
+            snprintf(value, sizeof(value), "%.3f", ms[phase]);
+            out << (first ? "" : ", ") << '"' << LoadReport::PhaseName((LoadReport::Phase)phase) << "\": " << value;
+            first = false;
+        }
+        out << '}';
+    }
+}
+
+LoadReport::Timer::Timer(const std::string &path, const char *kind, Phase phase)
+    : path(path), kind(kind), phase(phase), start(std::chrono::steady_clock::now()), elapsed(0), running(true),
+      stopped(false)
+{
+}
+
+void LoadReport::Timer::Pause()
+{
+    if (!running)
+        return;
+    elapsed += std::chrono::steady_clock::now() - start;
+    running = false;
+}
+
+void LoadReport::Timer::Resume()
+{
+    if (running || stopped)
+        return;
+    start = std::chrono::steady_clock::now();
+    running = true;
+}
+
+void LoadReport::Timer::Stop()
+{
+    if (stopped)
+        return;
+    Pause();
+    stopped = true;
+    LoadReport::Shared().AddTime(path, kind, phase, std::chrono::duration<double, std::milli>(elapsed).count());
+}
+
+const char *LoadReport::PhaseName(Phase phase)
+{
+    static const char *names[PHASE_COUNT] = {"file_read", "parse", "tokenize", "triangulate", "dedup", "mtl_parse",
+                                             "cache_read", "normals", "tangents", "optimize", "lod", "image_decode", "mipmap", "gl_upload"};
+    return phase < PHASE_COUNT ? names[phase] : "unknown";
+}
+
+LoadReport &LoadReport::Shared()
+{
+    static LoadReport report;
+    return report;
+}
+
+LoadReport::Asset &LoadReport::asset(const std::string &path, const char *kind)
+{
+    auto found = assetIndex.find(path);
+    if (found != assetIndex.end())
+        return assets[found->second];
+
+    Asset entry = Asset();
+    entry.path = path;
+    entry.kind = kind;
+    assetIndex[path] = assets.size();
+    assets.push_back(entry);
+    return assets.back();
+}
+
+void LoadReport::AddTime(const std::string &path, const char *kind, Phase phase, double ms)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Asset &entry = asset(path, kind);
+    entry.ms[phase] += ms;
+    entry.timed[phase] = true;
+}
+
+void LoadReport::AddCounts(const std::string &path, const char *kind, size_t vertices, size_t indices,
+                           size_t fileBytes, size_t gpuBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Asset &entry = asset(path, kind);
+    entry.vertices += vertices;
+    entry.indices += indices;
+    entry.fileBytes += fileBytes;
+    entry.gpuBytes += gpuBytes;
+}
+
+void LoadReport::CountLoad(const std::string &path, const char *kind)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    asset(path, kind).loads++;
+}
+
+std::vector<LoadReport::Asset> LoadReport::Assets()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return assets;
+}
+
+std::string LoadReport::ToJSON()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    double totals[PHASE_COUNT] = {};
+    bool timed[PHASE_COUNT] = {};
+    std::ostringstream out;
+    out << "{\n  \"assets\": [";
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        const Asset &entry = assets[i];
+        out << (i ? ",\n" : "\n") << "    {\"path\": ";
+        writeString(out, entry.path);
+        out << ", \"kind\": ";
+        writeString(out, entry.kind);
+        out << ", \"loads\": " << entry.loads << ", \"phases_ms\": ";
+        writePhases(out, entry.ms, entry.timed);
+        out << ", \"vertices\": " << entry.vertices << ", \"indices\": " << entry.indices
+            << ", \"file_bytes\": " << entry.fileBytes << ", \"gpu_bytes\": " << entry.gpuBytes << '}';
+
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            totals[phase] += entry.ms[phase];
+            timed[phase] = timed[phase] || entry.timed[phase];
+        }
+    }
+    out << "\n  ],\n  \"totals_ms\": ";
+    writePhases(out, totals, timed);
+    out << "\n}\n";
+    return out.str();
+}
+
+bool LoadReport::WriteJSON(const char *path)
+{
+    std::string json = ToJSON();
+    FILE *out = fopen(path, "w");
+    if (!out)
+        return false;
+    bool ok = fwrite(json.data(), 1, json.size(), out) == json.size();
+    return (fclose(out) == 0) && ok;
+}
+
+void LoadReport::Reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    assets.clear();
+    assetIndex.clear();
+}
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *path) : data(nullptr), size(0), isEmpty(false)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+    {
+        if (st.st_size == 0)
+        {
+            // mmap rejects zero-length mappings, but an empty file is still valid input
+            isEmpty = true;
+        }
+        else
+        {
+            void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED)
+            {
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+uint64_t MappedFile::ContentHash() const
+{
+    return Hash(data, size);
+}
+
+uint64_t MappedFile::Hash(const void *bytes, size_t size)
+{
+    // Multiply/xorshift mix over 8-byte words
+    const char *data = static_cast<const char *>(bytes);
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++)
+    {
+        uint64_t w;
+        memcpy(&w, data + i * 8, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    for (size_t i = words * 8; i < size; i++)
+    {
+        h = (h ^ (unsigned char)data[i]) * 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 29;
+    }
+    return h ^ (h >> 33);
+}
+
+void MappedFile::Release(const char *upTo)
+{
+    if (!data || upTo <= data)
+        return;
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t length = ((size_t)(upTo - data) / pageSize) * pageSize;
+    if (length > 0)
+        madvise(const_cast<char *>(data), length, MADV_DONTNEED);
+}
+
+void MappedFile::Close()
+{
+    if (data)
+        munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+    isEmpty = false;
+}
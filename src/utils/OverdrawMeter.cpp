@@ -0,0 +1,84 @@
+#include "OverdrawMeter.h"
+
+#include <vector>
+
+OverdrawMeter::OverdrawMeter(int width, int height)
+    : shader("shaders/overdraw.vert", "shaders/overdraw.frag"), width(width), height(height),
+      previousBlendSrc(GL_ONE), previousBlendDst(GL_ZERO), blendWasEnabled(GL_FALSE)
+{
+    glGenTextures(1, &countTexture);
+    glBindTexture(GL_TEXTURE_2D, countTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, countTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Overdraw framebuffer incomplete" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void OverdrawMeter::Begin()
+{
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    blendWasEnabled = glIsEnabled(GL_BLEND);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &previousBlendSrc);
+    glGetIntegerv(GL_BLEND_DST_RGB, &previousBlendDst);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);
+}
+
+OverdrawMeter::Stats OverdrawMeter::End()
+{
+    std::vector<unsigned char> counts((size_t)width * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, counts.data());
+
+    Stats stats = {0, 0};
+    for (unsigned char count : counts)
+    {
+        stats.fragments += count;
+        if (count)
+            stats.pixels++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glBlendFunc(previousBlendSrc, previousBlendDst);
+    if (!blendWasEnabled)
+        glDisable(GL_BLEND);
+
+    return stats;
+}
+
+void OverdrawMeter::Show(int windowWidth, int windowHeight)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void OverdrawMeter::Delete()
+{
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &countTexture);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    shader.Delete();
+}
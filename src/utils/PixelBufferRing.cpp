@@ -0,0 +1,60 @@
+#include "PixelBufferRing.h"
+
+#include <cstring>
+
+PixelBufferRing::PixelBufferRing() : next(0), created(false)
+{
+    for (size_t i = 0; i < slotCount; i++)
+        buffers[i] = 0;
+}
+
+bool PixelBufferRing::Stage(const void *pixels, size_t bytes)
+{
+    if (!created)
+    {
+        glGenBuffers(slotCount, buffers);
+        created = true;
+    }
+
+    GLuint buffer = buffers[next];
+    next = (next + 1) % slotCount;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    // Orphan: fresh storage, while a pending upload keeps reading the old one
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    memcpy(mapped, pixels, bytes);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) != GL_TRUE)
+    {
+        // Contents were lost (e.g. a mode switch); upload from client memory
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    return true;
+}
+
+void PixelBufferRing::Unstage()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void PixelBufferRing::Delete()
+{
+    if (created)
+        glDeleteBuffers(slotCount, buffers);
+    for (size_t i = 0; i < slotCount; i++)
+        buffers[i] = 0;
+    created = false;
+}
+
+PixelBufferRing &PixelBufferRing::Shared()
+{
+    static PixelBufferRing ring;
+    return ring;
+}
@@ -0,0 +1,155 @@
+#include "ProgramCache.h"
+#include "MappedFile.h"
+#include "constants.h"
+
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <vector>
+
+namespace
+{
+    const char cacheMagic[4] = {'C', 'L', 'P', 'B'};
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint32_t keyLength;
+        uint32_t binaryLength;
+    };
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+}
+
+bool ProgramCache::Supported()
+{
+    // Core in 4.1; the 3.3 context needs the extension, without which the
+    // format query below is an invalid enum
+    if (!GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string ProgramCache::Key(const std::string &vertexSource, const std::string &fragmentSource)
+{
+    char hashes[40];
+    snprintf(hashes, sizeof(hashes), "%016llx %016llx",
+             (unsigned long long)MappedFile::Hash(vertexSource.data(), vertexSource.size()),
+             (unsigned long long)MappedFile::Hash(fragmentSource.data(), fragmentSource.size()));
+    return glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION) + "|" + hashes;
+}
+
+std::string ProgramCache::path(const std::string &key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.progbin", (unsigned long long)MappedFile::Hash(key.data(), key.size()));
+    return std::string(shaderCache::directory) + "/" + name;
+}
+
+bool ProgramCache::Load(GLuint program, const std::string &key)
+{
+    MappedFile file(path(key).c_str());
+    CacheHeader header;
+    if (file.size < sizeof(header))
+        return false;
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, cacheMagic, 4) != 0 || header.version != version || header.keyLength != key.size() ||
+        file.size != sizeof(header) + (size_t)header.keyLength + header.binaryLength ||
+        memcmp(file.data + sizeof(header), key.data(), key.size()) != 0)
+        return false;
+
+    glProgramBinary(program, header.binaryFormat, file.data + sizeof(header) + header.keyLength,
+                    header.binaryLength);
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success != GL_TRUE)
+        stats().rejected++;
+    return success == GL_TRUE;
+}
+
+bool ProgramCache::Save(GLuint program, const std::string &key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &binaryFormat, binary.data());
+    if (written <= 0)
+        return false;
+
+    mkdir(shaderCache::directory, 0755); // fails harmlessly once it exists
+
+    CacheHeader header;
+    memcpy(header.magic, cacheMagic, 4);
+    header.version = version;
+    header.binaryFormat = binaryFormat;
+    header.keyLength = key.size();
+    header.binaryLength = written;
+
+    // Written to a temporary and renamed, like the mesh cache
+    std::string finalPath = path(key);
+    std::string tempPath = finalPath + ".tmp";
+    FILE *out = fopen(tempPath.c_str(), "wb");
+    if (!out)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(key.data(), 1, key.size(), out) == key.size() &&
+              fwrite(binary.data(), 1, written, out) == (size_t)written;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok || rename(tempPath.c_str(), finalPath.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ProgramCache::Clear()
+{
+    DIR *dir = opendir(shaderCache::directory);
+    if (!dir)
+        return;
+    while (dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.size() > 8 && name.compare(name.size() - 8, 8, ".progbin") == 0)
+            remove((std::string(shaderCache::directory) + "/" + name).c_str());
+    }
+    closedir(dir);
+}
+
+ProgramCache::Stats &ProgramCache::stats()
+{
+    static Stats stats = {0, 0, 0, 0.0};
+    return stats;
+}
+
+void ProgramCache::Record(bool loaded, double milliseconds)
+{
+    Stats &total = stats();
+    total.programs++;
+    total.loaded += loaded;
+    total.milliseconds += milliseconds;
+}
+
+ProgramCache::Stats ProgramCache::GetStats()
+{
+    return stats();
+}
+
+void ProgramCache::ResetStats()
+{
+    stats() = Stats{0, 0, 0, 0.0};
+}
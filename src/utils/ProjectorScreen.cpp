@@ -1,4 +1,5 @@
 #include "../../include/ProjectorScreen.h"
+#include "../../include/VertexPacking.h"
 #include <iostream>
 #include <cmath>
 
@@ -127,11 +128,8 @@ void ProjectorScreen::UpdateScreenGeometry()
     if (numScreenIndices > 0)
     {
         screenVAO.Bind();
-        screenVBO = new VBO(screenVertices.data(), screenVertices.size() * sizeof(GLfloat));
+        screenVBO = VertexPacking::CreateColorVertexBuffer(screenVAO, screenVertices.data(), screenVertices.size() / 9, 9);
         screenEBO = new EBO(screenIndices.data(), screenIndices.size() * sizeof(GLuint));
-        screenVAO.LinkVBOAttrib(*screenVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-        screenVAO.LinkVBOAttrib(*screenVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-        screenVAO.LinkVBOAttrib(*screenVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
         screenVAO.Unbind();
         screenVBO->Unbind();
         screenEBO->Unbind();
@@ -167,16 +165,16 @@ void ProjectorScreen::ToggleScreen()
     targetExtension = isDroppedDown ? 1.0f : 0.0f;
 }
 
-void ProjectorScreen::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void ProjectorScreen::Draw(Shader &shader, glm::mat4 model)
 {
+    static const Shader::UniformHandle transparency = Shader::Uniform("transparency");
+
     if (screenExtension > 0.001f && numScreenIndices > 0)
     {
         shader.Activate();
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        shader.SetModel(model);
 
-        glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 1.0f);
+        shader.SetFloat(transparency, 1.0f);
 
         screenVAO.Bind();
         glDrawElements(GL_TRIANGLES, numScreenIndices, GL_UNSIGNED_INT, 0);
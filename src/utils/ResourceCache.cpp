@@ -0,0 +1,192 @@
+#include "ResourceCache.h"
+#include "models/Model.h"
+
+#include <climits>
+#include <cstdlib>
+
+std::string ResourceCache::CanonicalPath(const char *path)
+{
+    char resolved[PATH_MAX];
+    if (realpath(path, resolved))
+        return resolved;
+    return path;
+}
+
+ResourceCache &ResourceCache::Shared()
+{
+    static ResourceCache cache;
+    return cache;
+}
+
+Texture *ResourceCache::AcquireTexture(const char *path)
+{
+    std::string key = CanonicalPath(path);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = textures.find(key);
+    if (found != textures.end())
+    {
+        found->second.references++;
+        return found->second.resource;
+    }
+
+    Texture *texture = new Texture(path);
+    textures[key] = {texture, 1};
+    return texture;
+}
+
+Texture *ResourceCache::AcquireTexture(const TextureImage &image)
+{
+    std::string key = CanonicalPath(image.path.c_str());
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = textures.find(key);
+    if (found != textures.end())
+    {
+        found->second.references++;
+        return found->second.resource;
+    }
+
+    Texture *texture = new Texture(image);
+    textures[key] = {texture, 1};
+    return texture;
+}
+
+bool ResourceCache::HasTexture(const char *path)
+{
+    std::string key = CanonicalPath(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    return textures.count(key) != 0;
+}
+
+void ResourceCache::Release(Texture *texture)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = textures.begin(); it != textures.end(); ++it)
+    {
+        if (it->second.resource != texture)
+            continue;
+        if (--it->second.references == 0)
+        {
+            texture->Delete();
+            delete texture;
+            textures.erase(it);
+        }
+        return;
+    }
+}
+
+Shader *ResourceCache::AcquireShader(const char *vertexFile, const char *fragmentFile)
+{
+    std::string key = CanonicalPath(vertexFile) + "|" + CanonicalPath(fragmentFile);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = shaders.find(key);
+    if (found != shaders.end())
+    {
+        found->second.references++;
+        return found->second.resource;
+    }
+
+    Shader *shader = new Shader(vertexFile, fragmentFile);
+    shaders[key] = {shader, 1};
+    return shader;
+}
+
+void ResourceCache::Release(Shader *shader)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = shaders.begin(); it != shaders.end(); ++it)
+    {
+        if (it->second.resource != shader)
+            continue;
+        if (--it->second.references == 0)
+        {
+            shader->Delete();
+            delete shader;
+            shaders.erase(it);
+        }
+        return;
+    }
+}
+
+Model *ResourceCache::AcquireModel(const char *objFile, const ModelLoadOptions &options)
+{
+    bool created;
+    Model *model = ReserveModel(objFile, options, created);
+    // Loaded outside the lock: the model's own textures come from this cache
+    if (created)
+    {
+        model->Parse(objFile, options);
+        model->Upload();
+    }
+    return model;
+}
+
+Model *ResourceCache::ReserveModel(const char *objFile, const ModelLoadOptions &options, bool &created)
+{
+    // Other options give a different model (LODs, packing, buffers, arrays)
+    std::string key = CanonicalPath(objFile) + "|" + options.Key();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = models.find(key);
+    created = found == models.end();
+    if (!created)
+    {
+        found->second.references++;
+        return found->second.resource;
+    }
+
+    Model *model = new Model();
+    models[key] = {model, 1};
+    return model;
+}
+
+void ResourceCache::Release(Model *model)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = models.begin();
+        while (it != models.end() && it->second.resource != model)
+            ++it;
+        if (it == models.end() || --it->second.references > 0)
+            return;
+        models.erase(it);
+    }
+
+    // Outside the lock, since this releases the model's textures
+    model->Delete();
+    delete model;
+}
+
+
+void ResourceCache::Report()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t residentBytes = 0, savedBytes = 0;
+    for (const auto &pair : textures)
+    {
+        size_t bytes = pair.second.resource->gpuBytes;
+        residentBytes += bytes;
+        savedBytes += bytes * (pair.second.references - 1);
+    }
+    std::cout << "Resource cache: " << textures.size() << " textures, " << residentBytes / 1024 << " KB resident, "
+              << savedBytes / 1024 << " KB saved by sharing" << std::endl;
+
+    residentBytes = savedBytes = 0;
+    for (const auto &pair : models)
+    {
+        size_t bytes = pair.second.resource->BufferBytes();
+        residentBytes += bytes;
+        savedBytes += bytes * (pair.second.references - 1);
+    }
+    std::cout << "Resource cache: " << models.size() << " models, " << residentBytes / 1024 << " KB of buffers resident, "
+              << savedBytes / 1024 << " KB saved by sharing" << std::endl;
+
+    size_t sharedPrograms = 0;
+    for (const auto &pair : shaders)
+        sharedPrograms += pair.second.references - 1;
+    std::cout << "Resource cache: " << shaders.size() << " shader programs, " << sharedPrograms
+              << " compiles and links saved by sharing" << std::endl;
+}
@@ -0,0 +1,94 @@
+#include "SceneConfig.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // Whole number of at least 1
+    bool parseSize(const char *text, size_t &value)
+    {
+        char *end;
+        unsigned long parsed = strtoul(text, &end, 10);
+        if (end == text || *end || parsed < 1)
+            return false;
+        value = parsed;
+        return true;
+    }
+
+    // "RxC" with both at least 1
+    bool parseGrid(const char *text, int &rows, int &cols)
+    {
+        int r = 0, c = 0;
+        char separator = 0;
+        if (sscanf(text, "%d%c%d", &r, &separator, &c) != 3 || (separator != 'x' && separator != 'X') || r < 1 || c < 1)
+            return false;
+        rows = r;
+        cols = c;
+        return true;
+    }
+
+    void printUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " [--desks RxC] [--fans RxC] [--desk-model FILE] [--fan-model FILE]"
+                  << " [--load-report FILE] [--texture-budget MB] [--quiet]" << std::endl;
+    }
+}
+
+SceneConfig::SceneConfig()
+    : deskRows(furniture::rows), deskCols(furniture::cols),
+      fanRows(furniture::fanRows), fanCols(furniture::fanCols),
+      deskModel("models/desk.obj"), fanModel("models/classroom_fan.obj"), textureBudgetMB(0), quiet(false),
+      roomLength(room::length), roomWidth(room::width), roomHeight(room::height)
+{
+}
+
+bool SceneConfig::ParseArgs(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--desks") && hasValue && parseGrid(argv[i + 1], deskRows, deskCols))
+            i++;
+        else if (!strcmp(argv[i], "--fans") && hasValue && parseGrid(argv[i + 1], fanRows, fanCols))
+            i++;
+        else if (!strcmp(argv[i], "--desk-model") && hasValue)
+            deskModel = argv[++i];
+        else if (!strcmp(argv[i], "--fan-model") && hasValue)
+            fanModel = argv[++i];
+        else if (!strcmp(argv[i], "--load-report") && hasValue)
+            loadReportPath = argv[++i];
+        else if (!strcmp(argv[i], "--texture-budget") && hasValue && parseSize(argv[i + 1], textureBudgetMB))
+            i++;
+        else if (!strcmp(argv[i], "--quiet"))
+            quiet = true;
+        else
+        {
+            std::cerr << "Unknown or malformed option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    fitRoom();
+    return true;
+}
+
+float SceneConfig::ViewDistance() const
+{
+    return std::sqrt(roomLength * roomLength + roomWidth * roomWidth + roomHeight * roomHeight);
+}
+
+void SceneConfig::fitRoom()
+{
+    float gridLength = (deskCols - 1) * furniture::deskColSpacing + furniture::benchWidth;
+    float gridWidth = (deskRows - 1) * furniture::deskRowSpacing;
+
+    roomLength = std::max(room::length, gridLength + 2.0f * furniture::sideMargin);
+    roomWidth = std::max(room::width, furniture::backMargin + gridWidth + furniture::frontSpace);
+}
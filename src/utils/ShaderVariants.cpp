@@ -0,0 +1,51 @@
+#include "ShaderVariants.h"
+
+namespace
+{
+    // Define names by feature bit
+    const char *const featureNames[] = {"TEXTURED", "TEXTURE_ARRAY", "WHITE_PLASTIC", "FLOOR", "CEILING", "WALL", "BOARD",
+                                          "INSTANCED", "SPINNING"};
+}
+
+ShaderVariants::ShaderVariants(const char *vertexFile, const char *fragmentFile)
+    : vertexFile(vertexFile), fragmentFile(fragmentFile)
+{
+}
+
+std::vector<std::string> ShaderVariants::Defines(unsigned int features)
+{
+    std::vector<std::string> defines;
+    for (size_t bit = 0; bit < sizeof(featureNames) / sizeof(featureNames[0]); bit++)
+    {
+        if (features & (1u << bit))
+            defines.push_back(featureNames[bit]);
+    }
+    return defines;
+}
+
+Shader &ShaderVariants::Get(unsigned int features)
+{
+    auto found = variants.find(features);
+    if (found != variants.end())
+        return *found->second;
+
+    Shader *shader = new Shader(vertexFile.c_str(), fragmentFile.c_str(), Defines(features));
+    variants[features] = shader;
+    return *shader;
+}
+
+void ShaderVariants::Prepare(const std::vector<unsigned int> &featureSets)
+{
+    for (unsigned int features : featureSets)
+        Get(features);
+}
+
+void ShaderVariants::Delete()
+{
+    for (auto &variant : variants)
+    {
+        variant.second->Delete();
+        delete variant.second;
+    }
+    variants.clear();
+}
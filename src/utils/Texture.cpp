@@ -1,16 +1,92 @@
 #include "Texture.h"
+#include "LoadReport.h"
+#include "KtxFile.h"
+#include "PixelBufferRing.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <sys/stat.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
+void TextureImage::Free()
+{
+    if (pixels)
+        stbi_image_free(pixels);
+    pixels = nullptr;
+    if (baked)
+    {
+        baked->Delete();
+        delete baked;
+    }
+    baked = nullptr;
+}
+
 Texture::Texture(const char *imagePath, GLenum texType, GLint wrap, GLint filter)
 {
     type = texType;
-    loadTexture(imagePath, texType, wrap, filter);
+    TextureImage image = Decode(imagePath);
+    upload(image, texType, wrap, filter);
+    image.Free();
+}
+
+Texture::Texture(const TextureImage &image, GLenum texType, GLint wrap, GLint filter)
+{
+    type = texType;
+    upload(image, texType, wrap, filter);
 }
 
-void Texture::loadTexture(const char *imagePath, GLenum texType, GLint wrap, GLint filter)
+TextureImage Texture::Decode(const char *imagePath)
 {
+    TextureImage image;
+    image.path = imagePath;
+
+    LoadReport &report = LoadReport::Shared();
+    report.CountLoad(image.path, "texture");
+
+    // A current bake needs no decode; block-compressed ones also need S3TC,
+    // which core GL does not promise
+    LoadReport::Timer readTimer(image.path, "texture", LoadReport::FILE_READ);
+    image.baked = KtxFile::Open(KtxFile::BakedPath(imagePath).c_str(), imagePath);
+    if (image.baked && image.baked->Compressed() && !GLEW_EXT_texture_compression_s3tc)
+        image.Free();
+    readTimer.Stop();
+    if (image.baked)
+    {
+        image.width = image.baked->width;
+        image.height = image.baked->height;
+        image.nrChannels = image.baked->Channels();
+        report.AddCounts(image.path, "texture", 0, 0, image.baked->TotalBytes(), 0);
+        return image;
+    }
+
+    LoadReport::Timer timer(image.path, "texture", LoadReport::IMAGE_DECODE);
+
+    // The per-thread flag keeps concurrent decodes from racing on stb's global
+    stbi_set_flip_vertically_on_load_thread(true);
+    image.pixels = stbi_load(imagePath, &image.width, &image.height, &image.nrChannels, 0);
+
+    struct stat st;
+    if (image.pixels && stat(imagePath, &st) == 0)
+        report.AddCounts(image.path, "texture", 0, 0, st.st_size, 0);
+    return image;
+}
+
+std::vector<TextureImage> Texture::DecodeAll(const std::vector<std::string> &paths, ThreadPool &pool)
+{
+    std::vector<TextureImage> images(paths.size());
+    pool.ParallelFor(paths.size(), [&](size_t i)
+    {
+        images[i] = Decode(paths[i].c_str());
+    });
+    return images;
+}
+
+void Texture::upload(const TextureImage &image, GLenum texType, GLint wrap, GLint filter)
+{
+    gpuBytes = 0;
     glGenTextures(1, &ID);
     glBindTexture(texType, ID);
 
@@ -19,11 +95,16 @@ void Texture::loadTexture(const char *imagePath, GLenum texType, GLint wrap, GLi
     glTexParameteri(texType, GL_TEXTURE_MIN_FILTER, filter);
     glTexParameteri(texType, GL_TEXTURE_MAG_FILTER, filter);
 
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load(imagePath, &width, &height, &nrChannels, 0);
-
-    if (data)
+    if (texType == GL_TEXTURE_2D && (image.baked || image.pixels) && TextureStreamer::Shared().Enabled())
+        TextureStreamer::Shared().Register(*this, image);
+    else if (image.baked)
+        uploadBaked(image, texType);
+    else if (image.pixels)
     {
+        width = image.width;
+        height = image.height;
+        nrChannels = image.nrChannels;
+
         GLenum format;
         if (nrChannels == 1)
             format = GL_RED;
@@ -32,25 +113,71 @@ void Texture::loadTexture(const char *imagePath, GLenum texType, GLint wrap, GLi
         else if (nrChannels == 4)
             format = GL_RGBA;
 
-        glTexImage2D(texType, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        LoadReport &report = LoadReport::Shared();
+        auto uploadStart = std::chrono::steady_clock::now();
+        // stb rows are tightly packed; 1- and 3-channel rows need not be 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        PixelBufferRing &ring = PixelBufferRing::Shared();
+        bool staged = ring.Stage(image.pixels, size_t(width) * height * nrChannels);
+        glTexImage2D(texType, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, staged ? nullptr : image.pixels);
+        if (staged)
+            ring.Unstage();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        report.AddTime(image.path, "texture", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(uploadStart));
+
+        auto mipmapStart = std::chrono::steady_clock::now();
         glGenerateMipmap(texType);
+        report.AddTime(image.path, "texture", LoadReport::MIPMAP, LoadReport::MillisecondsSince(mipmapStart));
+        // Full mip chain adds about a third
+        gpuBytes = size_t(width) * height * nrChannels * 4 / 3;
+        report.AddCounts(image.path, "texture", 0, 0, 0, gpuBytes);
 
-        std::cout << "Texture loaded successfully: " << imagePath << " (" << width << "x" << height << ", " << nrChannels << " channels)" << std::endl;
+        if (!report.Quiet())
+            std::cout << "Texture loaded successfully: " << image.path << " (" << width << "x" << height << ", " << nrChannels << " channels)\n";
     }
     else
     {
-        std::cout << "Failed to load texture: " << imagePath << std::endl;
+        std::cout << "Failed to load texture: " << image.path << std::endl;
       
         unsigned char defaultData[] = {255, 255, 255, 255};
         glTexImage2D(texType, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, defaultData);
         width = height = 1;
         nrChannels = 4;
+        gpuBytes = 4;
     }
 
-    stbi_image_free(data);
     glBindTexture(texType, 0);
 }
 
+void Texture::uploadBaked(const TextureImage &image, GLenum texType)
+{
+    const KtxFile &ktx = *image.baked;
+    width = ktx.width;
+    height = ktx.height;
+    nrChannels = ktx.Channels();
+
+    // Every level comes from the bake, none are generated. Uncompressed rows
+    // are stored 4-byte aligned, GL's default unpack alignment.
+    LoadReport &report = LoadReport::Shared();
+    auto uploadStart = std::chrono::steady_clock::now();
+    glTexParameteri(texType, GL_TEXTURE_MAX_LEVEL, (GLint)ktx.levels.size() - 1);
+    for (size_t i = 0; i < ktx.levels.size(); i++)
+    {
+        const KtxFile::Level &level = ktx.levels[i];
+        if (ktx.Compressed())
+            glCompressedTexImage2D(texType, i, ktx.internalFormat, level.width, level.height, 0, level.size, level.data);
+        else
+            glTexImage2D(texType, i, ktx.internalFormat, level.width, level.height, 0, ktx.format, ktx.type, level.data);
+    }
+    report.AddTime(image.path, "texture", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(uploadStart));
+    gpuBytes = ktx.TotalBytes();
+    report.AddCounts(image.path, "texture", 0, 0, 0, gpuBytes);
+
+    if (!report.Quiet())
+        std::cout << "Texture loaded from bake: " << image.path << " (" << width << "x" << height << ", "
+                  << ktx.levels.size() << " levels" << (ktx.Compressed() ? ", block compressed" : "") << ")\n";
+}
+
 void Texture::texUnit(unsigned int shader, const char *uniform, GLuint unit)
 {
     glUseProgram(shader);
@@ -69,5 +196,6 @@ void Texture::Unbind()
 
 void Texture::Delete()
 {
+    TextureStreamer::Shared().Unregister(*this);
     glDeleteTextures(1, &ID);
-}
\ No newline at end of file
+}
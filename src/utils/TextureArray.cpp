@@ -0,0 +1,140 @@
+#include "TextureArray.h"
+#include "KtxFile.h"
+#include "LoadReport.h"
+#include "PixelBufferRing.h"
+
+#include <chrono>
+
+namespace
+{
+    GLenum pixelFormat(int channels)
+    {
+        if (channels == 1)
+            return GL_RED;
+        if (channels == 2)
+            return GL_RG;
+        return channels == 3 ? GL_RGB : GL_RGBA;
+    }
+}
+
+std::string TextureArray::CompatibilityKey(const TextureImage &image)
+{
+    std::string size = std::to_string(image.width) + "x" + std::to_string(image.height);
+    if (image.baked)
+        return size + " baked " + std::to_string(image.baked->internalFormat) + " " +
+               std::to_string(image.baked->levels.size());
+    return image.pixels ? size : std::string();
+}
+
+TextureArray::TextureArray(const std::vector<const TextureImage *> &images, GLint wrap, GLint filter)
+    : ID(0), width(images[0]->width), height(images[0]->height), layers(images.size()), gpuBytes(0)
+{
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+
+    if (images[0]->baked)
+        uploadBaked(images);
+    else
+        uploadDecoded(images);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    if (!LoadReport::Shared().Quiet())
+        std::cout << "Texture array: " << layers << " layers of " << width << "x" << height << '\n';
+}
+
+void TextureArray::uploadDecoded(const std::vector<const TextureImage *> &images)
+{
+    int channels = 3;
+    for (const TextureImage *image : images)
+        channels = image->nrChannels == 4 ? 4 : channels;
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, channels == 4 ? GL_RGBA8 : GL_RGB8, width, height, layers, 0,
+                 pixelFormat(channels), GL_UNSIGNED_BYTE, nullptr);
+
+    LoadReport &report = LoadReport::Shared();
+    PixelBufferRing &ring = PixelBufferRing::Shared();
+    // stb rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int layer = 0; layer < layers; layer++)
+    {
+        const TextureImage &image = *images[layer];
+        auto start = std::chrono::steady_clock::now();
+        size_t bytes = size_t(width) * height * image.nrChannels;
+        bool staged = ring.Stage(image.pixels, bytes);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, pixelFormat(image.nrChannels),
+                        GL_UNSIGNED_BYTE, staged ? nullptr : image.pixels);
+        if (staged)
+            ring.Unstage();
+        report.AddTime(image.path, "texture", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(start));
+        // Full mip chain adds about a third
+        report.AddCounts(image.path, "texture", 0, 0, 0, size_t(width) * height * channels * 4 / 3);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gpuBytes = size_t(width) * height * channels * layers * 4 / 3;
+
+    // One mipmap pass for every layer
+    auto start = std::chrono::steady_clock::now();
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    double perLayer = LoadReport::MillisecondsSince(start) / layers;
+    for (const TextureImage *image : images)
+        report.AddTime(image->path, "texture", LoadReport::MIPMAP, perLayer);
+}
+
+void TextureArray::uploadBaked(const std::vector<const TextureImage *> &images)
+{
+    const KtxFile &first = *images[0]->baked;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)first.levels.size() - 1);
+
+    // Storage for every level first, then each layer's levels from its mapping
+    for (size_t i = 0; i < first.levels.size(); i++)
+    {
+        const KtxFile::Level &level = first.levels[i];
+        if (first.Compressed())
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, first.internalFormat, level.width, level.height, layers, 0,
+                                   level.size * layers, nullptr);
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, i, first.internalFormat, level.width, level.height, layers, 0,
+                         first.format, first.type, nullptr);
+    }
+
+    LoadReport &report = LoadReport::Shared();
+    for (int layer = 0; layer < layers; layer++)
+    {
+        const KtxFile &ktx = *images[layer]->baked;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ktx.levels.size(); i++)
+        {
+            const KtxFile::Level &level = ktx.levels[i];
+            if (ktx.Compressed())
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1,
+                                          ktx.internalFormat, level.size, level.data);
+            else
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1, ktx.format, ktx.type,
+                                level.data);
+        }
+        report.AddTime(images[layer]->path, "texture", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(start));
+        report.AddCounts(images[layer]->path, "texture", 0, 0, 0, ktx.TotalBytes());
+        gpuBytes += ktx.TotalBytes();
+    }
+}
+
+void TextureArray::Bind()
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+}
+
+void TextureArray::Unbind()
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::Delete()
+{
+    glDeleteTextures(1, &ID);
+}
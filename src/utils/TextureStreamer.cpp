@@ -0,0 +1,500 @@
+#include "TextureStreamer.h"
+#include "Texture.h"
+#include "KtxFile.h"
+#include "LoadReport.h"
+#include "PixelBufferRing.h"
+#include "ThreadPool.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "stb/stb_image.h"
+
+namespace
+{
+    GLenum pixelFormat(int channels)
+    {
+        if (channels == 1)
+            return GL_RED;
+        if (channels == 2)
+            return GL_RG;
+        return channels == 3 ? GL_RGB : GL_RGBA;
+    }
+
+    // 2x2 box filter of a tightly packed image; odd sizes repeat the last
+    // row or column
+    void halve(const unsigned char *source, int width, int height, int channels, std::vector<unsigned char> &result)
+    {
+        int halfWidth = std::max(1, width / 2), halfHeight = std::max(1, height / 2);
+        result.resize(size_t(halfWidth) * halfHeight * channels);
+        for (int y = 0; y < halfHeight; y++)
+        {
+            const unsigned char *row0 = source + size_t(std::min(2 * y, height - 1)) * width * channels;
+            const unsigned char *row1 = source + size_t(std::min(2 * y + 1, height - 1)) * width * channels;
+            unsigned char *out = &result[size_t(y) * halfWidth * channels];
+            for (int x = 0; x < halfWidth; x++)
+            {
+                int x0 = std::min(2 * x, width - 1) * channels, x1 = std::min(2 * x + 1, width - 1) * channels;
+                for (int c = 0; c < channels; c++)
+                    out[x * channels + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+            }
+        }
+    }
+}
+
+TextureStreamer::TextureStreamer() : pool(nullptr), budgetBytes(0), nextId(0), frame(0), stats(), inFlight(0)
+{
+}
+
+void TextureStreamer::Enable(size_t budget, ThreadPool &threadPool)
+{
+    pool = &threadPool;
+    budgetBytes = budget;
+    stats.budgetBytes = budget;
+}
+
+void TextureStreamer::Register(Texture &texture, const TextureImage &image)
+{
+    Entry entry;
+    entry.id = nextId++;
+    entry.texture = &texture;
+    entry.path = image.path;
+    entry.baked = image.baked != nullptr;
+    if (image.baked)
+    {
+        const KtxFile &ktx = *image.baked;
+        entry.internalFormat = ktx.internalFormat;
+        entry.format = ktx.format;
+        entry.type = ktx.type;
+        entry.channels = ktx.Channels();
+        for (const KtxFile::Level &level : ktx.levels)
+            entry.levels.push_back({level.width, level.height, level.size});
+    }
+    else
+    {
+        entry.internalFormat = entry.format = pixelFormat(image.nrChannels);
+        entry.type = GL_UNSIGNED_BYTE;
+        entry.channels = image.nrChannels;
+        int width = image.width, height = image.height;
+        while (true)
+        {
+            entry.levels.push_back({width, height, size_t(width) * height * entry.channels});
+            if (width == 1 && height == 1)
+                break;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+
+    int start = 0;
+    while (start + 1 < (int)entry.levels.size() &&
+           std::max(entry.levels[start].width, entry.levels[start].height) > streaming::startSize)
+        start++;
+    entry.startLevel = entry.residentLevel = entry.targetLevel = start;
+    entry.requestedLevel = entry.levels.size();
+    entry.lastUsed = frame;
+    entry.retryFrame = 0;
+    entry.loading = false;
+    entry.failed = false;
+
+    // The starting levels are uploaded right away and do not count against
+    // the per-frame upload limit
+    LoadReport &report = LoadReport::Shared();
+    auto uploadStart = std::chrono::steady_clock::now();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)entry.levels.size() - 1);
+    if (image.baked)
+    {
+        for (size_t i = start; i < entry.levels.size(); i++)
+            uploadLevel(entry, i, image.baked->levels[i].data);
+    }
+    else
+    {
+        std::vector<unsigned char> current, next;
+        const unsigned char *pixels = image.pixels;
+        for (size_t i = 0; i < entry.levels.size(); i++)
+        {
+            if (i > 0)
+            {
+                halve(pixels, entry.levels[i - 1].width, entry.levels[i - 1].height, entry.channels, next);
+                current.swap(next);
+                pixels = current.data();
+            }
+            if ((int)i >= start)
+                uploadLevel(entry, i, pixels);
+        }
+    }
+    setBaseLevel(entry, start);
+    report.AddTime(image.path, "texture", LoadReport::GL_UPLOAD, LoadReport::MillisecondsSince(uploadStart));
+    report.AddCounts(image.path, "texture", 0, 0, 0, texture.gpuBytes);
+
+    texture.width = entry.levels[0].width;
+    texture.height = entry.levels[0].height;
+    texture.nrChannels = entry.channels;
+    stats.residentBytes += texture.gpuBytes;
+    stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+    entries[&texture] = entry;
+
+    if (!report.Quiet())
+        std::cout << "Texture streamed: " << image.path << " (" << texture.width << "x" << texture.height << ", "
+                  << entry.levels.size() << " levels, starting at " << entry.levels[start].width << "x"
+                  << entry.levels[start].height << ")\n";
+}
+
+void TextureStreamer::Unregister(const Texture &texture)
+{
+    auto found = entries.find(&texture);
+    if (found == entries.end())
+        return;
+    // A load still in flight finds no entry and is dropped
+    stats.residentBytes -= texture.gpuBytes;
+    entries.erase(found);
+}
+
+void TextureStreamer::Request(const Texture &texture, float texelsPerPixel)
+{
+    auto found = entries.find(&texture);
+    if (found == entries.end())
+        return;
+
+    Entry &entry = found->second;
+    int coarsest = entry.levels.size() - 1;
+    int level = 0;
+    if (texelsPerPixel > 1.0f)
+        level = (int)std::min<float>(std::floor(std::log2(texelsPerPixel)), coarsest);
+    entry.requestedLevel = std::min(entry.requestedLevel, level);
+    entry.lastUsed = frame;
+}
+
+void TextureStreamer::Update()
+{
+    if (!pool)
+        return;
+
+    // The frame's requests are the new targets; textures not drawn keep
+    // theirs but become evictable (see evictableLevel)
+    for (auto &pair : entries)
+    {
+        Entry &entry = pair.second;
+        if (entry.requestedLevel < (int)entry.levels.size())
+            entry.targetLevel = entry.requestedLevel;
+        entry.requestedLevel = entry.levels.size();
+    }
+
+    std::vector<Load> loads;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loads.swap(finished);
+    }
+    size_t uploadBytes = 0;
+    std::vector<Load> carried;
+    for (Load &load : loads)
+    {
+        finishLoad(load, uploadBytes);
+        if (!load.data.empty())
+            carried.push_back(std::move(load));
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Visible textures short of their target, furthest behind first
+    std::vector<Entry *> wanted;
+    size_t visible = 0, atTarget = 0;
+    for (auto &pair : entries)
+    {
+        Entry &entry = pair.second;
+        if (entry.lastUsed != frame)
+            continue;
+        visible++;
+        if (entry.residentLevel <= entry.targetLevel)
+            atTarget++;
+        else if (!entry.loading && !entry.failed && frame >= entry.retryFrame)
+            wanted.push_back(&entry);
+    }
+    std::stable_sort(wanted.begin(), wanted.end(), [](const Entry *a, const Entry *b)
+    {
+        return a->residentLevel - a->targetLevel > b->residentLevel - b->targetLevel;
+    });
+
+    size_t running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Load &load : carried)
+            finished.push_back(std::move(load));
+        running = inFlight;
+    }
+    for (Entry *entry : wanted)
+    {
+        if (running >= streaming::maxLoadsInFlight)
+            break;
+        startLoad(*entry);
+        running++;
+    }
+
+    stats.textures = entries.size();
+    stats.texturesVisible = visible;
+    stats.texturesAtTarget = atTarget;
+    stats.loadsInFlight = running;
+    frame++;
+}
+
+TextureStreamer::Load TextureStreamer::loadLevels(const Entry &entry, int first, int last)
+{
+    Load load;
+    load.id = entry.id;
+    load.first = first;
+    load.last = last;
+
+    if (entry.baked)
+    {
+        // Copied out of the mapping here, so the page faults happen on the worker
+        KtxFile *ktx = KtxFile::Open(KtxFile::BakedPath(entry.path.c_str()).c_str(), entry.path.c_str());
+        if (ktx && ktx->levels.size() == entry.levels.size() && ktx->internalFormat == entry.internalFormat)
+        {
+            for (int i = first; i <= last; i++)
+                load.data.emplace_back(ktx->levels[i].data, ktx->levels[i].data + ktx->levels[i].size);
+        }
+        if (ktx)
+        {
+            ktx->Delete();
+            delete ktx;
+        }
+        return load;
+    }
+
+    // Decoded like Texture::Decode, then filtered down to the wanted levels
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(true);
+    unsigned char *pixels = stbi_load(entry.path.c_str(), &width, &height, &channels, entry.channels);
+    if (!pixels || width != entry.levels[0].width || height != entry.levels[0].height)
+    {
+        if (pixels)
+            stbi_image_free(pixels);
+        return load;
+    }
+
+    std::vector<unsigned char> current, next;
+    const unsigned char *source = pixels;
+    for (int i = 0; i <= last; i++)
+    {
+        if (i > 0)
+        {
+            halve(source, entry.levels[i - 1].width, entry.levels[i - 1].height, entry.channels, next);
+            current.swap(next);
+            source = current.data();
+        }
+        if (i >= first)
+            load.data.emplace_back(source, source + entry.levels[i].bytes);
+    }
+    stbi_image_free(pixels);
+    return load;
+}
+
+void TextureStreamer::startLoad(Entry &entry)
+{
+    entry.loading = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight++;
+    }
+
+    Entry source = entry;
+    int first = entry.targetLevel, last = entry.residentLevel - 1;
+    pool->Enqueue([this, source, first, last]
+    {
+        Load load = loadLevels(source, first, last);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(load));
+            inFlight--;
+        }
+        loadFinished.notify_all();
+    });
+}
+
+void TextureStreamer::finishLoad(Load &load, size_t &uploadBytes)
+{
+    Entry *entry = nullptr;
+    for (auto &pair : entries)
+    {
+        if (pair.second.id == load.id)
+            entry = &pair.second;
+    }
+    bool failed = load.data.empty();
+    std::vector<std::vector<unsigned char>> data;
+    data.swap(load.data);
+    if (!entry)
+        return;
+
+    entry->loading = false;
+    if (failed)
+    {
+        entry->failed = true;
+        std::cerr << "Texture streaming: failed to load " << entry->path << std::endl;
+        return;
+    }
+    // Evicted meanwhile, so the levels no longer join the resident ones
+    if (load.last != entry->residentLevel - 1)
+        return;
+
+    // Coarse to fine, so every uploaded level extends the resident range
+    int level = load.last;
+    for (; level >= load.first; level--)
+    {
+        size_t bytes = entry->levels[level].bytes;
+        if (uploadBytes >= streaming::uploadBytesPerFrame)
+            break;
+        if (!makeRoom(bytes, *entry))
+        {
+            entry->retryFrame = frame + streaming::retryFrames;
+            level = load.first - 1;
+            break;
+        }
+        glBindTexture(GL_TEXTURE_2D, entry->texture->ID);
+        uploadLevel(*entry, level, data[level - load.first].data());
+        setBaseLevel(*entry, level);
+        uploadBytes += bytes;
+        stats.residentBytes += bytes;
+        stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+        stats.levelsUploaded++;
+        stats.bytesUploaded += bytes;
+    }
+
+    // What the per-frame limit held back waits for the next frame
+    if (level >= load.first)
+    {
+        data.resize(level - load.first + 1);
+        load.data.swap(data);
+        load.last = level;
+        entry->loading = true;
+    }
+}
+
+void TextureStreamer::uploadLevel(const Entry &entry, int level, const void *data)
+{
+    const Level &size = entry.levels[level];
+    if (entry.type == 0)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry.internalFormat, size.width, size.height, 0, size.bytes, data);
+        return;
+    }
+
+    // Filtered rows are tightly packed, baked ones 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, entry.baked ? 4 : 1);
+    PixelBufferRing &ring = PixelBufferRing::Shared();
+    bool staged = ring.Stage(data, size.bytes);
+    glTexImage2D(GL_TEXTURE_2D, level, entry.internalFormat, size.width, size.height, 0, entry.format, entry.type,
+                 staged ? nullptr : data);
+    if (staged)
+        ring.Unstage();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureStreamer::setBaseLevel(Entry &entry, int level)
+{
+    entry.residentLevel = level;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+    size_t bytes = 0;
+    for (size_t i = level; i < entry.levels.size(); i++)
+        bytes += entry.levels[i].bytes;
+    entry.texture->gpuBytes = bytes;
+}
+
+int TextureStreamer::evictableLevel(const Entry &entry) const
+{
+    // Levels finer than the returned one may go: for textures drawn this
+    // frame those finer than requested, for the rest all but the starting ones
+    return entry.lastUsed == frame ? entry.targetLevel : entry.startLevel;
+}
+
+bool TextureStreamer::makeRoom(size_t bytes, const Entry &forEntry)
+{
+    while (stats.residentBytes + bytes > budgetBytes)
+    {
+        // Least recently used first; among equals the one freeing the most
+        Entry *victim = nullptr;
+        for (auto &pair : entries)
+        {
+            Entry &entry = pair.second;
+            if (&entry == &forEntry || entry.residentLevel >= evictableLevel(entry))
+                continue;
+            if (!victim || entry.lastUsed < victim->lastUsed ||
+                (entry.lastUsed == victim->lastUsed &&
+                 entry.levels[entry.residentLevel].bytes > victim->levels[victim->residentLevel].bytes))
+                victim = &entry;
+        }
+        if (!victim)
+            return false;
+
+        int level = victim->residentLevel;
+        glBindTexture(GL_TEXTURE_2D, victim->texture->ID);
+        setBaseLevel(*victim, level + 1);
+        // Respecified empty, which lets the driver release the level
+        if (victim->type == 0)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, victim->internalFormat, 0, 0, 0, 0, nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, victim->internalFormat, 0, 0, 0, victim->format, victim->type, nullptr);
+        stats.residentBytes -= victim->levels[level].bytes;
+        stats.levelsEvicted++;
+    }
+    return true;
+}
+
+int TextureStreamer::ResidentLevel(const Texture &texture) const
+{
+    auto found = entries.find(&texture);
+    return found == entries.end() ? -1 : found->second.residentLevel;
+}
+
+int TextureStreamer::TargetLevel(const Texture &texture) const
+{
+    auto found = entries.find(&texture);
+    return found == entries.end() ? -1 : found->second.targetLevel;
+}
+
+TextureStreamer::Stats TextureStreamer::GetStats() const
+{
+    return stats;
+}
+
+void TextureStreamer::Report() const
+{
+    std::cout << "Texture streaming: " << stats.textures << " textures, " << stats.residentBytes / 1024 << " KB of "
+              << stats.budgetBytes / 1024 << " KB budget resident (peak " << stats.peakResidentBytes / 1024 << " KB), "
+              << stats.texturesAtTarget << " of " << stats.texturesVisible << " visible at target, "
+              << stats.loadsInFlight << " loads in flight, " << stats.levelsUploaded << " levels ("
+              << stats.bytesUploaded / 1024 << " KB) uploaded, " << stats.levelsEvicted << " evicted" << std::endl;
+    if (LoadReport::Shared().Quiet())
+        return;
+
+    for (const auto &pair : entries)
+    {
+        const Entry &entry = pair.second;
+        const Level &resident = entry.levels[entry.residentLevel];
+        const Level &target = entry.levels[entry.targetLevel];
+        std::cout << "  " << entry.path << ": level " << entry.residentLevel << " (" << resident.width << "x"
+                  << resident.height << ") resident, level " << entry.targetLevel << " (" << target.width << "x"
+                  << target.height << ") wanted" << (entry.loading ? ", loading" : "")
+                  << (entry.failed ? ", failed" : "") << std::endl;
+    }
+}
+
+void TextureStreamer::Delete()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        loadFinished.wait(lock, [this] { return inFlight == 0; });
+        finished.clear();
+    }
+    entries.clear();
+    stats.textures = stats.residentBytes = stats.loadsInFlight = 0;
+    pool = nullptr;
+}
+
+TextureStreamer &TextureStreamer::Shared()
+{
+    static TextureStreamer streamer;
+    return streamer;
+}
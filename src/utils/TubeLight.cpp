@@ -1,4 +1,6 @@
 #include "TubeLight.h"
+#include "VertexPacking.h"
+#include "ResourceCache.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <cmath>
@@ -8,7 +10,7 @@ TubeLight::TubeLight(float roomLength, float roomWidth, float roomHeight)
     tubeVBO = nullptr;
     tubeEBO = nullptr;
 
-    emissiveShader = new Shader("shaders/emissive.vert", "shaders/emissive.frag");
+    emissiveShader = ResourceCache::Shared().AcquireShader("shaders/emissive.vert", "shaders/emissive.frag");
 
     generateTubeLight(roomLength, roomWidth, roomHeight);
     setupTubeLight();
@@ -120,25 +122,19 @@ void TubeLight::setupTubeLight()
 {
     tubeVAO.Bind();
 
-    tubeVBO = new VBO((GLfloat *)vertices.data(), vertices.size() * sizeof(TubeLightVertex));
+    tubeVBO = VertexPacking::CreateColorVertexBuffer(tubeVAO, (const GLfloat *)vertices.data(), vertices.size(), 9);
     tubeEBO = new EBO(indices.data(), indices.size() * sizeof(unsigned int));
 
-    tubeVAO.LinkVBOAttrib(*tubeVBO, 0, 3, GL_FLOAT, sizeof(TubeLightVertex), (void *)0);
-    tubeVAO.LinkVBOAttrib(*tubeVBO, 1, 3, GL_FLOAT, sizeof(TubeLightVertex), (void *)(offsetof(TubeLightVertex, Color)));
-    tubeVAO.LinkVBOAttrib(*tubeVBO, 2, 3, GL_FLOAT, sizeof(TubeLightVertex), (void *)(offsetof(TubeLightVertex, Normal)));
-
     tubeVAO.Unbind();
     tubeVBO->Unbind();
     tubeEBO->Unbind();
 }
 
-void TubeLight::Draw(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void TubeLight::Draw(glm::mat4 model)
 {
     emissiveShader->Activate();
 
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(emissiveShader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    emissiveShader->SetModel(model);
 
     tubeVAO.Bind();
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
@@ -160,7 +156,7 @@ void TubeLight::Delete()
     }
     if (emissiveShader)
     {
-        emissiveShader->Delete();
-        delete emissiveShader;
+        ResourceCache::Shared().Release(emissiveShader);
+        emissiveShader = nullptr;
     }
 }
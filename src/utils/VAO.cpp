@@ -5,14 +5,20 @@ VAO::VAO()
     glGenVertexArrays(1, &ID);
 }
 
-void VAO::LinkVBOAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset)
+void VAO::LinkVBOAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset, GLboolean normalized)
 {
     VBO.Bind();
-    glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
+    glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
     glEnableVertexAttribArray(layout);
     VBO.Unbind();
 }
 
+void VAO::LinkInstanceAttrib(VBO &VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void *offset)
+{
+    LinkVBOAttrib(VBO, layout, numComponents, type, stride, offset);
+    glVertexAttribDivisor(layout, 1);
+}
+
 void VAO::LinkAttribWithAlpha(VBO &VBO)
 {
     VBO.Bind();
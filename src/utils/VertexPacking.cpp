@@ -0,0 +1,208 @@
+#include "VertexPacking.h"
+#include "constants.h"
+#include "models/Model.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+GLushort VertexPacking::FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return GLushort(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return GLushort(sign | 0x7C00);
+    if (exponent <= 0)
+    {
+        // Subnormal half, or zero below its range
+        if (exponent < -10)
+            return GLushort(sign);
+        mantissa |= 0x800000;
+        uint32_t shift = uint32_t(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+        return GLushort(sign | half);
+    }
+
+    // Round to nearest; a carry into the exponent is still the right value
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        half++;
+    return GLushort(half);
+}
+
+float VertexPacking::HalfToFloat(GLushort value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        float magnitude = std::ldexp(float(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31)
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void VertexPacking::OctEncode(const glm::vec3 &normal, GLshort encoded[2])
+{
+    float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    float x = sum > 0.0f ? normal.x / sum : 0.0f;
+    float y = sum > 0.0f ? normal.y / sum : 0.0f;
+
+    // Fold the lower hemisphere over the diagonals
+    if (normal.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    encoded[0] = GLshort(std::lround(glm::clamp(x, -1.0f, 1.0f) * 32767.0f));
+    encoded[1] = GLshort(std::lround(glm::clamp(y, -1.0f, 1.0f) * 32767.0f));
+}
+
+glm::vec3 VertexPacking::OctDecode(const GLshort encoded[2])
+{
+    // Same as octDecode() in shaders/texture.vert
+    glm::vec3 n(std::max(encoded[0] / 32767.0f, -1.0f), std::max(encoded[1] / 32767.0f, -1.0f), 0.0f);
+    n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    float length = glm::length(n);
+    return length > 0.0f ? n / length : n;
+}
+
+GLuint VertexPacking::PackSnorm10(const glm::vec3 &normal)
+{
+    GLuint packed = 0;
+    const float components[3] = {normal.x, normal.y, normal.z};
+    for (int i = 0; i < 3; i++)
+    {
+        int value = int(std::lround(glm::clamp(components[i], -1.0f, 1.0f) * 511.0f));
+        packed |= GLuint(value & 0x3FF) << (10 * i);
+    }
+    return packed;
+}
+
+glm::vec3 VertexPacking::UnpackSnorm10(GLuint packed)
+{
+    float components[3];
+    for (int i = 0; i < 3; i++)
+    {
+        int value = int((packed >> (10 * i)) & 0x3FF);
+        if (value & 0x200)
+            value -= 0x400;
+        components[i] = std::max(value / 511.0f, -1.0f);
+    }
+    return glm::vec3(components[0], components[1], components[2]);
+}
+
+GLushort VertexPacking::QuantizeUnorm16(float value, float offset, float scale)
+{
+    float normalized = scale > 0.0f ? (value - offset) / scale : 0.0f;
+    return GLushort(std::lround(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+}
+
+std::vector<PackedVertex> VertexPacking::PackVertices(const Vertex *vertices, size_t count, glm::vec3 &offset, glm::vec3 &scale)
+{
+    glm::vec3 lower(0.0f), upper(0.0f);
+    for (size_t i = 0; i < count; i++)
+    {
+        lower = i ? glm::min(lower, vertices[i].Position) : vertices[i].Position;
+        upper = i ? glm::max(upper, vertices[i].Position) : vertices[i].Position;
+    }
+    offset = lower;
+    scale = upper - lower;
+    return PackVerticesInBounds(vertices, count, offset, scale);
+}
+
+std::vector<PackedVertex> VertexPacking::PackVerticesInBounds(const Vertex *vertices, size_t count, const glm::vec3 &offset,
+                                                              const glm::vec3 &scale)
+{
+    std::vector<PackedVertex> packed(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vertex &vertex = vertices[i];
+        PackedVertex &out = packed[i];
+        out.position[0] = QuantizeUnorm16(vertex.Position.x, offset.x, scale.x);
+        out.position[1] = QuantizeUnorm16(vertex.Position.y, offset.y, scale.y);
+        out.position[2] = QuantizeUnorm16(vertex.Position.z, offset.z, scale.z);
+        out.position[3] = 0;
+        OctEncode(vertex.Normal, out.normal);
+        out.texCoords[0] = FloatToHalf(vertex.TexCoords.x);
+        out.texCoords[1] = FloatToHalf(vertex.TexCoords.y);
+    }
+    return packed;
+}
+
+Vertex VertexPacking::UnpackVertex(const PackedVertex &packed, const glm::vec3 &offset, const glm::vec3 &scale)
+{
+    Vertex vertex;
+    vertex.Position = offset + glm::vec3(packed.position[0], packed.position[1], packed.position[2]) / 65535.0f * scale;
+    vertex.Normal = OctDecode(packed.normal);
+    vertex.TexCoords = glm::vec2(HalfToFloat(packed.texCoords[0]), HalfToFloat(packed.texCoords[1]));
+    return vertex;
+}
+
+std::vector<PackedColorVertex> VertexPacking::PackColorVertices(const GLfloat *data, size_t vertexCount, size_t stride)
+{
+    std::vector<PackedColorVertex> packed(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const GLfloat *source = data + i * stride;
+        PackedColorVertex &vertex = packed[i];
+        vertex.position[0] = source[0];
+        vertex.position[1] = source[1];
+        vertex.position[2] = source[2];
+        vertex.color[0] = FloatToHalf(source[3]);
+        vertex.color[1] = FloatToHalf(source[4]);
+        vertex.color[2] = FloatToHalf(source[5]);
+        vertex.color[3] = FloatToHalf(stride > 9 ? source[9] : 1.0f);
+        vertex.normal = PackSnorm10(glm::vec3(source[6], source[7], source[8]));
+    }
+    return packed;
+}
+
+VBO *VertexPacking::CreateColorVertexBuffer(VAO &vao, const GLfloat *data, size_t vertexCount, size_t stride)
+{
+    VBO *vbo;
+    if (vertexFormat::packed)
+    {
+        std::vector<PackedColorVertex> packed = PackColorVertices(data, vertexCount, stride);
+        vbo = new VBO((GLfloat *)packed.data(), packed.size() * sizeof(PackedColorVertex));
+        vao.LinkVBOAttrib(*vbo, 0, 3, GL_FLOAT, sizeof(PackedColorVertex), (void *)offsetof(PackedColorVertex, position));
+        vao.LinkVBOAttrib(*vbo, 1, 3, GL_HALF_FLOAT, sizeof(PackedColorVertex), (void *)offsetof(PackedColorVertex, color));
+        vao.LinkVBOAttrib(*vbo, 2, 4, GL_INT_2_10_10_10_REV, sizeof(PackedColorVertex), (void *)offsetof(PackedColorVertex, normal), GL_TRUE);
+        if (stride > 9)
+            vao.LinkVBOAttrib(*vbo, 3, 1, GL_HALF_FLOAT, sizeof(PackedColorVertex), (void *)(offsetof(PackedColorVertex, color) + 3 * sizeof(GLushort)));
+        return vbo;
+    }
+
+    vbo = new VBO(const_cast<GLfloat *>(data), vertexCount * stride * sizeof(GLfloat));
+    vao.LinkVBOAttrib(*vbo, 0, 3, GL_FLOAT, stride * sizeof(float), (void *)0);
+    vao.LinkVBOAttrib(*vbo, 1, 3, GL_FLOAT, stride * sizeof(float), (void *)(3 * sizeof(float)));
+    vao.LinkVBOAttrib(*vbo, 2, 3, GL_FLOAT, stride * sizeof(float), (void *)(6 * sizeof(float)));
+    if (stride > 9)
+        vao.LinkVBOAttrib(*vbo, 3, 1, GL_FLOAT, stride * sizeof(float), (void *)(9 * sizeof(float)));
+    return vbo;
+}
@@ -1,4 +1,5 @@
 #include "../../include/Windows.h"
+#include "../../include/VertexPacking.h"
 #include <iostream>
 
 Windows::Windows(float roomLength, float roomWidth, float roomHeight, int numWindows)
@@ -187,37 +188,30 @@ Windows::Windows(float roomLength, float roomWidth, float roomHeight, int numWin
 
     // Create VAO/VBO/EBO for glass
     glassVAO.Bind();
-    glassVBO = new VBO(glassVertices.data(), glassVertices.size() * sizeof(GLfloat));
+    glassVBO = VertexPacking::CreateColorVertexBuffer(glassVAO, glassVertices.data(), glassVertices.size() / 10, 10);
     glassEBO = new EBO(glassIndices.data(), glassIndices.size() * sizeof(GLuint));
-    glassVAO.LinkVBOAttrib(*glassVBO, 0, 3, GL_FLOAT, 10 * sizeof(float), (void *)0);
-    glassVAO.LinkVBOAttrib(*glassVBO, 1, 3, GL_FLOAT, 10 * sizeof(float), (void *)(3 * sizeof(float)));
-    glassVAO.LinkVBOAttrib(*glassVBO, 2, 3, GL_FLOAT, 10 * sizeof(float), (void *)(6 * sizeof(float)));
-    glassVAO.LinkVBOAttrib(*glassVBO, 3, 1, GL_FLOAT, 10 * sizeof(float), (void *)(9 * sizeof(float)));
     glassVAO.Unbind();
     glassVBO->Unbind();
     glassEBO->Unbind();
 
     // Create VAO/VBO/EBO for frames
     frameVAO.Bind();
-    frameVBO = new VBO(frameVertices.data(), frameVertices.size() * sizeof(GLfloat));
+    frameVBO = VertexPacking::CreateColorVertexBuffer(frameVAO, frameVertices.data(), frameVertices.size() / 9, 9);
     frameEBO = new EBO(frameIndices.data(), frameIndices.size() * sizeof(GLuint));
-    frameVAO.LinkVBOAttrib(*frameVBO, 0, 3, GL_FLOAT, 9 * sizeof(float), (void *)0);
-    frameVAO.LinkVBOAttrib(*frameVBO, 1, 3, GL_FLOAT, 9 * sizeof(float), (void *)(3 * sizeof(float)));
-    frameVAO.LinkVBOAttrib(*frameVBO, 2, 3, GL_FLOAT, 9 * sizeof(float), (void *)(6 * sizeof(float)));
     frameVAO.Unbind();
     frameVBO->Unbind();
     frameEBO->Unbind();
 }
 
-void Windows::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void Windows::Draw(Shader &shader, glm::mat4 model)
 {
+    static const Shader::UniformHandle transparency = Shader::Uniform("transparency");
+
     shader.Activate();
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    shader.SetModel(model);
 
     // Draw opaque white frames FIRST
-    glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 1.0f);
+    shader.SetFloat(transparency, 1.0f);
     frameVAO.Bind();
     glDrawElements(GL_TRIANGLES, numFrameIndices, GL_UNSIGNED_INT, 0);
 
@@ -228,7 +222,7 @@ void Windows::Draw(Shader &shader, glm::mat4 model, glm::mat4 view, glm::mat4 pr
     // Disable depth writing for glass so background shows through
     glDepthMask(GL_FALSE);
 
-    glUniform1f(glGetUniformLocation(shader.ID, "transparency"), 0.15f); // 15% opacity
+    shader.SetFloat(transparency, 0.15f); // 15% opacity
     glassVAO.Bind();
     glDrawElements(GL_TRIANGLES, numGlassIndices, GL_UNSIGNED_INT, 0);
 
@@ -1,4 +1,38 @@
 #include "shaderClass.h"
+#include "FrameUniforms.h"
+#include "ProgramCache.h"
+#include "RenderStats.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+namespace
+{
+    std::map<std::string, Shader::UniformHandle>& uniformNames()
+    {
+        static std::map<std::string, Shader::UniformHandle> names;
+        return names;
+    }
+
+    // GLSL requires #version first, so the defines go right after it; #line
+    // keeps compiler messages pointing at the file's own lines
+    std::string withDefines(const std::string& source, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+            return source;
+        size_t versionEnd = source.compare(0, 8, "#version") == 0 ? source.find('\n') : std::string::npos;
+        size_t insertAt = versionEnd == std::string::npos ? 0 : versionEnd + 1;
+        std::string lines;
+        for (const std::string& define : defines)
+            lines += "#define " + define + "\n";
+        lines += "#line " + std::to_string(insertAt ? 2 : 1) + "\n";
+        return source.substr(0, insertAt) + lines + source.substr(insertAt);
+    }
+}
 
 std::string get_file_contents(const char* filename)
 {
@@ -15,13 +49,34 @@ std::string get_file_contents(const char* filename)
     throw(errno);
 }
 
-Shader::Shader(const char* vertexFile, const char* fragmentFile)
+Shader::Shader(const char* vertexFile, const char* fragmentFile, const std::vector<std::string>& defines)
 {
-    std::string vertexCode = get_file_contents(vertexFile);
-    std::string fragmentCode = get_file_contents(fragmentFile);
-    const char* vertexSource = vertexCode.c_str();
-    const char* fragmentSource = fragmentCode.c_str();
+    auto start = std::chrono::steady_clock::now();
+    std::string vertexCode = withDefines(get_file_contents(vertexFile), defines);
+    std::string fragmentCode = withDefines(get_file_contents(fragmentFile), defines);
 
+    ID = glCreateProgram();
+
+    // A binary saved by an earlier launch skips compiling and linking
+    bool cacheable = ProgramCache::Supported();
+    std::string cacheKey;
+    bool loaded = false;
+    if (cacheable)
+    {
+        cacheKey = ProgramCache::Key(vertexCode, fragmentCode);
+        loaded = ProgramCache::Load(ID, cacheKey);
+    }
+    if (!loaded && compileAndLink(vertexCode.c_str(), fragmentCode.c_str(), cacheable) && cacheable)
+        ProgramCache::Save(ID, cacheKey);
+
+    reflectUniforms();
+    bindFrameBlock();
+
+    ProgramCache::Record(loaded, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+bool Shader::compileAndLink(const char* vertexSource, const char* fragmentSource, bool retrievable)
+{
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vertexSource, NULL);
     glCompileShader(vertexShader);
@@ -44,9 +99,11 @@ Shader::Shader(const char* vertexFile, const char* fragmentFile)
         std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
 
-    ID = glCreateProgram();
     glAttachShader(ID, vertexShader);
     glAttachShader(ID, fragmentShader);
+    // Only with program binaries: a 3.3 context may lack glProgramParameteri
+    if (retrievable)
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
 
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
@@ -55,8 +112,149 @@ Shader::Shader(const char* vertexFile, const char* fragmentFile)
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
 
+    glDetachShader(ID, vertexShader);
+    glDetachShader(ID, fragmentShader);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    return success;
+}
+
+Shader::UniformHandle Shader::Uniform(const char* name)
+{
+    std::map<std::string, UniformHandle>& names = uniformNames();
+    auto found = names.find(name);
+    if (found != names.end())
+        return found->second;
+    UniformHandle handle = names.size();
+    names[name] = handle;
+    return handle;
+}
+
+void Shader::reflectUniforms()
+{
+    uniforms.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(std::max(maxLength, 1));
+
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint size = 0;
+        GLenum type = 0;
+        GLsizei length = 0;
+        glGetActiveUniform(ID, i, buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Arrays are reported as "name[0]"; every element gets a handle, and
+        // the bare name stands for element 0 as in glGetUniformLocation
+        std::vector<std::string> names;
+        if (size > 1 || (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0))
+        {
+            std::string base = name.substr(0, name.rfind('['));
+            names.push_back(base);
+            for (GLint element = 0; element < size; element++)
+                names.push_back(base + "[" + std::to_string(element) + "]");
+        }
+        else
+            names.push_back(name);
+
+        for (const std::string& uniformName : names)
+        {
+            GLint location = glGetUniformLocation(ID, uniformName.c_str());
+            if (location < 0)
+                continue;
+            UniformHandle handle = Uniform(uniformName.c_str());
+            if (handle >= uniforms.size())
+                uniforms.resize(handle + 1, UniformSlot{-1, false, {}});
+            uniforms[handle] = UniformSlot{location, false, {}};
+        }
+    }
+}
+
+void Shader::bindFrameBlock()
+{
+    // GLSL 3.30 has no layout(binding), so the block index is looked up here
+    GLuint index = glGetUniformBlockIndex(ID, FrameUniforms::blockName);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, FrameUniforms::binding);
+}
+
+bool Shader::HasUniform(UniformHandle uniform) const
+{
+    return uniform < uniforms.size() && uniforms[uniform].location >= 0;
+}
+
+Shader::UniformSlot* Shader::changed(UniformHandle uniform, const void* value, size_t bytes)
+{
+    if (!HasUniform(uniform))
+        return nullptr;
+    UniformSlot& slot = uniforms[uniform];
+    if (slot.set && memcmp(slot.value, value, bytes) == 0)
+        return nullptr;
+    memcpy(slot.value, value, bytes);
+    slot.set = true;
+    RenderStats::Frame().uniformCalls++;
+    return &slot;
+}
+
+void Shader::SetInt(UniformHandle uniform, GLint value)
+{
+    if (UniformSlot* slot = changed(uniform, &value, sizeof(value)))
+        glUniform1i(slot->location, value);
+}
+
+void Shader::SetFloat(UniformHandle uniform, GLfloat value)
+{
+    if (UniformSlot* slot = changed(uniform, &value, sizeof(value)))
+        glUniform1f(slot->location, value);
+}
+
+void Shader::SetVec3(UniformHandle uniform, const glm::vec3& value)
+{
+    if (UniformSlot* slot = changed(uniform, glm::value_ptr(value), sizeof(glm::vec3)))
+        glUniform3fv(slot->location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetMat3(UniformHandle uniform, const glm::mat3& value)
+{
+    if (UniformSlot* slot = changed(uniform, glm::value_ptr(value), sizeof(glm::mat3)))
+        glUniformMatrix3fv(slot->location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::SetMat4(UniformHandle uniform, const glm::mat4& value)
+{
+    if (UniformSlot* slot = changed(uniform, glm::value_ptr(value), sizeof(glm::mat4)))
+        glUniformMatrix4fv(slot->location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::SetModel(const glm::mat4& model)
+{
+    static const UniformHandle modelUniform = Uniform("model");
+    static const UniformHandle normalMatrixUniform = Uniform("normalMatrix");
+    // The normal matrix only needs working out when the model matrix changed
+    if (UniformSlot* slot = changed(modelUniform, glm::value_ptr(model), sizeof(glm::mat4)))
+    {
+        glUniformMatrix4fv(slot->location, 1, GL_FALSE, glm::value_ptr(model));
+        if (HasUniform(normalMatrixUniform))
+            SetMat3(normalMatrixUniform, NormalMatrix(model));
+    }
+}
+
+glm::mat3 Shader::NormalMatrix(const glm::mat4& model)
+{
+    glm::mat3 linear(model);
+    float xx = glm::dot(linear[0], linear[0]);
+    float yy = glm::dot(linear[1], linear[1]);
+    float zz = glm::dot(linear[2], linear[2]);
+    float tolerance = 1e-5f * std::max(xx, std::max(yy, zz));
+    bool uniformScale = std::fabs(xx - yy) <= tolerance && std::fabs(xx - zz) <= tolerance;
+    bool orthogonal = std::fabs(glm::dot(linear[0], linear[1])) <= tolerance &&
+                      std::fabs(glm::dot(linear[0], linear[2])) <= tolerance &&
+                      std::fabs(glm::dot(linear[1], linear[2])) <= tolerance;
+    if (uniformScale && orthogonal)
+        return linear;
+    return glm::transpose(glm::inverse(linear));
 }
 
 void Shader::Activate()
@@ -67,4 +265,5 @@ void Shader::Activate()
 void Shader::Delete()
 {
     glDeleteProgram(ID);
+    uniforms.clear();
 }
\ No newline at end of file
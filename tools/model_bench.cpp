@@ -0,0 +1,1330 @@
+// Load-time benchmark for Model.
+//
+// Compares the original getline/istringstream OBJ reader (kept here verbatim as
+// a reference) with the current Model loader on the shipped fan model and on a
+// synthetic multi-million-face OBJ, and checks that both produce identical meshes.
+// Pass --only before or --only after to run one loader and report its peak RSS.
+// Pass --cache to compare a cold start (parse + write .meshcache) with a warm
+// start that loads the cache.
+// Pass --threads to time the chunked parallel parser at 1, 2, 4, 8 and 16
+// chunks on a generated 5M-triangle model (override with --faces); the
+// chunks run on the shared thread pool, so speedup levels off at its size.
+// Pass --async to compare loading the startup models synchronously with the
+// background ModelLoader driven by a simulated render loop.
+// Pass --optimize to report vertex cache statistics and load time with and
+// without the post-load triangle/vertex reordering, and check both draw the
+// same triangles.
+// Pass --overdraw to count shaded fragments per pixel (OverdrawMeter) from
+// eight viewpoints around each model with and without the overdraw pass; run
+// it with LIBGL_ALWAYS_SOFTWARE=1 for comparable counts.
+// Pass --packed to compare vertex/index memory of the float and packed
+// upload formats and check the packed data decodes within tolerance.
+// Pass --lod to time LOD chain generation and report triangles per level and
+// what Model::Draw submits as the camera backs away.
+// Pass --normals to clear each model's normals and time regenerating them with
+// a naive single-threaded reference and with MeshNormals (checking both agree),
+// then time tangent generation.
+// Pass --textures to time decoding and uploading image files (by default 32
+// copies of the shipped textures) one after the other, and with the thread
+// pool decoding at 1, 2, 4, ... threads and uploads staged through pixel
+// buffer objects. Images with a current bake (scripts/texture_bake.sh) load
+// from it in both cases.
+// Pass --resources to request every model twice through the ResourceCache
+// (synchronously and via ModelLoader) and report the GPU memory sharing saved.
+// Pass --drawcalls to count the GL calls of drawing each model as main.cpp's
+// 5x5 desk grid, with per-mesh buffers and 2D textures, with merged
+// buffers and texture arrays, and instanced (Model::DrawInstanced); the
+// instanced draws are counted again for a 20x20 grid, static and spinning
+// like the fans (a frame at a new time must not rewrite the instance buffer).
+// Pass --streaming to stream 64 texture copies on a row of quads within a
+// 32 MB budget (override with --budget MB) while the camera walks along the
+// row, reporting resident bytes and how many visible textures reached the
+// level their distance asks for.
+// Pass --vertex to time drawing each model as the 5x5 desk grid into a
+// one-pixel viewport, i.e. mostly the vertex shader; run it with
+// LIBGL_ALWAYS_SOFTWARE=1 to measure llvmpipe.
+// Pass --shaders to time creating the scene's shader programs with an empty
+// program binary cache (compiling every one) and again once it is filled.
+// With any mode, --report FILE writes the detailed LoadReport JSON of every
+// load the run made, and --quiet drops the loaders' per-asset logging.
+//
+// Build and run with scripts/bench.sh.
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#include "models/Model.h"
+#include "models/ModelLoader.h"
+#include "models/MeshOptimizer.h"
+#include "OverdrawMeter.h"
+#include "FrameUniforms.h"
+#include "ProgramCache.h"
+#include "ShaderVariants.h"
+#include "ResourceCache.h"
+#include "RenderStats.h"
+#include "LoadReport.h"
+#include "VertexPacking.h"
+#include "ThreadPool.h"
+#include "TextureStreamer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include "models/MeshCache.h"
+
+namespace
+{
+    struct ReferenceMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    // Baseline vertex lookup, unchanged from the original Model::processVertex
+    void referenceProcessVertex(const std::string &vertexStr, const std::vector<glm::vec3> &temp_vertices,
+                                const std::vector<glm::vec2> &temp_uvs, const std::vector<glm::vec3> &temp_normals,
+                                std::map<std::string, unsigned int> &vertexMap, ReferenceMesh &currentMesh)
+    {
+        auto it = vertexMap.find(vertexStr);
+        if (it != vertexMap.end())
+        {
+            currentMesh.indices.push_back(it->second);
+            return;
+        }
+
+        std::string mutableVertexStr = vertexStr;
+        std::replace(mutableVertexStr.begin(), mutableVertexStr.end(), '/', ' ');
+        std::istringstream vertexStream(mutableVertexStr);
+
+        unsigned int vertexIndex = 0, uvIndex = 0, normalIndex = 0;
+        vertexStream >> vertexIndex >> uvIndex >> normalIndex;
+        vertexIndex--;
+        uvIndex--;
+        normalIndex--;
+
+        Vertex vertex;
+        vertex.Position = vertexIndex < temp_vertices.size() ? temp_vertices[vertexIndex] : glm::vec3(0.0f);
+        vertex.TexCoords = uvIndex < temp_uvs.size() ? temp_uvs[uvIndex] : glm::vec2(0.0f);
+        vertex.Normal = normalIndex < temp_normals.size() ? glm::normalize(temp_normals[normalIndex])
+                                                          : glm::vec3(0.0f, 1.0f, 0.0f);
+
+        currentMesh.vertices.push_back(vertex);
+        unsigned int newIndex = currentMesh.vertices.size() - 1;
+        vertexMap[vertexStr] = newIndex;
+        currentMesh.indices.push_back(newIndex);
+    }
+
+    // Baseline OBJ reader, unchanged from the original Model::loadOBJ apart from
+    // skipping materials (the benchmark inputs have none that resolve)
+    std::vector<ReferenceMesh> referenceLoadOBJ(const char *objFile)
+    {
+        std::vector<ReferenceMesh> meshes;
+        std::ifstream file(objFile);
+        if (!file.is_open())
+            return meshes;
+
+        std::vector<glm::vec3> temp_vertices;
+        std::vector<glm::vec2> temp_uvs;
+        std::vector<glm::vec3> temp_normals;
+
+        ReferenceMesh currentMesh;
+        std::map<std::string, unsigned int> vertexMap;
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream iss(line);
+            std::string prefix;
+            iss >> prefix;
+
+            if (prefix == "v")
+            {
+                glm::vec3 vertex(0.0f);
+                iss >> vertex.x >> vertex.y >> vertex.z;
+                temp_vertices.push_back(vertex);
+            }
+            else if (prefix == "vt")
+            {
+                glm::vec2 uv(0.0f);
+                iss >> uv.x >> uv.y;
+                temp_uvs.push_back(uv);
+            }
+            else if (prefix == "vn")
+            {
+                glm::vec3 normal(0.0f);
+                iss >> normal.x >> normal.y >> normal.z;
+                temp_normals.push_back(normal);
+            }
+            else if (prefix == "usemtl")
+            {
+                if (!currentMesh.vertices.empty())
+                    meshes.push_back(currentMesh);
+                currentMesh = ReferenceMesh();
+                vertexMap.clear();
+            }
+            else if (prefix == "f")
+            {
+                std::vector<std::string> faceVertices;
+                std::string vertexStr;
+                while (iss >> vertexStr)
+                    faceVertices.push_back(vertexStr);
+
+                for (size_t i = 1; i + 1 < faceVertices.size(); i++)
+                {
+                    // Quads and n-gons both end up as a fan around corner 0
+                    referenceProcessVertex(faceVertices[0], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
+                    referenceProcessVertex(faceVertices[i], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
+                    referenceProcessVertex(faceVertices[i + 1], temp_vertices, temp_uvs, temp_normals, vertexMap, currentMesh);
+                }
+            }
+        }
+
+        if (!currentMesh.vertices.empty())
+            meshes.push_back(currentMesh);
+        return meshes;
+    }
+
+    bool sameVertex(const Vertex &a, const Vertex &b)
+    {
+        return memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+
+    bool sameMeshes(const Model &a, const Model &b)
+    {
+        if (a.meshes.size() != b.meshes.size())
+            return false;
+        for (size_t m = 0; m < a.meshes.size(); m++)
+        {
+            const Mesh &x = a.meshes[m];
+            const Mesh &y = b.meshes[m];
+            if (x.indices != y.indices || x.vertices.size() != y.vertices.size())
+                return false;
+            // Materials belong to each model; compare them by name
+            if ((x.material == nullptr) != (y.material == nullptr) ||
+                (x.material && x.material->name != y.material->name))
+                return false;
+            for (size_t i = 0; i < x.vertices.size(); i++)
+                if (!sameVertex(x.vertices[i], y.vertices[i]))
+                    return false;
+        }
+        return true;
+    }
+
+    bool sameOutput(const std::vector<ReferenceMesh> &reference, const Model &model)
+    {
+        if (reference.size() != model.meshes.size())
+            return false;
+        for (size_t m = 0; m < reference.size(); m++)
+        {
+            const ReferenceMesh &a = reference[m];
+            const Mesh &b = model.meshes[m];
+            if (a.indices != b.indices || a.vertices.size() != b.vertices.size())
+                return false;
+            for (size_t i = 0; i < a.vertices.size(); i++)
+                if (!sameVertex(a.vertices[i], b.vertices[i]))
+                    return false;
+        }
+        return true;
+    }
+
+    // Writes a UV-mapped height-field grid with roughly `faces` quads
+    std::string writeSyntheticOBJ(size_t faces)
+    {
+        size_t side = std::max<size_t>(1, (size_t)std::sqrt((double)faces));
+        std::string path = "/tmp/classroom_synthetic_" + std::to_string(side * side) + ".obj";
+
+        std::ifstream existing(path);
+        if (existing.good())
+            return path;
+
+        FILE *out = fopen(path.c_str(), "w");
+        if (!out)
+            return path;
+
+        fprintf(out, "# synthetic benchmark grid, %zu quads\no Grid\n", side * side);
+        for (size_t z = 0; z <= side; z++)
+        {
+            for (size_t x = 0; x <= side; x++)
+            {
+                float fx = (float)x / side, fz = (float)z / side;
+                float h = 0.05f * std::sin(fx * 40.0f) * std::cos(fz * 40.0f);
+                fprintf(out, "v %.6f %.6f %.6f\n", fx * 10.0f - 5.0f, h, fz * 10.0f - 5.0f);
+                fprintf(out, "vt %.6f %.6f\n", fx, fz);
+                fprintf(out, "vn %.6f %.6f %.6f\n", -h, 1.0f, h);
+            }
+        }
+        fprintf(out, "usemtl Grid\ns 1\n");
+        for (size_t z = 0; z < side; z++)
+        {
+            for (size_t x = 0; x < side; x++)
+            {
+                size_t a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+                fprintf(out, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            }
+        }
+        fclose(out);
+        return path;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    enum BenchMode
+    {
+        BENCH_BOTH,
+        BENCH_BEFORE,
+        BENCH_AFTER
+    };
+
+    long peakRSSKilobytes()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    void benchmarkFile(const std::string &path, int runs, BenchMode mode)
+    {
+        double referenceMs = 1e30, modelMs = 1e30;
+        std::vector<ReferenceMesh> reference;
+        bool identical = true;
+        size_t triangles = 0;
+
+        for (int run = 0; run < runs; run++)
+        {
+            if (mode != BENCH_AFTER)
+            {
+                auto start = std::chrono::steady_clock::now();
+                reference = referenceLoadOBJ(path.c_str());
+                referenceMs = std::min(referenceMs, millisecondsSince(start));
+
+                triangles = 0;
+                for (const ReferenceMesh &mesh : reference)
+                    triangles += mesh.indices.size() / 3;
+            }
+
+            if (mode != BENCH_BEFORE)
+            {
+                ModelLoadOptions options;
+                options.useCache = false;
+                options.optimizeMeshes = false;
+                options.generateLods = false;
+
+                auto start = std::chrono::steady_clock::now();
+                Model model(path.c_str(), options);
+                modelMs = std::min(modelMs, millisecondsSince(start));
+
+                if (mode == BENCH_BOTH)
+                    identical = identical && sameOutput(reference, model);
+                triangles = 0;
+                for (const Mesh &mesh : model.meshes)
+                    triangles += mesh.indices.size() / 3;
+                model.Delete();
+            }
+        }
+
+        if (mode != BENCH_BOTH)
+        {
+            printf("%-48s %10zu tris  %s %9.1f ms  peak RSS %8.1f MB\n", path.c_str(), triangles,
+                   mode == BENCH_BEFORE ? "before" : "after ", mode == BENCH_BEFORE ? referenceMs : modelMs,
+                   peakRSSKilobytes() / 1024.0);
+            return;
+        }
+
+        printf("%-48s %10zu tris  before %9.1f ms  after %9.1f ms  speedup %5.2fx  output %s\n",
+               path.c_str(), triangles, referenceMs, modelMs, referenceMs / modelMs,
+               identical ? "identical" : "MISMATCH");
+    }
+
+    void benchmarkThreads(const std::string &path, int runs)
+    {
+        ModelLoadOptions serialOptions;
+        serialOptions.useCache = false;
+        serialOptions.parseThreads = 1;
+        serialOptions.generateLods = false;
+        Model serial(path.c_str(), serialOptions);
+
+        double serialMs = 0.0;
+        const unsigned int threadCounts[] = {1, 2, 4, 8, 16};
+        for (unsigned int threads : threadCounts)
+        {
+            ModelLoadOptions options;
+            options.useCache = false;
+            options.parseThreads = threads;
+            options.generateLods = false;
+
+            double bestMs = 1e30;
+            bool identical = true;
+            for (int run = 0; run < runs; run++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                Model model(path.c_str(), options);
+                bestMs = std::min(bestMs, millisecondsSince(start));
+                identical = identical && sameMeshes(serial, model);
+                model.Delete();
+            }
+            if (threads == 1)
+                serialMs = bestMs;
+
+            printf("%-48s %2u threads %9.1f ms  speedup %5.2fx  output %s\n", path.c_str(), threads, bestMs,
+                   serialMs / bestMs, identical ? "identical" : "MISMATCH");
+        }
+        serial.Delete();
+    }
+
+    void benchmarkCache(const std::string &path, int runs)
+    {
+        double coldMs = 1e30, warmMs = 1e30;
+        size_t triangles = 0;
+
+        for (int run = 0; run < runs; run++)
+        {
+            MeshCache::Clear(path.c_str());
+
+            auto start = std::chrono::steady_clock::now();
+            Model cold(path.c_str());
+            coldMs = std::min(coldMs, millisecondsSince(start));
+            cold.Delete();
+
+            start = std::chrono::steady_clock::now();
+            Model warm(path.c_str());
+            warmMs = std::min(warmMs, millisecondsSince(start));
+
+            triangles = 0;
+            for (const Mesh &mesh : warm.meshes)
+                triangles += mesh.indexCount / 3;
+            warm.Delete();
+        }
+
+        printf("%-48s %10zu tris  cold %9.1f ms  warm %9.1f ms  speedup %5.2fx\n",
+               path.c_str(), triangles, coldMs, warmMs, coldMs / warmMs);
+    }
+
+    // Triangles of a mesh as vertex triples, rotated so the smallest vertex
+    // comes first (keeps winding) and sorted, so the order does not matter
+    std::vector<std::string> canonicalTriangles(const Mesh &mesh)
+    {
+        std::vector<std::string> triangles;
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            std::string corners[3];
+            for (int k = 0; k < 3; k++)
+                corners[k].assign((const char *)&mesh.vertices[mesh.indices[i + k]], sizeof(Vertex));
+            int first = 0;
+            for (int k = 1; k < 3; k++)
+                if (corners[k] < corners[first])
+                    first = k;
+            triangles.push_back(corners[first] + corners[(first + 1) % 3] + corners[(first + 2) % 3]);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void benchmarkOptimize(const std::string &path, int runs)
+    {
+        double plainMs = 1e30, optimizedMs = 1e30;
+        bool sameTriangles = true;
+        MeshOptimizer::CacheStats before = {}, after = {};
+
+        for (int run = 0; run < runs; run++)
+        {
+            ModelLoadOptions options;
+            options.useCache = false;
+            options.optimizeMeshes = false;
+            options.generateLods = false;
+
+            auto start = std::chrono::steady_clock::now();
+            Model plain(path.c_str(), options);
+            plainMs = std::min(plainMs, millisecondsSince(start));
+
+            options.optimizeMeshes = true;
+            start = std::chrono::steady_clock::now();
+            Model optimized(path.c_str(), options);
+            optimizedMs = std::min(optimizedMs, millisecondsSince(start));
+
+            before = after = MeshOptimizer::CacheStats();
+            sameTriangles = plain.meshes.size() == optimized.meshes.size();
+            for (size_t i = 0; sameTriangles && i < plain.meshes.size(); i++)
+            {
+                const Mesh &a = plain.meshes[i], &b = optimized.meshes[i];
+                MeshOptimizer::CacheStats statsA = MeshOptimizer::AnalyzeVertexCache(a.indices, a.vertices.size());
+                MeshOptimizer::CacheStats statsB = MeshOptimizer::AnalyzeVertexCache(b.indices, b.vertices.size());
+                before.triangles += statsA.triangles;
+                before.vertices += statsA.vertices;
+                before.transformed += statsA.transformed;
+                after.transformed += statsB.transformed;
+                sameTriangles = canonicalTriangles(a) == canonicalTriangles(b);
+            }
+
+            plain.Delete();
+            optimized.Delete();
+        }
+
+        double triangles = std::max<size_t>(before.triangles, 1), vertices = std::max<size_t>(before.vertices, 1);
+        printf("%-48s %10zu tris  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  load %8.1f -> %8.1f ms  triangles %s\n",
+               path.c_str(), before.triangles, before.transformed / triangles, after.transformed / triangles,
+               before.transformed / vertices, after.transformed / vertices, plainMs, optimizedMs,
+               sameTriangles ? "identical" : "MISMATCH");
+    }
+
+    OverdrawMeter::Stats measureOverdraw(OverdrawMeter &meter, FrameUniforms &frame, Model &model)
+    {
+        glm::vec3 lower(1e30f), upper(-1e30f);
+        for (const Mesh &mesh : model.meshes)
+        {
+            for (const Vertex &vertex : mesh.vertices)
+            {
+                lower = glm::min(lower, vertex.Position);
+                upper = glm::max(upper, vertex.Position);
+            }
+        }
+        glm::vec3 center = (lower + upper) * 0.5f;
+        float radius = std::max(glm::length(upper - lower) * 0.5f, 1e-3f);
+
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, radius * 0.1f, radius * 10.0f);
+        OverdrawMeter::Stats total = {0, 0};
+        for (int view = 0; view < 8; view++)
+        {
+            // Around the model, alternately from above and below
+            float angle = glm::radians(45.0f * view);
+            glm::vec3 eye = center + radius * 2.5f * glm::vec3(cosf(angle), view % 2 ? 0.5f : -0.3f, sinf(angle));
+            glm::mat4 viewMatrix = glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+
+            frame.SetCamera(viewMatrix, projection, eye);
+            frame.Upload();
+            meter.Begin();
+            model.Draw(meter.shader, glm::mat4(1.0f), viewMatrix, projection);
+            OverdrawMeter::Stats stats = meter.End();
+            total.fragments += stats.fragments;
+            total.pixels += stats.pixels;
+        }
+        return total;
+    }
+
+    void benchmarkOverdraw(const std::string &path)
+    {
+        OverdrawMeter meter(512, 512);
+        FrameUniforms frame;
+        glEnable(GL_DEPTH_TEST);
+
+        double ratio[2], acmr[2];
+        for (int pass = 0; pass < 2; pass++)
+        {
+            ModelLoadOptions options;
+            options.useCache = false;
+            options.optimizeOverdraw = pass == 1;
+            options.generateLods = false;
+            Model model(path.c_str(), options);
+
+            size_t triangles = 0, transformed = 0;
+            for (const Mesh &mesh : model.meshes)
+            {
+                MeshOptimizer::CacheStats stats = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+                triangles += stats.triangles;
+                transformed += stats.transformed;
+            }
+            acmr[pass] = triangles ? double(transformed) / triangles : 0.0;
+            ratio[pass] = measureOverdraw(meter, frame, model).Ratio();
+            model.Delete();
+        }
+        meter.Delete();
+        frame.Delete();
+
+        printf("%-48s overdraw %.3f -> %.3f fragments/pixel  ACMR %.3f -> %.3f\n",
+               path.c_str(), ratio[0], ratio[1], acmr[0], acmr[1]);
+    }
+
+    // Decoding tolerances for --packed; below what a 1200px frame can show
+    const float packedPositionTolerance = 1e-4f; // of the bounds diagonal
+    const float packedNormalToleranceDegrees = 0.1f;
+    const float packedTexCoordTolerance = 1.0f / 1024.0f;
+
+    void benchmarkPacked(const std::string &path)
+    {
+        ModelLoadOptions options;
+        options.useCache = false;
+        Model model(path.c_str(), options);
+
+        size_t floatBytes = 0, packedBytes = 0;
+        float positionError = 0.0f, normalError = 0.0f, texCoordError = 0.0f;
+        for (const Mesh &mesh : model.meshes)
+        {
+            floatBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+            packedBytes += mesh.vertices.size() * sizeof(PackedVertex) +
+                           mesh.indices.size() * (mesh.vertices.size() <= 65536 ? sizeof(GLushort) : sizeof(unsigned int));
+
+            glm::vec3 offset, scale;
+            std::vector<PackedVertex> packed = VertexPacking::PackVertices(mesh.vertices.data(), mesh.vertices.size(), offset, scale);
+            float diagonal = std::max(glm::length(scale), 1e-6f);
+            for (size_t i = 0; i < packed.size(); i++)
+            {
+                const Vertex &original = mesh.vertices[i];
+                Vertex decoded = VertexPacking::UnpackVertex(packed[i], offset, scale);
+                positionError = std::max(positionError, glm::length(decoded.Position - original.Position) / diagonal);
+                texCoordError = std::max(texCoordError, glm::length(decoded.TexCoords - original.TexCoords));
+                if (glm::length(original.Normal) > 0.0f)
+                {
+                    float cosine = glm::clamp(glm::dot(glm::normalize(original.Normal), decoded.Normal), -1.0f, 1.0f);
+                    normalError = std::max(normalError, glm::degrees(acosf(cosine)));
+                }
+            }
+        }
+        model.Delete();
+
+        bool withinTolerance = positionError <= packedPositionTolerance && normalError <= packedNormalToleranceDegrees &&
+                               texCoordError <= packedTexCoordTolerance;
+        printf("%-48s %9.1f KB -> %9.1f KB (%.0f%%)  max error: position %.2g, normal %.3f deg, uv %.2g  %s\n",
+               path.c_str(), floatBytes / 1024.0, packedBytes / 1024.0, 100.0 * packedBytes / std::max<size_t>(floatBytes, 1),
+               positionError, normalError, texCoordError, withinTolerance ? "within tolerance" : "OUT OF TOLERANCE");
+    }
+
+    // Straightforward per-corner smooth normals for --normals: one thread,
+    // array-of-structs, positions welded through a std::map. Same rule as
+    // MeshNormals::GenerateNormals (angle-weighted faces around the position
+    // within the crease angle) so the results can be compared corner by corner.
+    std::vector<glm::vec3> referenceNormals(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                            float creaseAngle)
+    {
+        size_t triangleCount = indices.size() / 3;
+        std::vector<glm::vec3> faceNormals(triangleCount);
+        std::vector<float> weights(triangleCount * 3);
+        std::map<std::vector<float>, std::vector<size_t>> cornersAt;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            glm::vec3 p[3];
+            for (int k = 0; k < 3; k++)
+                p[k] = vertices[indices[t * 3 + k]].Position;
+            glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            bool degenerate = glm::length(normal) <= 1e-6f * glm::length(p[1] - p[0]) * glm::length(p[2] - p[0]);
+            faceNormals[t] = degenerate ? glm::vec3(0.0f) : glm::normalize(normal);
+            for (int k = 0; k < 3; k++)
+            {
+                cornersAt[{p[k].x, p[k].y, p[k].z}].push_back(t * 3 + k);
+                if (degenerate)
+                    continue;
+                glm::vec3 u = p[(k + 1) % 3] - p[k], v = p[(k + 2) % 3] - p[k];
+                float lengths = glm::length(u) * glm::length(v);
+                weights[t * 3 + k] = lengths > 0.0f ? std::acos(std::min(1.0f, std::max(-1.0f, glm::dot(u, v) / lengths))) : 0.0f;
+            }
+        }
+
+        float cosCrease = std::cos(glm::radians(creaseAngle));
+        std::vector<glm::vec3> normals(triangleCount * 3);
+        for (size_t c = 0; c < normals.size(); c++)
+        {
+            const glm::vec3 &own = faceNormals[c / 3];
+            const glm::vec3 &position = vertices[indices[c]].Position;
+            glm::vec3 sum(0.0f);
+            for (size_t other : cornersAt[{position.x, position.y, position.z}])
+            {
+                if (own != glm::vec3(0.0f) && glm::dot(own, faceNormals[other / 3]) < cosCrease)
+                    continue;
+                sum += weights[other] * faceNormals[other / 3];
+            }
+            normals[c] = glm::length(sum) > 0.0f ? glm::normalize(sum) : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        return normals;
+    }
+
+    void benchmarkNormals(const std::string &path, int runs)
+    {
+        // Parsed meshes with every normal cleared, as if the OBJ had no "vn"
+        ModelLoadOptions options;
+        options.useCache = false;
+        options.generateNormals = false;
+        options.optimizeMeshes = false;
+        options.generateLods = false;
+        Model model;
+        model.Parse(path.c_str(), options);
+        size_t triangles = 0, vertices = 0;
+        for (Mesh &mesh : model.meshes)
+        {
+            for (Vertex &vertex : mesh.vertices)
+                vertex.Normal = glm::vec3(0.0f);
+            triangles += mesh.indices.size() / 3;
+            vertices += mesh.vertices.size();
+        }
+
+        double referenceMs = 1e30, generatedMs = 1e30, tangentMs = 1e30;
+        size_t splitVertices = 0, tangentVertices = 0;
+        float worstDegrees = 0.0f;
+        for (int run = 0; run < runs; run++)
+        {
+            std::vector<std::vector<glm::vec3>> expected;
+            auto start = std::chrono::steady_clock::now();
+            for (const Mesh &mesh : model.meshes)
+                expected.push_back(referenceNormals(mesh.vertices, mesh.indices, normals::creaseAngle));
+            referenceMs = std::min(referenceMs, millisecondsSince(start));
+
+            std::vector<Mesh> meshes = model.meshes;
+            start = std::chrono::steady_clock::now();
+            for (Mesh &mesh : meshes)
+                MeshNormals::GenerateNormals(mesh.vertices, mesh.indices, normals::creaseAngle, MeshNormals::ANGLE_WEIGHTED,
+                                             ThreadPool::Shared());
+            generatedMs = std::min(generatedMs, millisecondsSince(start));
+
+            splitVertices = 0;
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                splitVertices += meshes[i].vertices.size() - model.meshes[i].vertices.size();
+                for (size_t c = 0; c < expected[i].size(); c++)
+                {
+                    float cosine = glm::dot(expected[i][c], meshes[i].vertices[meshes[i].indices[c]].Normal);
+                    worstDegrees = std::max(worstDegrees, glm::degrees(std::acos(std::min(1.0f, cosine))));
+                }
+            }
+
+            start = std::chrono::steady_clock::now();
+            tangentVertices = 0;
+            for (Mesh &mesh : meshes)
+            {
+                MeshNormals::GenerateTangents(mesh.vertices, mesh.indices, mesh.tangents, ThreadPool::Shared());
+                tangentVertices += mesh.vertices.size();
+            }
+            tangentMs = std::min(tangentMs, millisecondsSince(start));
+        }
+        model.Delete();
+
+        printf("%-48s %9zu triangles: normals %9.1f ms -> %9.1f ms (%.1fx, %u threads), worst deviation %.3f deg, "
+               "+%zu vertices at creases; tangents %9.1f ms (+%zu vertices at UV mirrors)\n",
+               path.c_str(), triangles, referenceMs, generatedMs, referenceMs / std::max(generatedMs, 1e-3),
+               ThreadPool::Shared().Size(), worstDegrees, splitVertices, tangentMs,
+               tangentVertices - vertices - splitVertices);
+    }
+
+    // Distinct copies of the shipped textures, so per-path sharing does not
+    // collapse them into one decode
+    std::vector<std::string> writeTextureCopies(size_t count)
+    {
+        const char *sources[] = {"textures/desk.jpeg", "textures/podium_top.jpeg", "textures/podium_bottom.jpeg"};
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < count; i++)
+        {
+            std::ifstream in(sources[i % 3], std::ios::binary);
+            std::string path = "/tmp/classroom_texture_" + std::to_string(i) + ".jpeg";
+            std::ofstream out(path, std::ios::binary);
+            out << in.rdbuf();
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    void benchmarkTextures(const std::vector<std::string> &paths, int runs)
+    {
+        // The old startup path: decode and upload one texture after the other
+        double serialMs = 1e30;
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string &path : paths)
+            {
+                Texture texture(path.c_str());
+                texture.Delete();
+            }
+            serialMs = std::min(serialMs, millisecondsSince(start));
+        }
+        printf("%zu textures, serial decode + upload: %9.1f ms\n", paths.size(), serialMs);
+
+        unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int threads = 1; threads <= std::max(cores, 8u); threads *= 2)
+        {
+            ThreadPool pool(threads);
+            double decodeMs = 1e30, uploadMs = 1e30;
+            for (int run = 0; run < runs; run++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                std::vector<TextureImage> images = Texture::DecodeAll(paths, pool);
+                decodeMs = std::min(decodeMs, millisecondsSince(start));
+
+                start = std::chrono::steady_clock::now();
+                for (TextureImage &image : images)
+                {
+                    Texture texture(image);
+                    texture.Delete();
+                    image.Free();
+                }
+                glFinish();
+                uploadMs = std::min(uploadMs, millisecondsSince(start));
+            }
+            printf("    %2u threads: decode %9.1f ms, staged upload %9.1f ms, total %9.1f ms (%.2fx)\n", threads, decodeMs,
+                   uploadMs, decodeMs + uploadMs, serialMs / std::max(decodeMs + uploadMs, 1e-3));
+        }
+    }
+
+    // One 2x2 quad per texture, 3 units apart along x and facing +z
+    std::string writeTexturedRow(const std::vector<std::string> &textures)
+    {
+        std::string path = "/tmp/classroom_texture_row.obj";
+        FILE *obj = fopen(path.c_str(), "w");
+        FILE *mtl = fopen("/tmp/classroom_texture_row.mtl", "w");
+        if (!obj || !mtl)
+        {
+            if (obj)
+                fclose(obj);
+            if (mtl)
+                fclose(mtl);
+            return path;
+        }
+
+        fprintf(obj, "mtllib classroom_texture_row.mtl\nvn 0 0 1\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n");
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            float x = i * 3.0f;
+            fprintf(mtl, "newmtl Texture%zu\nKd 1 1 1\nmap_Kd %s\n", i, textures[i].c_str());
+            fprintf(obj, "o Quad%zu\nv %.1f -1 0\nv %.1f -1 0\nv %.1f 1 0\nv %.1f 1 0\nusemtl Texture%zu\n", i, x - 1.0f,
+                    x + 1.0f, x + 1.0f, x - 1.0f, i);
+            size_t v = i * 4;
+            fprintf(obj, "f %zu/1/1 %zu/2/1 %zu/3/1 %zu/4/1\n", v + 1, v + 2, v + 3, v + 4);
+        }
+        fclose(obj);
+        fclose(mtl);
+        return path;
+    }
+
+    void benchmarkShaders(int runs)
+    {
+        // The programs main.cpp creates, with the variants it prepares
+        struct Program
+        {
+            const char *vertexFile, *fragmentFile;
+            std::vector<unsigned int> variants;
+        };
+        const Program programs[] = {
+            {"shaders/default.vert", "shaders/default.frag",
+             {ShaderVariants::FLOOR, ShaderVariants::CEILING, ShaderVariants::WALL, ShaderVariants::BOARD}},
+            {"shaders/texture.vert", "shaders/texture.frag",
+             {0, ShaderVariants::TEXTURED, ShaderVariants::TEXTURE_ARRAY, ShaderVariants::WHITE_PLASTIC}},
+            {"shaders/emissive.vert", "shaders/emissive.frag", {0}},
+            {"shaders/overdraw.vert", "shaders/overdraw.frag", {0}}};
+        if (!ProgramCache::Supported())
+            printf("this driver offers no program binary formats; every start compiles\n");
+
+        for (int run = 0; run <= runs; run++)
+        {
+            // Run 0 starts cold, the others find the binaries it saved
+            if (run == 0)
+                ProgramCache::Clear();
+            ProgramCache::ResetStats();
+            for (const Program &program : programs)
+            {
+                ShaderVariants variants(program.vertexFile, program.fragmentFile);
+                variants.Prepare(program.variants);
+                variants.Delete();
+            }
+            ProgramCache::Stats stats = ProgramCache::GetStats();
+            printf("%s: %zu programs in %8.2f ms, %zu from cached binaries, %zu binaries rejected\n",
+                   run == 0 ? "cold" : "warm", stats.programs, stats.milliseconds, stats.loaded, stats.rejected);
+        }
+    }
+
+    void benchmarkStreaming(const std::vector<std::string> &textures, size_t budgetMB)
+    {
+        TextureStreamer &streamer = TextureStreamer::Shared();
+        streamer.Enable(budgetMB << 20, ThreadPool::Shared());
+
+        ModelLoadOptions options;
+        options.useCache = false;
+        Model model(writeTexturedRow(textures).c_str(), options);
+        ShaderVariants shaders("shaders/texture.vert", "shaders/texture.frag");
+
+        size_t fullBytes = 0;
+        for (const Mesh &mesh : model.meshes)
+        {
+            const Texture *texture = mesh.material ? mesh.material->diffuseMap : nullptr;
+            if (texture)
+                fullBytes += size_t(texture->width) * texture->height * texture->nrChannels * 4 / 3;
+        }
+        printf("%zu textures, %zu MB with all levels resident, budget %zu MB, %zu KB resident after load\n",
+               textures.size(), fullBytes >> 20, budgetMB, streamer.GetStats().residentBytes / 1024);
+
+        // Two units in front of the row, looking at it; each position runs
+        // frames until the streamer has nothing left in flight
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 500.0f);
+        float rowEnd = (textures.size() - 1) * 3.0f;
+        size_t positions = 0, settledAtTarget = 0, frames = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (float x = -3.0f; x <= rowEnd + 3.0f; x += 1.5f)
+        {
+            glm::vec3 eye(x, 0.0f, 2.0f);
+            glm::mat4 view = glm::lookAt(eye, eye - glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            TextureStreamer::Stats stats;
+            for (int frame = 0; frame < 500; frame++)
+            {
+                model.Draw(shaders, glm::mat4(1.0f), view, projection);
+                streamer.Update();
+                frames++;
+                stats = streamer.GetStats();
+                if (frame > 0 && stats.loadsInFlight == 0)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            positions++;
+            settledAtTarget += stats.texturesAtTarget == stats.texturesVisible;
+            if (positions % 16 == 1)
+                printf("    camera x %6.1f: %6zu KB resident, %2zu of %2zu visible at target, %5zu levels uploaded, "
+                       "%5zu evicted\n", x, stats.residentBytes / 1024, stats.texturesAtTarget, stats.texturesVisible,
+                       stats.levelsUploaded, stats.levelsEvicted);
+        }
+
+        TextureStreamer::Stats stats = streamer.GetStats();
+        printf("%zu camera positions in %.0f ms (%zu frames): all visible textures at target in %zu, peak %zu KB "
+               "resident of %zu KB budget, %zu levels (%zu MB) uploaded, %zu evicted\n",
+               positions, millisecondsSince(start), frames, settledAtTarget, stats.peakResidentBytes / 1024,
+               stats.budgetBytes / 1024, stats.levelsUploaded, stats.bytesUploaded >> 20, stats.levelsEvicted);
+
+        shaders.Delete();
+        model.Delete();
+        streamer.Delete();
+    }
+
+    void benchmarkLod(const std::string &path, int runs)
+    {
+        double plainMs = 1e30, lodMs = 1e30;
+        for (int run = 0; run < runs; run++)
+        {
+            ModelLoadOptions options;
+            options.useCache = false;
+            options.generateLods = false;
+
+            auto start = std::chrono::steady_clock::now();
+            Model plain(path.c_str(), options);
+            plainMs = std::min(plainMs, millisecondsSince(start));
+            plain.Delete();
+
+            options.generateLods = true;
+            start = std::chrono::steady_clock::now();
+            Model withLods(path.c_str(), options);
+            lodMs = std::min(lodMs, millisecondsSince(start));
+            withLods.Delete();
+        }
+
+        ModelLoadOptions options;
+        options.useCache = false;
+        Model model(path.c_str(), options);
+
+        std::vector<size_t> levels = model.LodTriangleCounts();
+        if (levels.empty())
+        {
+            printf("%-48s no meshes\n", path.c_str());
+            return;
+        }
+        std::vector<float> errors(levels.size(), 0.0f);
+        glm::vec3 lower(1e30f), upper(-1e30f);
+        for (const Mesh &mesh : model.meshes)
+        {
+            for (size_t i = 0; i < mesh.lods.size(); i++)
+                errors[i + 1] = std::max(errors[i + 1], mesh.lods[i].error);
+            lower = glm::min(lower, mesh.boundsCenter - glm::vec3(mesh.boundsRadius));
+            upper = glm::max(upper, mesh.boundsCenter + glm::vec3(mesh.boundsRadius));
+        }
+        glm::vec3 center = (lower + upper) * 0.5f;
+        float radius = std::max(glm::length(upper - lower) * 0.5f, 1e-3f);
+
+        printf("%-48s load %9.1f ms -> %9.1f ms with LODs\n", path.c_str(), plainMs, lodMs);
+        for (size_t level = 0; level < levels.size(); level++)
+            printf("    level %zu: %9zu triangles, max error %.4f (%.2f%% of radius)\n",
+                   level, levels[level], errors[level], 100.0f * errors[level] / radius);
+
+        // What Draw() submits from further and further away, 1200px viewport
+        ShaderVariants shaders("shaders/texture.vert", "shaders/texture.frag");
+        glViewport(0, 0, window::width, window::height);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, radius * 1000.0f);
+        const float distances[] = {2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f};
+        for (float distance : distances)
+        {
+            glm::vec3 eye = center + glm::vec3(0.0f, 0.0f, radius * distance);
+            glm::mat4 view = glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+            model.trianglesDrawn = 0;
+            model.Draw(shaders, glm::mat4(1.0f), view, projection);
+            printf("    at %5.0f radii: %9zu triangles drawn (%.0f%%)\n", distance, model.trianglesDrawn,
+                   100.0 * model.trianglesDrawn / std::max<size_t>(levels[0], 1));
+        }
+        shaders.Delete();
+        model.Delete();
+    }
+
+    void benchmarkResources(const std::vector<std::string> &files)
+    {
+        ModelLoadOptions options;
+        std::vector<Model *> models;
+        for (const std::string &file : files)
+            models.push_back(ResourceCache::Shared().AcquireModel(file.c_str(), options));
+
+        // Second requests for the same paths, written differently where possible
+        ModelLoader loader;
+        for (const std::string &file : files)
+        {
+            std::string alias = file[0] == '/' ? file : "./" + file;
+            models.push_back(loader.Request(alias.c_str(), options));
+        }
+        while (!loader.Done())
+            loader.ProcessUploads(4.0);
+
+        bool shared = true;
+        for (size_t i = 0; i < files.size(); i++)
+            shared = shared && models[i] == models[files.size() + i];
+        printf("second requests %s\n", shared ? "returned the resident models" : "LOADED COPIES");
+        ResourceCache::Shared().Report();
+
+        for (Model *model : models)
+            ResourceCache::Shared().Release(model);
+        printf("after releasing every reference:\n");
+        ResourceCache::Shared().Report();
+    }
+
+    void benchmarkDrawCalls(const std::string &path)
+    {
+        ShaderVariants shaders("shaders/texture.vert", "shaders/texture.frag");
+        glm::mat4 view = glm::lookAt(glm::vec3(-10.0f, 3.0f, 2.0f), glm::vec3(0.0f, 3.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+
+        auto gridTransforms = [](int rows, int cols)
+        {
+            std::vector<glm::mat4> transforms;
+            for (int row = 0; row < rows; row++)
+            {
+                for (int col = 0; col < cols; col++)
+                {
+                    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(col * 5.0f, 1.6f, row * 3.5f));
+                    transforms.push_back(glm::scale(transform, glm::vec3(furniture::deskScale)));
+                }
+            }
+            return transforms;
+        };
+        std::vector<glm::mat4> grid = gridTransforms(furniture::rows, furniture::cols);
+        std::vector<glm::mat4> largeGrid = gridTransforms(20, 20);
+
+        std::vector<glm::vec2> spins(largeGrid.size());
+        for (size_t i = 0; i < spins.size(); i++)
+            spins[i] = glm::vec2(2.0f, i / 8.0f);
+
+        // Per-mesh buffers, merged, instanced; then instanced on the large
+        // grid, static and spinning
+        RenderStats stats[5];
+        size_t meshCount = 0;
+        for (int merged = 0; merged < 2; merged++)
+        {
+            ModelLoadOptions options;
+            options.useCache = false;
+            options.mergeBuffers = merged == 1;
+            options.textureArrays = merged == 1;
+            Model model(path.c_str(), options);
+            meshCount = model.meshes.size();
+
+            RenderStats::Frame().Reset();
+            for (const glm::mat4 &transform : grid)
+                model.Draw(shaders, transform, view, projection);
+            stats[merged] = RenderStats::Frame();
+
+            if (merged)
+            {
+                // The second frame of each, once the instance buffer is written
+                model.DrawInstanced(shaders, grid, view, projection);
+                RenderStats::Frame().Reset();
+                model.DrawInstanced(shaders, grid, view, projection);
+                stats[2] = RenderStats::Frame();
+                model.DrawInstanced(shaders, largeGrid, view, projection);
+                RenderStats::Frame().Reset();
+                model.DrawInstanced(shaders, largeGrid, view, projection);
+                stats[3] = RenderStats::Frame();
+                model.DrawInstanced(shaders, largeGrid, spins, 0.0f, view, projection);
+                RenderStats::Frame().Reset();
+                model.DrawInstanced(shaders, largeGrid, spins, 0.25f, view, projection);
+                stats[4] = RenderStats::Frame();
+            }
+            model.Delete();
+        }
+        shaders.Delete();
+
+        printf("%-48s %3zu meshes x %d: GL calls %6zu -> %6zu (%.0f%%) -> %4zu instanced, draws %5zu -> %5zu -> %3zu, binds %5zu -> %5zu -> %3zu, uniforms %5zu -> %5zu -> %3zu\n",
+               path.c_str(), meshCount, furniture::rows * furniture::cols, stats[0].Total(), stats[1].Total(),
+               100.0 * stats[1].Total() / std::max<size_t>(stats[0].Total(), 1), stats[2].Total(), stats[0].drawCalls,
+               stats[1].drawCalls, stats[2].drawCalls, stats[0].bindCalls, stats[1].bindCalls, stats[2].bindCalls,
+               stats[0].uniformCalls, stats[1].uniformCalls, stats[2].uniformCalls);
+        printf("%-48s %3zu meshes x %zu: instanced GL calls %4zu, draws %3zu; spinning GL calls %4zu, draws %3zu\n", "",
+               meshCount, largeGrid.size(), stats[3].Total(), stats[3].drawCalls, stats[4].Total(), stats[4].drawCalls);
+    }
+
+    void benchmarkVertexStage(const std::string &path, int runs)
+    {
+        ShaderVariants shaders("shaders/texture.vert", "shaders/texture.frag");
+        FrameUniforms frame;
+        glm::vec3 eye(-10.0f, 3.0f, 2.0f);
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 3.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+        frame.SetCamera(view, projection, eye);
+        frame.Upload();
+
+        ModelLoadOptions options;
+        options.useCache = false;
+        Model model(path.c_str(), options);
+        model.lodPixelError = 0.0f;
+
+        // A one-pixel viewport leaves next to nothing to rasterize, so the
+        // time is the vertex stage's
+        GLint previousViewport[4];
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        glViewport(0, 0, 1, 1);
+        glEnable(GL_DEPTH_TEST);
+
+        auto drawGrid = [&]()
+        {
+            for (int row = 0; row < furniture::rows; row++)
+            {
+                for (int col = 0; col < furniture::cols; col++)
+                {
+                    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(col * 5.0f, 1.6f, row * 3.5f));
+                    transform = glm::scale(transform, glm::vec3(furniture::deskScale));
+                    transform = glm::rotate(transform, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                    model.Draw(shaders, transform, view, projection);
+                }
+            }
+        };
+
+        // The first frame compiles and uploads whatever the driver deferred
+        drawGrid();
+        glFinish();
+
+        const int frames = 20;
+        double bestMs = 1e30;
+        model.trianglesDrawn = 0;
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; i++)
+                drawGrid();
+            glFinish();
+            bestMs = std::min(bestMs, millisecondsSince(start) / frames);
+        }
+        size_t vertices = model.trianglesDrawn * 3 / (size_t(runs) * frames);
+
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+        model.Delete();
+        frame.Delete();
+        shaders.Delete();
+
+        printf("%-48s %3d copies: %9zu vertices per frame, %8.2f ms per frame (%.1f ns per vertex), best of %d\n",
+               path.c_str(), furniture::rows * furniture::cols, vertices, bestMs, bestMs * 1e6 / std::max<size_t>(vertices, 1),
+               runs);
+    }
+
+    void benchmarkAsync(const std::vector<std::string> &files, double budgetMs)
+    {
+        ModelLoadOptions options;
+        options.useCache = false;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Model *> models;
+        for (const std::string &file : files)
+            models.push_back(new Model(file.c_str(), options));
+        double syncMs = millisecondsSince(start);
+        for (Model *model : models)
+        {
+            model->Delete();
+            delete model;
+        }
+
+        // Each loop iteration stands in for one frame of the render loop
+        start = std::chrono::steady_clock::now();
+        ModelLoader loader;
+        std::vector<Model> targets(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+            loader.Request(targets[i], files[i].c_str(), options);
+
+        double firstFrameMs = -1.0, worstFrameMs = 0.0;
+        size_t frames = 0;
+        while (!loader.Done())
+        {
+            auto frameStart = std::chrono::steady_clock::now();
+            size_t uploads = loader.ProcessUploads(budgetMs);
+            worstFrameMs = std::max(worstFrameMs, millisecondsSince(frameStart));
+            if (firstFrameMs < 0.0)
+                firstFrameMs = millisecondsSince(start);
+            if (uploads)
+                frames++;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        double residentMs = millisecondsSince(start);
+        for (Model &model : targets)
+            model.Delete();
+
+        printf("sync:  first frame after %9.1f ms\n", syncMs);
+        printf("async: first frame after %9.1f ms, all resident after %9.1f ms (%zu upload frames, worst upload slice %.1f ms, budget %.1f ms)\n",
+               firstFrameMs, residentMs, frames, worstFrameMs, budgetMs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t syntheticFaces = 2000000;
+    int runs = 3;
+    BenchMode mode = BENCH_BOTH;
+    bool cache = false;
+    bool threads = false;
+    bool async = false;
+    bool optimize = false;
+    bool overdraw = false;
+    bool packed = false;
+    bool lod = false;
+    bool normals = false;
+    bool textures = false;
+    bool resources = false;
+    bool drawCalls = false;
+    bool streaming = false;
+    bool shaders = false;
+    bool vertexStage = false;
+    size_t budgetMB = 32;
+    const char *reportPath = nullptr;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--faces") && i + 1 < argc)
+            syntheticFaces = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--cache"))
+            cache = true;
+        else if (!strcmp(argv[i], "--threads"))
+            threads = true;
+        else if (!strcmp(argv[i], "--async"))
+            async = true;
+        else if (!strcmp(argv[i], "--optimize"))
+            optimize = true;
+        else if (!strcmp(argv[i], "--overdraw"))
+            overdraw = true;
+        else if (!strcmp(argv[i], "--packed"))
+            packed = true;
+        else if (!strcmp(argv[i], "--lod"))
+            lod = true;
+        else if (!strcmp(argv[i], "--normals"))
+            normals = true;
+        else if (!strcmp(argv[i], "--textures"))
+            textures = true;
+        else if (!strcmp(argv[i], "--resources"))
+            resources = true;
+        else if (!strcmp(argv[i], "--drawcalls"))
+            drawCalls = true;
+        else if (!strcmp(argv[i], "--streaming"))
+            streaming = true;
+        else if (!strcmp(argv[i], "--shaders"))
+            shaders = true;
+        else if (!strcmp(argv[i], "--vertex"))
+            vertexStage = true;
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc)
+            budgetMB = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--report") && i + 1 < argc)
+            reportPath = argv[++i];
+        else if (!strcmp(argv[i], "--quiet"))
+            LoadReport::Shared().SetQuiet(true);
+        else if (!strcmp(argv[i], "--only") && i + 1 < argc)
+            mode = !strcmp(argv[++i], "before") ? BENCH_BEFORE : BENCH_AFTER;
+        else
+            files.push_back(argv[i]);
+    }
+
+    if (reportPath)
+        LoadReport::Shared().SetDetailed(true);
+
+    if (files.empty() && textures)
+        files = writeTextureCopies(32);
+    else if (files.empty() && streaming)
+        files = writeTextureCopies(64);
+    else if (files.empty() && threads)
+    {
+        // 2.5M quads, i.e. 5M triangles, unless --faces says otherwise
+        bool facesGiven = false;
+        for (int i = 1; i < argc; i++)
+            facesGiven = facesGiven || !strcmp(argv[i], "--faces");
+        files.push_back(writeSyntheticOBJ(facesGiven ? syntheticFaces : 2500000));
+    }
+    else if (files.empty() && (cache || async || optimize || overdraw || packed || lod || normals || resources || drawCalls ||
+                               vertexStage))
+    {
+        // The five models main.cpp loads at startup
+        files = {"models/desk.obj", "models/classroom_fan.obj", "models/podium.obj",
+                 "models/classroom_projector.obj", "models/project_screen_rod.obj"};
+        files.push_back(writeSyntheticOBJ(syntheticFaces));
+    }
+    else if (files.empty() && !shaders)
+    {
+        files.push_back("models/classroom_fan.obj");
+        files.push_back(writeSyntheticOBJ(syntheticFaces));
+    }
+
+    // Model uploads its meshes, so a (hidden) GL context is required
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "model_bench", NULL, NULL);
+    if (!window)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK)
+    {
+        std::cout << "Failed to initialize GLEW" << std::endl;
+        return -1;
+    }
+
+    for (const std::string &file : async || resources || textures || streaming || shaders ? std::vector<std::string>() : files)
+    {
+        if (threads)
+            benchmarkThreads(file, runs);
+        else if (cache)
+            benchmarkCache(file, runs);
+        else if (optimize)
+            benchmarkOptimize(file, runs);
+        else if (overdraw)
+            benchmarkOverdraw(file);
+        else if (packed)
+            benchmarkPacked(file);
+        else if (lod)
+            benchmarkLod(file, runs);
+        else if (normals)
+            benchmarkNormals(file, runs);
+        else if (drawCalls)
+            benchmarkDrawCalls(file);
+        else if (vertexStage)
+            benchmarkVertexStage(file, runs);
+        else
+            benchmarkFile(file, runs, mode);
+    }
+
+    if (async)
+        benchmarkAsync(files, 4.0);
+    if (resources)
+        benchmarkResources(files);
+    if (textures)
+        benchmarkTextures(files, runs);
+    if (streaming)
+        benchmarkStreaming(files, budgetMB);
+    if (shaders)
+        benchmarkShaders(runs);
+
+    if (reportPath && !LoadReport::Shared().WriteJSON(reportPath))
+        std::cerr << "Failed to write load report: " << reportPath << std::endl;
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
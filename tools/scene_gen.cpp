@@ -0,0 +1,321 @@
+// Synthetic mesh generator for scaling benchmarks.
+//
+// Writes an OBJ (and its MTL) of a bumpy torus with a chosen triangle count,
+// material count, face arity and texture references, in the syntax
+// Model::loadOBJ and Model::loadMTL read, so the loader and renderer can be
+// measured on data far larger than the shipped models. Output depends only on
+// the options, so sweeps are reproducible.
+//
+//   --triangles N    triangles after triangulation (default 100000)
+//   --materials M    usemtl groups, split evenly over the faces (default 1)
+//   --arity K        3 = triangles, 4 = quads, 5+ = n-gons (default 3); the
+//                    loader fans n-gons, and from arity 6 that leaves sliver
+//                    triangles along the ring lines
+//   --texture FILE   map_Kd for the materials, repeat to cycle several; paths
+//                    are written as given, i.e. relative to the OBJ or absolute
+//   --no-uvs         write faces without vt indices
+//   --no-normals     write faces without vn indices
+//   --relative       write negative (relative) face indices
+//   --size S         outer diameter (default 2)
+//   --seed S         varies the bumps (default 1)
+//   FILE             output OBJ (default models/synthetic.obj); the MTL is
+//                    written next to it
+//
+// Build and run with scripts/scene_gen.sh. A loader sweep, for example:
+//   for n in 100000 1000000 10000000; do
+//       ./scripts/scene_gen.sh --triangles $n --materials 8 /tmp/sweep_$n.obj
+//   done
+//   ./scripts/bench.sh --cache /tmp/sweep_*.obj
+// The classroom itself scales through main's --desks/--fans/--desk-model
+// options (include/SceneConfig.h).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        size_t triangles = 100000;
+        size_t materials = 1;
+        size_t arity = 3;
+        std::vector<std::string> textures;
+        bool uvs = true;
+        bool normals = true;
+        bool relative = false;
+        float size = 2.0f;
+        unsigned int seed = 1;
+        std::string output = "models/synthetic.obj";
+    };
+
+    // Faces are laid out in bands around the tube. Each face spans `bottom`
+    // segments of one ring line and `top` segments of the next, giving
+    // bottom + top + 2 corners; lines sampled at the same resolution share
+    // their vertices.
+    struct Layout
+    {
+        size_t bottom, top;
+        size_t cells; // faces per band
+        size_t bands;
+        bool splitQuads;
+    };
+
+    struct Torus
+    {
+        float major, minor;
+        float bump, frequencyU, frequencyV, phaseU, phaseV;
+
+        void Evaluate(float u, float v, float position[3], float normal[3]) const
+        {
+            const float twoPi = 6.28318530718f;
+            float a = u * twoPi, b = v * twoPi;
+            float r = minor * (1.0f + bump * std::sin(frequencyU * a + phaseU) * std::cos(frequencyV * b + phaseV));
+            float ring = major + r * std::cos(b);
+            position[0] = ring * std::cos(a);
+            position[1] = r * std::sin(b);
+            position[2] = ring * std::sin(a);
+            normal[0] = std::cos(b) * std::cos(a);
+            normal[1] = std::sin(b);
+            normal[2] = std::cos(b) * std::sin(a);
+        }
+    };
+
+    Layout planLayout(const Options &options)
+    {
+        Layout layout;
+        layout.splitQuads = options.arity == 3;
+        size_t arity = layout.splitQuads ? 4 : options.arity;
+        layout.bottom = (arity - 1) / 2;
+        layout.top = arity - 2 - layout.bottom;
+
+        size_t trianglesPerFace = layout.splitQuads ? 2 : arity - 2;
+        size_t faces = std::max<size_t>(1, (options.triangles + trianglesPerFace - 1) / trianglesPerFace);
+        // Around the ring is about twice as long as around the tube
+        layout.cells = std::max<size_t>(1, (size_t)std::lround(std::sqrt(2.0 * faces)));
+        layout.bands = std::max<size_t>(1, (faces + layout.cells - 1) / layout.cells);
+        return layout;
+    }
+
+    bool parseArgs(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!strcmp(argv[i], "--triangles") && hasValue)
+                options.triangles = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--materials") && hasValue)
+                options.materials = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+            else if (!strcmp(argv[i], "--arity") && hasValue)
+                options.arity = std::max<size_t>(3, strtoull(argv[++i], nullptr, 10));
+            else if (!strcmp(argv[i], "--texture") && hasValue)
+                options.textures.push_back(argv[++i]);
+            else if (!strcmp(argv[i], "--no-uvs"))
+                options.uvs = false;
+            else if (!strcmp(argv[i], "--no-normals"))
+                options.normals = false;
+            else if (!strcmp(argv[i], "--relative"))
+                options.relative = true;
+            else if (!strcmp(argv[i], "--size") && hasValue)
+                options.size = std::max(0.001f, (float)atof(argv[++i]));
+            else if (!strcmp(argv[i], "--seed") && hasValue)
+                options.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+            else if (argv[i][0] == '-')
+            {
+                fprintf(stderr, "Unknown or malformed option: %s\n", argv[i]);
+                return false;
+            }
+            else
+                options.output = argv[i];
+        }
+        return true;
+    }
+
+    std::string replaceExtension(const std::string &path, const char *extension)
+    {
+        size_t slash = path.find_last_of('/');
+        size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return path + extension;
+        return path.substr(0, dot) + extension;
+    }
+
+    std::string fileName(const std::string &path)
+    {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    bool writeMTL(const std::string &path, const Options &options)
+    {
+        FILE *out = fopen(path.c_str(), "w");
+        if (!out)
+            return false;
+
+        fprintf(out, "# scene_gen materials\n");
+        for (size_t m = 0; m < options.materials; m++)
+        {
+            // Spread the diffuse colours around the hue circle
+            float hue = 6.0f * m / options.materials;
+            float r = std::min(1.0f, std::max(0.0f, std::fabs(hue - 3.0f) - 1.0f));
+            float g = std::min(1.0f, std::max(0.0f, 2.0f - std::fabs(hue - 2.0f)));
+            float b = std::min(1.0f, std::max(0.0f, 2.0f - std::fabs(hue - 4.0f)));
+
+            fprintf(out, "\nnewmtl Material_%zu\n", m);
+            fprintf(out, "Ns 250.000000\n");
+            fprintf(out, "Ka 1.000000 1.000000 1.000000\n");
+            fprintf(out, "Kd %.6f %.6f %.6f\n", 0.2f + 0.6f * r, 0.2f + 0.6f * g, 0.2f + 0.6f * b);
+            fprintf(out, "Ks 0.500000 0.500000 0.500000\n");
+            fprintf(out, "illum 2\n");
+            if (!options.textures.empty())
+                fprintf(out, "map_Kd %s\n", options.textures[m % options.textures.size()].c_str());
+        }
+
+        fclose(out);
+        return true;
+    }
+
+    // One ring line's vertices at the given segment count; returns the
+    // 1-based OBJ index of its first vertex
+    size_t writeLine(FILE *out, const Torus &torus, const Options &options, size_t line, size_t bands,
+                     size_t segments, size_t &vertexCount)
+    {
+        size_t first = vertexCount + 1;
+        float v = (float)line / bands;
+        for (size_t s = 0; s <= segments; s++)
+        {
+            float u = (float)s / segments;
+            float position[3], normal[3];
+            torus.Evaluate(u, v, position, normal);
+            fprintf(out, "v %.6f %.6f %.6f\n", position[0], position[1], position[2]);
+            if (options.uvs)
+                fprintf(out, "vt %.6f %.6f\n", u, v);
+            if (options.normals)
+                fprintf(out, "vn %.6f %.6f %.6f\n", normal[0], normal[1], normal[2]);
+        }
+        vertexCount += segments + 1;
+        return first;
+    }
+
+    void writeCorner(FILE *out, const Options &options, size_t index, size_t vertexCount)
+    {
+        // Every vertex has its own vt/vn, so the three indices match
+        long long i = options.relative ? (long long)index - (long long)vertexCount - 1 : (long long)index;
+        if (options.uvs && options.normals)
+            fprintf(out, " %lld/%lld/%lld", i, i, i);
+        else if (options.normals)
+            fprintf(out, " %lld//%lld", i, i);
+        else if (options.uvs)
+            fprintf(out, " %lld/%lld", i, i);
+        else
+            fprintf(out, " %lld", i);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+        return 1;
+
+    Layout layout = planLayout(options);
+
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    Torus torus;
+    torus.major = options.size * 0.5f / 1.35f;
+    torus.minor = torus.major * 0.35f;
+    torus.bump = 0.05f + 0.1f * unit(random);
+    torus.frequencyU = (float)(3 + random() % 6);
+    torus.frequencyV = (float)(2 + random() % 4);
+    torus.phaseU = 6.28318530718f * unit(random);
+    torus.phaseV = 6.28318530718f * unit(random);
+
+    std::string mtlPath = replaceExtension(options.output, ".mtl");
+    if (!writeMTL(mtlPath, options))
+    {
+        fprintf(stderr, "Failed to write %s\n", mtlPath.c_str());
+        return 1;
+    }
+
+    FILE *out = fopen(options.output.c_str(), "w");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+        return 1;
+    }
+    std::vector<char> buffer(1 << 20);
+    setvbuf(out, buffer.data(), _IOFBF, buffer.size());
+
+    fprintf(out, "# scene_gen --triangles %zu --materials %zu --arity %zu --seed %u\n", options.triangles,
+            options.materials, options.arity, options.seed);
+    fprintf(out, "mtllib %s\no Synthetic\n", fileName(mtlPath).c_str());
+
+    // Ring lines first, at each resolution a band needs
+    size_t bottomSegments = layout.cells * layout.bottom, topSegments = layout.cells * layout.top;
+    std::vector<size_t> bottomLine(layout.bands + 1), topLine(layout.bands + 1);
+    size_t vertexCount = 0;
+    for (size_t line = 0; line <= layout.bands; line++)
+    {
+        if (line < layout.bands)
+            bottomLine[line] = writeLine(out, torus, options, line, layout.bands, bottomSegments, vertexCount);
+        if (line > 0)
+            topLine[line] = topSegments == bottomSegments && line < layout.bands
+                                ? bottomLine[line]
+                                : writeLine(out, torus, options, line, layout.bands, topSegments, vertexCount);
+    }
+
+    size_t faceCount = layout.cells * layout.bands, face = 0, triangles = 0;
+    size_t material = 0, nextMaterialFace = 0;
+    std::vector<size_t> corners;
+    for (size_t band = 0; band < layout.bands; band++)
+    {
+        for (size_t cell = 0; cell < layout.cells; cell++, face++)
+        {
+            if (face == nextMaterialFace && material < options.materials)
+            {
+                fprintf(out, "usemtl Material_%zu\n", material++);
+                nextMaterialFace = faceCount * material / options.materials;
+            }
+
+            // Counter-clockwise seen from outside: along the lower line, back along the upper
+            corners.clear();
+            for (size_t s = 0; s <= layout.bottom; s++)
+                corners.push_back(bottomLine[band] + cell * layout.bottom + s);
+            for (size_t s = layout.top + 1; s-- > 0;)
+                corners.push_back(topLine[band + 1] + cell * layout.top + s);
+
+            if (layout.splitQuads)
+            {
+                const size_t split[2][3] = {{0, 3, 2}, {0, 2, 1}};
+                for (const size_t *triangle : split)
+                {
+                    fprintf(out, "f");
+                    for (int k = 0; k < 3; k++)
+                        writeCorner(out, options, corners[triangle[k]], vertexCount);
+                    fprintf(out, "\n");
+                }
+                triangles += 2;
+                continue;
+            }
+
+            fprintf(out, "f");
+            for (size_t k = corners.size(); k-- > 0;)
+                writeCorner(out, options, corners[k], vertexCount);
+            fprintf(out, "\n");
+            triangles += corners.size() - 2;
+        }
+    }
+
+    fclose(out);
+    printf("Wrote %s: %zu vertices, %zu faces of arity %zu (%zu triangles), %zu materials%s\n",
+           options.output.c_str(), vertexCount, layout.splitQuads ? faceCount * 2 : faceCount,
+           layout.splitQuads ? (size_t)3 : options.arity, triangles, options.materials,
+           options.textures.empty() ? "" : ", textured");
+    return 0;
+}
@@ -0,0 +1,376 @@
+// Offline texture bake.
+//
+// Decodes each image once, builds its full mip chain on the CPU (2x2 box
+// filter, the same average glGenerateMipmap takes) and writes it as
+// "<image>.ktx" next to the source (layout in include/KtxFile.h). Texture
+// picks the bake up automatically while it matches the source's content hash,
+// so a launch neither decodes the image nor generates mipmaps.
+//
+//   --format bc      block compress (default): S3TC DXT1 for opaque images,
+//                    DXT5 when any alpha is below 255; 4 or 8 bits per pixel
+//   --format raw     keep 8 bits per channel, mips only
+//   --force          rebake images whose bake is already current (needed
+//                    to switch an existing bake to the other format)
+//   FILE...          images to bake (default: every .jpeg, .jpg and .png in
+//                    textures/)
+//
+// Single-channel images always stay raw: S3TC has no one-channel format.
+// Images are flipped vertically on load exactly like Texture::Decode, so
+// baked and decoded textures sample identically.
+//
+// Build and run with scripts/texture_bake.sh.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+#include "KtxFile.h"
+#include "MappedFile.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+namespace
+{
+    struct Image
+    {
+        std::vector<unsigned char> pixels;
+        int width, height, channels;
+    };
+
+    // One level down: each texel averages the (up to) 2x2 texels it covers
+    Image halve(const Image &image)
+    {
+        Image half;
+        half.width = std::max(1, image.width / 2);
+        half.height = std::max(1, image.height / 2);
+        half.channels = image.channels;
+        half.pixels.resize((size_t)half.width * half.height * half.channels);
+
+        for (int y = 0; y < half.height; y++)
+        {
+            int y0 = std::min(y * 2, image.height - 1), y1 = std::min(y * 2 + 1, image.height - 1);
+            for (int x = 0; x < half.width; x++)
+            {
+                int x0 = std::min(x * 2, image.width - 1), x1 = std::min(x * 2 + 1, image.width - 1);
+                for (int c = 0; c < image.channels; c++)
+                {
+                    int sum = image.pixels[((size_t)y0 * image.width + x0) * image.channels + c] +
+                              image.pixels[((size_t)y0 * image.width + x1) * image.channels + c] +
+                              image.pixels[((size_t)y1 * image.width + x0) * image.channels + c] +
+                              image.pixels[((size_t)y1 * image.width + x1) * image.channels + c];
+                    half.pixels[((size_t)y * half.width + x) * half.channels + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        return half;
+    }
+
+    // Rows padded to 4 bytes, as KTX and GL's default unpack alignment expect
+    std::vector<unsigned char> rawLevel(const Image &image)
+    {
+        size_t row = (size_t)image.width * image.channels;
+        size_t stride = (row + 3) & ~(size_t)3;
+        std::vector<unsigned char> bytes(stride * image.height, 0);
+        for (int y = 0; y < image.height; y++)
+            memcpy(&bytes[y * stride], &image.pixels[y * row], row);
+        return bytes;
+    }
+
+    uint16_t to565(const int *color)
+    {
+        return (uint16_t)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+    }
+
+    void from565(uint16_t packed, int *color)
+    {
+        int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // DXT1 color block for 16 RGBA texels, always in four-color mode
+    void encodeColorBlock(const unsigned char block[16][4], unsigned char *out)
+    {
+        // Endpoints on the diagonal of the bounding box the colors spread along
+        int low[3] = {255, 255, 255}, high[3] = {0, 0, 0}, mean[3] = {0, 0, 0};
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                low[c] = std::min(low[c], (int)block[i][c]);
+                high[c] = std::max(high[c], (int)block[i][c]);
+                mean[c] += block[i][c];
+            }
+        }
+        int covarianceG = 0, covarianceB = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            int r = block[i][0] * 16 - mean[0];
+            covarianceG += r * (block[i][1] * 16 - mean[1]);
+            covarianceB += r * (block[i][2] * 16 - mean[2]);
+        }
+        if (covarianceG < 0)
+            std::swap(low[1], high[1]);
+        if (covarianceB < 0)
+            std::swap(low[2], high[2]);
+
+        // Inset by 1/16 of the range, as the extremes are rarely hit exactly
+        for (int c = 0; c < 3; c++)
+        {
+            int inset = (high[c] - low[c]) / 16;
+            high[c] -= inset;
+            low[c] += inset;
+        }
+
+        uint16_t c0 = to565(high), c1 = to565(low);
+        uint32_t indices = 0;
+        if (c0 < c1)
+            std::swap(c0, c1);
+        if (c0 != c1)
+        {
+            int palette[4][3];
+            from565(c0, palette[0]);
+            from565(c1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = 1 << 30;
+                for (int p = 0; p < 4; p++)
+                {
+                    int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= (uint32_t)best << (i * 2);
+            }
+        }
+
+        memcpy(out, &c0, 2);
+        memcpy(out + 2, &c1, 2);
+        memcpy(out + 4, &indices, 4);
+    }
+
+    // DXT5 alpha block, eight-value mode
+    void encodeAlphaBlock(const unsigned char block[16][4], unsigned char *out)
+    {
+        int a0 = 0, a1 = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            a0 = std::max(a0, (int)block[i][3]);
+            a1 = std::min(a1, (int)block[i][3]);
+        }
+
+        uint64_t indices = 0;
+        if (a0 != a1)
+        {
+            int palette[8] = {a0, a1};
+            for (int p = 1; p < 7; p++)
+                palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                for (int p = 1; p < 8; p++)
+                    if (std::abs(block[i][3] - palette[p]) < std::abs(block[i][3] - palette[best]))
+                        best = p;
+                indices |= (uint64_t)best << (i * 3);
+            }
+        }
+
+        out[0] = (unsigned char)a0;
+        out[1] = (unsigned char)a1;
+        for (int b = 0; b < 6; b++)
+            out[2 + b] = (unsigned char)(indices >> (b * 8));
+    }
+
+    std::vector<unsigned char> compressLevel(const Image &image, bool alpha)
+    {
+        int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+        size_t blockBytes = alpha ? 16 : 8;
+        std::vector<unsigned char> bytes((size_t)blocksX * blocksY * blockBytes);
+
+        unsigned char block[16][4];
+        for (int by = 0; by < blocksY; by++)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                // Edge blocks repeat the last row/column
+                for (int i = 0; i < 16; i++)
+                {
+                    int x = std::min(bx * 4 + i % 4, image.width - 1), y = std::min(by * 4 + i / 4, image.height - 1);
+                    const unsigned char *texel = &image.pixels[((size_t)y * image.width + x) * image.channels];
+                    for (int c = 0; c < 3; c++)
+                        block[i][c] = texel[c];
+                    block[i][3] = image.channels == 4 ? texel[3] : 255;
+                }
+
+                unsigned char *out = &bytes[((size_t)by * blocksX + bx) * blockBytes];
+                if (alpha)
+                {
+                    encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+                encodeColorBlock(block, out);
+            }
+        }
+        return bytes;
+    }
+
+    bool hasAlpha(const Image &image)
+    {
+        if (image.channels != 4)
+            return false;
+        for (size_t i = 3; i < image.pixels.size(); i += 4)
+            if (image.pixels[i] != 255)
+                return true;
+        return false;
+    }
+
+    std::vector<std::string> defaultImages()
+    {
+        std::vector<std::string> paths;
+        DIR *dir = opendir("textures");
+        if (!dir)
+            return paths;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            size_t dot = name.rfind('.');
+            std::string extension = dot == std::string::npos ? "" : name.substr(dot);
+            if (extension == ".jpeg" || extension == ".jpg" || extension == ".png")
+                paths.push_back("textures/" + name);
+        }
+        closedir(dir);
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    bool bake(const std::string &path, bool compress, bool force)
+    {
+        std::string output = KtxFile::BakedPath(path.c_str());
+        if (!force)
+        {
+            KtxFile *current = KtxFile::Open(output.c_str(), path.c_str());
+            if (current)
+            {
+                printf("%s is current\n", output.c_str());
+                current->Delete();
+                delete current;
+                return true;
+            }
+        }
+
+        MappedFile source(path.c_str());
+        if (!source.IsOpen())
+        {
+            fprintf(stderr, "Cannot read %s\n", path.c_str());
+            return false;
+        }
+
+        Image image;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char *pixels = stbi_load_from_memory((const unsigned char *)source.data, (int)source.size,
+                                                      &image.width, &image.height, &image.channels, 0);
+        if (!pixels)
+        {
+            fprintf(stderr, "Cannot decode %s: %s\n", path.c_str(), stbi_failure_reason());
+            return false;
+        }
+        // Grey + alpha has no GL base format of its own here; widen it
+        int channels = image.channels == 2 ? 4 : image.channels;
+        image.pixels.resize((size_t)image.width * image.height * channels);
+        for (size_t i = 0; i < (size_t)image.width * image.height; i++)
+        {
+            const unsigned char *texel = pixels + i * image.channels;
+            unsigned char *target = &image.pixels[i * channels];
+            if (image.channels == 2)
+            {
+                target[0] = target[1] = target[2] = texel[0];
+                target[3] = texel[1];
+            }
+            else
+                memcpy(target, texel, channels);
+        }
+        image.channels = channels;
+        stbi_image_free(pixels);
+
+        bool alpha = hasAlpha(image);
+        compress = compress && image.channels >= 3;
+        GLenum baseFormat = image.channels == 1 ? GL_RED : (image.channels == 3 || (compress && !alpha) ? GL_RGB : GL_RGBA);
+        GLenum internalFormat;
+        if (compress)
+            internalFormat = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        else
+            internalFormat = image.channels == 1 ? GL_R8 : (image.channels == 3 ? GL_RGB8 : GL_RGBA8);
+
+        std::vector<KtxFile::LevelData> levels;
+        size_t bakedBytes = 0;
+        while (true)
+        {
+            KtxFile::LevelData level;
+            level.width = image.width;
+            level.height = image.height;
+            level.bytes = compress ? compressLevel(image, alpha) : rawLevel(image);
+            bakedBytes += level.bytes.size();
+            levels.push_back(std::move(level));
+            if (image.width == 1 && image.height == 1)
+                break;
+            image = halve(image);
+        }
+
+        if (!KtxFile::Write(output.c_str(), compress ? 0 : GL_UNSIGNED_BYTE, compress ? 0 : baseFormat, internalFormat,
+                            baseFormat, levels, source.ContentHash()))
+        {
+            fprintf(stderr, "Cannot write %s\n", output.c_str());
+            return false;
+        }
+
+        size_t rawBytes = (size_t)levels[0].width * levels[0].height * channels * 4 / 3;
+        printf("%s: %dx%d, %zu levels, %s, %zu KB (%zu KB uncompressed)\n", output.c_str(), levels[0].width,
+               levels[0].height, levels.size(), compress ? (alpha ? "DXT5" : "DXT1") : "raw", bakedBytes / 1024,
+               rawBytes / 1024);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool compress = true;
+    bool force = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--format") && i + 1 < argc && (!strcmp(argv[i + 1], "bc") || !strcmp(argv[i + 1], "raw")))
+            compress = !strcmp(argv[++i], "bc");
+        else if (!strcmp(argv[i], "--force"))
+            force = true;
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "Unknown or malformed option: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--format bc|raw] [--force] [FILE...]\n", argv[0]);
+            return 1;
+        }
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+        paths = defaultImages();
+
+    bool ok = true;
+    for (const std::string &path : paths)
+        ok = bake(path, compress, force) && ok;
+    return ok ? 0 : 1;
+}